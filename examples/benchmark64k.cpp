@@ -25,7 +25,10 @@ public:
         camera->setPerspectiveProjection(90,0.1,100);
 
         material = Shader::getUnlit()->createMaterial();
-        material->setTexture(Texture::create().withFile("examples_data/test.png").withGenerateMipmaps(true).build());
+        auto texture = Texture::create().withFile("examples_data/test.png").withGenerateMipmaps(true).build();
+        material->setTexture(texture);
+        instancedMaterial = Shader::getUnlitInstanced()->createMaterial();
+        instancedMaterial->setTexture(texture);
 
         mesh = Mesh::create().withCube(0.25f).build();
 
@@ -60,6 +63,7 @@ public:
         auto renderPass = RenderPass::create()
                 .withCamera(*camera)
                 .withClearColor(true, {0, 0, 0, 1})
+                .withSortedDraws(sortedDraws)
                 .build();
         for (int i = 0; i < gridSize; ++i) {
             for (int j = 0; j < gridSize; ++j) {
@@ -68,19 +72,37 @@ public:
                     // update rotation
                     boxRef.rotationMatrix = glm::rotate(boxRef.rotationMatrix,0.02f, glm::vec3(1,1,1));
                     modelMatrix[i][j][k] = boxRef.translationMatrix * boxRef.rotationMatrix;
-                    renderPass.draw(mesh, modelMatrix[i][j][k], material);
+                    if (instanced){
+                        instanceTransforms.push_back(modelMatrix[i][j][k]);
+                    } else {
+                        renderPass.draw(mesh, modelMatrix[i][j][k], material);
+                    }
                 }
             }
         }
+        if (instanced){
+            renderPass.drawInstanced(mesh, instanceTransforms, instancedMaterial);
+            instanceTransforms.clear();
+        }
         i++;
+        // keep a smoothed frame time per mode, so both can be compared after toggling
+        float& frameTime = frameTimes[instanced ? 1 : 0];
+        frameTime = frameTime == 0 ? ImGui::GetIO().DeltaTime * 1000 : glm::mix(frameTime, ImGui::GetIO().DeltaTime * 1000, 0.05f);
         ImGui::Text("Application average %.3f ms/frame (%.1f FPS)", 1000.0f / ImGui::GetIO().Framerate, ImGui::GetIO().Framerate);
+        ImGui::Text("Frame time separate draws %.3f ms, instanced %.3f ms", frameTimes[0], frameTimes[1]);
         auto renderStats = Renderer::instance->getRenderStats();
         float bytesToMB = 1.0f/(1024*1024);
         ImGui::Text("sre draw-calls %i meshes %i (%.2fMB) textures %i (%.2fMB) shaders %i", renderStats.drawCalls,renderStats.meshCount, renderStats.meshBytes*bytesToMB, renderStats.textureCount, renderStats.textureBytes*bytesToMB, renderStats.shaderCount);
+        ImGui::Text("state changes shader %i material %i mesh %i", renderStats.stateChangesShader, renderStats.stateChangesMaterial, renderStats.stateChangesMesh);
         ImGui::SliderInt("Grid size",&gridSize,1,BOX_GRID_DIM);
+        ImGui::Checkbox("Sorted draws",&sortedDraws);
+        ImGui::Checkbox("Instanced",&instanced);
     }
 private:
     int gridSize = BOX_GRID_DIM/2;
+    bool sortedDraws = true;
+    bool instanced = true;
+    float frameTimes[2] = {0, 0};
     float eyeRadius = 30;
     float eyeRotation = 0;
     glm::vec3 eyePosition = {0, eyeRadius, 0};
@@ -88,6 +110,8 @@ private:
     Camera *camera;
     std::shared_ptr<Mesh> mesh;
     std::shared_ptr<Material> material;
+    std::shared_ptr<Material> instancedMaterial;
+    std::vector<glm::mat4> instanceTransforms;
     int i=0;
     struct Box{
         float rotate;
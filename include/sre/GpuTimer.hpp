@@ -0,0 +1,49 @@
+/*
+ *  SimpleRenderEngine (https://github.com/mortennobel/SimpleRenderEngine)
+ *
+ *  Created by Morten Nobel-Jørgensen ( http://www.nobel-joergnesen.com/ )
+ *  License: MIT
+ */
+
+#pragma once
+
+#include <cstdint>
+#include <string>
+#include <vector>
+#include "sre/impl/Export.hpp"
+
+namespace sre {
+
+    /**
+     * Measures how long the GPU spends on each render pass and on named draw groups (see RenderPass::beginGroup()).
+     * The GPU runs behind the CPU, so the times are read back a few frames later without waiting for the GPU.
+     * When the GPU falls further behind than framesInFlight frames, the results of the oldest frame are dropped instead.
+     * While the ScopeProfiler is recording, the measured times are added to it on a "GPU" track, which puts them
+     * in its timeline and Chrome trace. Not supported on WebGL.
+     */
+    class DllExport GpuTimer {
+    public:
+        struct Timing {
+            std::string name;
+            int depth;                      // Number of timings the timing is nested in
+            uint64_t start;                 // Nanoseconds on the ScopeProfiler clock (approximate, the GPU has its own clock)
+            uint64_t end;
+            float milliseconds;
+        };
+
+        static bool isSupported();
+        static bool isEnabled();
+        static void setEnabled(bool enabled);   // Start or stop measuring, takes effect from the next frame
+
+        static void begin(const std::string& name);     // Starts a timing, may be nested. Called by RenderPass.
+        static void end();                              // Ends the last started timing
+
+        static const std::vector<Timing>& getLastTimings(); // Timings of the latest frame that the GPU finished, in the order they began
+        static int getFrameLatency();                   // Frames between submitting and reading back the last timings
+
+        static const int framesInFlight = 4;
+    private:
+        static void endFrame();                         // Reads back finished frames, called by Renderer::swapWindow()
+        friend class Renderer;
+    };
+}
@@ -64,6 +64,8 @@ namespace sre {
         explicit Material(std::shared_ptr<sre::Shader> shader);
         std::string name;
         std::shared_ptr<sre::Shader> shader;
+        static uint16_t materialIdCount;
+        uint16_t materialId;
 
         template<typename T>
         struct DllExport Uniform {
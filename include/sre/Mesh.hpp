@@ -29,6 +29,7 @@ namespace sre {
      * - positions (vec3)
      * - normals (vec3)
      * - uvs (aka. texture coordinates) (vec4)
+     * Custom attributes may also use packed integer types (u8vec4), which keep vertices small.
      *
      * A mesh also has a meshType, which can be either: MeshTopology::Points, MeshTopology::Lines, or MeshTopology::Triangles
      *
@@ -36,6 +37,7 @@ namespace sre {
      * vertices is allow to change.
      *
      * Note that each mesh can have multiple index sets associated with it which allows for using multiple materials for rendering.
+     * Index sets are uploaded with 16 bit indices when possible, and with 32 bit indices when the set references vertices beyond 65535.
      */
     class DllExport Mesh : public std::enable_shared_from_this<Mesh> {
     public:
@@ -56,12 +58,16 @@ namespace sre {
             MeshBuilder& withMeshTopology(MeshTopology meshTopology);                           // Defines the meshTopology (default is Triangles)
             MeshBuilder& withIndices(const std::vector<uint16_t> &indices, MeshTopology meshTopology = MeshTopology::Triangles, int indexSet=0);
                                                                                                 // Defines the indices (if no indices defined then the vertices are rendered sequeantial)
+            MeshBuilder& withIndices(const std::vector<uint32_t> &indices, MeshTopology meshTopology = MeshTopology::Triangles, int indexSet=0);
+                                                                                                // Defines 32 bit indices, for meshes with more than 65536 vertices
             // custom data layout
             MeshBuilder& withAttribute(std::string name, const std::vector<float> &values);       // Set a named vertex attribute of float
             MeshBuilder& withAttribute(std::string name, const std::vector<glm::vec2> &values);   // Set a named vertex attribute of vec2
             MeshBuilder& withAttribute(std::string name, const std::vector<glm::vec3> &values);   // Set a named vertex attribute of vec3
             MeshBuilder& withAttribute(std::string name, const std::vector<glm::vec4> &values);   // Set a named vertex attribute of vec4
             MeshBuilder& withAttribute(std::string name, const std::vector<glm::i32vec4> &values);// Set a named vertex attribute of i32vec4
+            MeshBuilder& withAttribute(std::string name, const std::vector<glm::u8vec4> &values, bool normalized = false);
+                                                                                                  // Set a named vertex attribute of u8vec4. Read as uvec4 in the shader, or as vec4 in [0;1] when normalized
 
             // other
             MeshBuilder& withName(const std::string& name);                                       // Defines the name of the mesh
@@ -75,8 +81,10 @@ namespace sre {
             std::map<std::string,std::vector<glm::vec3>> attributesVec3;
             std::map<std::string,std::vector<glm::vec4>> attributesVec4;
             std::map<std::string,std::vector<glm::i32vec4>> attributesIVec4;
+            std::map<std::string,std::vector<glm::u8vec4>> attributesU8Vec4;
+            std::map<std::string,bool> attributesNormalized;
             std::vector<MeshTopology> meshTopology = {MeshTopology::Triangles};
-            std::vector<std::vector<uint16_t>> indices;
+            std::vector<std::vector<uint32_t>> indices;
             Mesh *updateMesh = nullptr;
             std::string name;
             friend class Mesh;
@@ -85,6 +93,9 @@ namespace sre {
 
         static MeshBuilder create();                                // Create Mesh using the builder pattern. (Must end with build()).
         MeshBuilder update();                                       // Update the mesh using the builder pattern. (Must end with build()).
+        void updateAttributes(int firstVertex, const std::map<std::string,std::vector<glm::u8vec4>>& values);
+                                                                    // Replaces packed vertex attributes from firstVertex on and uploads only those vertices.
+                                                                    // The vertex count stays the same, so the values must fit within the existing vertices.
 
         int getVertexCount();                                       // Number of vertices in mesh
 
@@ -96,11 +107,12 @@ namespace sre {
 
         int getIndexSets();                                         // Return the number of index sets
         MeshTopology getMeshTopology(int indexSet=0);               // Mesh topology used
-        const std::vector<uint16_t>& getIndices(int indexSet=0);    // Indices used in the mesh
+        const std::vector<uint32_t>& getIndices(int indexSet=0);    // Indices used in the mesh
         int getIndicesSize(int indexSet=0);                         // Return the size of the index set
+        int getIndexBytes(int indexSet=0);                          // Size of a single index on the GPU, 2 when all indices of the set fit in 16 bit, otherwise 4
 
         template<typename T>
-        inline T get(std::string attributeName);                    // Get the vertex attribute of a given type. Type must be float,glm::vec2,glm::vec3,glm::vec4,glm::i32vec4
+        inline T get(std::string attributeName);                    // Get the vertex attribute of a given type. Type must be float,glm::vec2,glm::vec3,glm::vec4,glm::i32vec4,glm::u8vec4
 
         std::pair<int,int> getType(const std::string& name);        // return element type, element count
 
@@ -117,12 +129,13 @@ namespace sre {
             int elementCount;
             int dataType;      //
             int attributeType; // GL_BYTE, GL_UNSIGNED_BYTE, GL_SHORT, GL_UNSIGNED_SHORT, GL_INT, GL_UNSIGNED_INT
+            bool normalized;   // integer data converted to [0;1] floats instead of read as integers
             int enabledAttributes[10];
             int disabledAttributes[10];
         };
 
-        Mesh       (std::map<std::string,std::vector<float>>& attributesFloat, std::map<std::string,std::vector<glm::vec2>>& attributesVec2, std::map<std::string, std::vector<glm::vec3>>& attributesVec3, std::map<std::string,std::vector<glm::vec4>>& attributesVec4,std::map<std::string,std::vector<glm::i32vec4>>& attributesIVec4, const std::vector<std::vector<uint16_t>> &indices, std::vector<MeshTopology> meshTopology,std::string name,RenderStats& renderStats);
-        void update(std::map<std::string,std::vector<float>>& attributesFloat, std::map<std::string,std::vector<glm::vec2>>& attributesVec2, std::map<std::string, std::vector<glm::vec3>>& attributesVec3, std::map<std::string,std::vector<glm::vec4>>& attributesVec4,std::map<std::string,std::vector<glm::i32vec4>>& attributesIVec4, const std::vector<std::vector<uint16_t>> &indices, std::vector<MeshTopology> meshTopology,std::string name,RenderStats& renderStats);
+        Mesh       (std::map<std::string,std::vector<float>>& attributesFloat, std::map<std::string,std::vector<glm::vec2>>& attributesVec2, std::map<std::string, std::vector<glm::vec3>>& attributesVec3, std::map<std::string,std::vector<glm::vec4>>& attributesVec4,std::map<std::string,std::vector<glm::i32vec4>>& attributesIVec4,std::map<std::string,std::vector<glm::u8vec4>>& attributesU8Vec4,std::map<std::string,bool>& attributesNormalized, const std::vector<std::vector<uint32_t>> &indices, std::vector<MeshTopology> meshTopology,std::string name,RenderStats& renderStats);
+        void update(std::map<std::string,std::vector<float>>& attributesFloat, std::map<std::string,std::vector<glm::vec2>>& attributesVec2, std::map<std::string, std::vector<glm::vec3>>& attributesVec3, std::map<std::string,std::vector<glm::vec4>>& attributesVec4,std::map<std::string,std::vector<glm::i32vec4>>& attributesIVec4,std::map<std::string,std::vector<glm::u8vec4>>& attributesU8Vec4,std::map<std::string,bool>& attributesNormalized, const std::vector<std::vector<uint32_t>> &indices, std::vector<MeshTopology> meshTopology,std::string name,RenderStats& renderStats);
 
         int totalBytesPerVertex = 0;
         static uint16_t meshIdCount;
@@ -142,8 +155,11 @@ namespace sre {
         std::map<std::string,std::vector<glm::vec3>> attributesVec3;
         std::map<std::string,std::vector<glm::vec4>> attributesVec4;
         std::map<std::string,std::vector<glm::i32vec4>> attributesIVec4;
+        std::map<std::string,std::vector<glm::u8vec4>> attributesU8Vec4;
+        std::map<std::string,bool> attributesNormalized;
 
-        std::vector<std::vector<uint16_t>> indices;
+        std::vector<std::vector<uint32_t>> indices;
+        std::vector<unsigned int> indexTypes;   // GL_UNSIGNED_SHORT or GL_UNSIGNED_INT for each index set
 
         std::array<glm::vec3,2> boundsMinMax;
 
@@ -177,4 +193,9 @@ namespace sre {
     inline const std::vector<glm::i32vec4>& Mesh::get(std::string uniformName) {
         return attributesIVec4[uniformName];
     }
+
+    template<>
+    inline const std::vector<glm::u8vec4>& Mesh::get(std::string uniformName) {
+        return attributesU8Vec4[uniformName];
+    }
 }
\ No newline at end of file
@@ -12,6 +12,7 @@
 #include "sre/RenderStats.hpp"
 #include "sre/Framebuffer.hpp"
 #include "sre/WorldLights.hpp"
+#include "sre/ScopeProfiler.hpp"
 
 namespace sre {
     // forward declarations
@@ -29,6 +30,7 @@ namespace sre {
      * The profiler measures resources used by SimpleRenderEngine.
      * Profiler.update() records the current state and must be called each frame.
      * Profiler.gui() draws gui. Must be called within a RenderPass with GUI enabled.
+     * While the ScopeProfiler is recording, the scopes of each of the last frames can be inspected as a timeline.
      */
     class Profiler {
     public:
@@ -46,10 +48,17 @@ namespace sre {
         int frames;
         int frameCount;
         std::vector<float> milliseconds;
+        std::vector<float> gpuMilliseconds;         // GPU time of the timings read back in each frame
         std::vector<RenderStats> stats;
 
         std::vector<float> data;
 
+        std::vector<uint64_t> frameStarts;          // ScopeProfiler time at the start of each recorded frame
+        int scopeFrameCount = 0;                    // Frames recorded by the ScopeProfiler
+        int selectedScopeFrame = 1;                 // Frames back from the current frame shown in the timeline
+        std::vector<ScopeProfiler::Event> scopeEvents;
+        std::string traceMessage;
+
         float time;
 
         std::chrono::time_point<std::chrono::high_resolution_clock> lastTick;
@@ -63,6 +72,12 @@ namespace sre {
 
         void showSpriteAtlas(SpriteAtlas *pAtlas);
 
+        void showScopes();
+
+        void showGpuTimings();
+
+        void showScopeTimeline(uint64_t start, uint64_t end);
+
         WorldLights worldLights;
 
         void initFramebuffer();
@@ -23,6 +23,12 @@ namespace sre {
     class RenderStats;
     class Framebuffer;
 
+    // Part of a mesh drawn by RenderPass::drawRanges
+    struct MeshRange {
+        int indexCount;     // Number of indices drawn from the start of the first index set
+        int baseVertex;     // Added to every index, selects where in the vertex buffer the range starts
+    };
+
     // A render pass encapsulates some render states and allows adding draw-calls.
     // Materials and shaders are assumed not to be modified during a renderpass.
     // Note that only one render pass object can be active at a time.
@@ -46,6 +52,12 @@ namespace sre {
             RenderPassBuilder& withGUI(bool enabled = true);                                       // Allows ImGui calls to be called in the renderpass and
                                                                                                    // calls ImGui::Render() in the end of the renderpass
 
+            RenderPassBuilder& withSortedDraws(bool enabled = true);                               // Records draw calls and submits them when the renderpass
+                                                                                                   // finishes, sorted by shader, material, mesh and depth to
+                                                                                                   // minimize state changes. Opaque draws go front to back and
+                                                                                                   // blended draws back to front after them.
+                                                                                                   // Default: disabled
+
             RenderPassBuilder& withFramebuffer(std::shared_ptr<Framebuffer> framebuffer);
             RenderPass build();
         private:
@@ -67,6 +79,7 @@ namespace sre {
             int clearStencilValue = 0;
 
             bool gui = true;
+            bool sortedDraws = false;
 
             explicit RenderPassBuilder(RenderStats* renderStats);
             friend class RenderPass;
@@ -93,6 +106,20 @@ namespace sre {
                   glm::mat4 modelTransform,                             // The modelTransform defines the modelToWorld transformation
                   std::vector<std::shared_ptr<Material>>& materials);   // The number of materials must match the size of index sets in the model
 
+        void drawRanges(std::shared_ptr<Mesh>& mesh,                    // Draws many ranges of a mesh sharing the first index set
+                  const std::vector<MeshRange>& ranges,                 // with a single multi draw call, so the mesh and material
+                  glm::mat4 modelTransform,                             // are only bound once. Not supported on WebGL.
+                  std::shared_ptr<Material>& material);
+        void drawInstanced(std::shared_ptr<Mesh>& mesh,                 // Draws instanceCount copies of a mesh with a single draw call.
+                  const glm::mat4* modelTransforms,                     // The material must use an instanced shader, such as
+                  int instanceCount,                                    // Shader::getStandardInstanced(), which reads the model
+                  std::shared_ptr<Material>& material);                 // transform from the "instanceTransform" attribute.
+                                                                        // Not supported on WebGL.
+
+        void drawInstanced(std::shared_ptr<Mesh>& mesh,                 // Draws a copy of a mesh for every model transform
+                  const std::vector<glm::mat4>& modelTransforms,        // with a single draw call
+                  std::shared_ptr<Material>& material);
+
         void draw(std::shared_ptr<SpriteBatch>& spriteBatch,            // Draws a spriteBatch using modelTransform
                   glm::mat4 modelTransform = glm::mat4(1));             // using a model-to-world transformation
 
@@ -104,6 +131,15 @@ namespace sre {
                                           unsigned int width = 1,
                                           unsigned int height = 1);
 
+        void addCullingStats(int visible, int culled);                  // Records how many objects the application culled before
+                                                                        // drawing, shown in the profiler
+
+        void beginGroup(const std::string& name);                      // Starts a named group of draws, measured by the GpuTimer.
+                                                                        // Groups may be nested. The draws recorded before a group
+                                                                        // begins or ends are executed first, so sorting never moves
+                                                                        // a draw across a group boundary
+        void endGroup();                                                // Ends the last started group
+
         void finishGPUCommandBuffer();                                  // GPU command buffer (must be called when
                                                                         // profiling GPU time - should not be called
                                                                         // when not profiling)
@@ -118,16 +154,46 @@ namespace sre {
         bool containsInstance(RenderPass*);
 
         void setupShader(const glm::mat4 &modelTransform, Shader *shader);
+        void bindMaterialAndMesh(Material* material, Mesh* mesh, Shader* shader, int indexSet);
+        void drawIndexSet(Mesh* mesh, const glm::mat4& modelTransform, Material* material, int indexSet);
+        void drawMeshRanges(Mesh* mesh, const MeshRange* ranges, int rangeCount, const glm::mat4& modelTransform, Material* material);
+        void drawMeshInstances(Mesh* mesh, const glm::mat4* modelTransforms, int instanceCount, Material* material);
+
+        // Draw recorded when sorted draws are enabled
+        struct DrawCommand {
+            std::shared_ptr<Mesh> mesh;
+            std::shared_ptr<Material> material;
+            glm::mat4 modelTransform;
+            int indexSet;           // Index set drawn, unused for ranges
+            int firstRange;         // First of the ranges in commandRanges, -1 when the index set is drawn
+            int rangeCount;
+            int firstInstance;      // First of the transforms in commandInstances, -1 when not instanced
+            int instanceCount;
+        };
+        struct SortItem {
+            uint64_t key;
+            uint32_t command;
+        };
+        void record(std::shared_ptr<Mesh>& mesh, const glm::mat4& modelTransform, std::shared_ptr<Material>& material, int indexSet, int firstRange = -1, int rangeCount = 0, int firstInstance = -1, int instanceCount = 0);
+        void flushCommands();   // Sorts and executes the recorded draws
+
+        std::vector<DrawCommand> commands;
+        std::vector<MeshRange> commandRanges;
+        std::vector<glm::mat4> commandInstances;
+        std::vector<SortItem> sortItems;
+        std::vector<SortItem> sortScratch;
 
         Shader* lastBoundShader = nullptr;
         Material* lastBoundMaterial = nullptr;
         int64_t lastBoundMeshId = -1;
+        int lastBoundIndexSet = -1;
 
         glm::mat4 projection;
         glm::uvec2 viewportOffset;
         glm::uvec2 viewportSize;
         RenderPass* lastInstance = nullptr;
         static RenderPass* instance;
+        static unsigned int instanceBufferId;  // Model transforms of drawInstanced, shared by all renderpasses
         static std::shared_ptr<Framebuffer> lastFramebuffer;
 
         friend class Renderer;
@@ -26,5 +26,7 @@ namespace sre {
         int stateChangesShader=0;                             // Number of state changes for shaders
         int stateChangesMaterial=0;                           // Number of state changes for materials
         int stateChangesMesh=0;                               // Number of state changes for meshes
+        int objectsVisible=0;                                 // Number of objects the application kept after culling this frame
+        int objectsCulled=0;                                  // Number of objects the application culled this frame
     };
 }
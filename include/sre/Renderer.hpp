@@ -64,6 +64,7 @@ namespace sre {
         glm::ivec2 getDrawableSize();                       // Get the size of a window's underlying drawable in pixels (for use with glViewport). May be larger than window size in case of HighDPI.
 
         bool usesVSync();                                   // Return true if vsync is enabled
+        bool setVSync(bool enabled);                        // Turn vsync on or off, returns false if the driver refused the change
 
         void swapWindow();                                  // Update window with OpenGL rendering by swapping buffers
 
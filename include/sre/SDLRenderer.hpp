@@ -33,14 +33,21 @@ class Renderer;
 //
 // The class will create a window with a graphics context in the `init()` member function.
 // The `startEventLoop()` will start the event loop, which polls the event queue in the
-// beginning of each frame (and providing callbacks to `keyEvent` and `mouseEvent`), followed by a `frameUpdate(float)`
-// and a `frameRender()`.
+// beginning of each frame (and providing callbacks to `keyEvent` and `mouseEvent`), followed by zero or more
+// `fixedUpdate(float)`, a `frameUpdate(float)` and a `frameRender()`.
+//
+// `fixedUpdate` runs at a fixed rate independent of the frame rate, which keeps simulations such as physics
+// deterministic. Rendering usually falls between two fixed updates, interpolate the simulated state with
+// `getFixedUpdateInterpolation()` to move smoothly. The frame rate is capped with `setFrameRateLimit()`,
+// the event loop sleeps instead of spinning while it waits for the next frame.
 class DllExport SDLRenderer {
 public:
     SDLRenderer();
     virtual ~SDLRenderer();
 
     // event handlers (assigned empty default handlers)
+    std::function<void(float timeStepSec)> fixedUpdate;         // Callback at the fixed update rate with the fixed time step in seconds. Called before frameUpdate,
+                                                                // as often as needed to catch up with the time that passed (but at most maxFixedUpdatesPerFrame per frame).
     std::function<void(float deltaTimeSec)> frameUpdate;        // Callback every frame with time since last callback in seconds
     std::function<void()> frameRender;                          // Callback be render events - called after frameUpdate. The `Renderer::swapFrame()` is automatically invoked after the callback.
     std::function<void(SDL_Event& e)> keyEvent;                 // Callback of `SDL_KEYDOWN` and `SDL_KEYUP`.
@@ -79,6 +86,13 @@ public:
 
     void stopEventLoop();                                       // The render loop will stop running when the frame is complete.
 
+    void setFixedUpdateRate(float updatesPerSecond);            // Rate of the fixedUpdate callback (default 60)
+    float getFixedUpdateRate();
+    float getFixedUpdateInterpolation();                        // How far the time of the current frame lies between the last and the next fixed update, in [0;1)
+
+    void setFrameRateLimit(float framesPerSecond);              // Maximum frames per second, 0 means uncapped (default 60). With vsync enabled the display paces the frames as well.
+    float getFrameRateLimit();
+
     SDL_Window *getSDLWindow();                                 // Get a pointer to SDL_Window
 private:
     void frame(float deltaTimeSec);
@@ -87,7 +101,10 @@ private:
     SDLRenderer(const SDLRenderer&) = delete;
     std::string windowTitle;
 
-    float timePerFrame = 1.0f/60;
+    float timePerFrame = 1.0f/60;                               // 0 when the frame rate is uncapped
+    float timePerFixedUpdate = 1.0f/60;
+    float fixedUpdateTime = 0;                                  // Time passed that was not simulated by a fixed update yet
+    static constexpr int maxFixedUpdatesPerFrame = 8;           // Beyond this the simulation slows down, rather than falling further behind every frame
 
     bool running = false;
     int windowWidth = 800;
@@ -0,0 +1,104 @@
+/*
+ *  SimpleRenderEngine (https://github.com/mortennobel/SimpleRenderEngine)
+ *
+ *  Created by Morten Nobel-Jørgensen ( http://www.nobel-joergnesen.com/ )
+ *  License: MIT
+ */
+
+#pragma once
+
+#include <atomic>
+#include <cstdint>
+#include <ostream>
+#include <string>
+#include <vector>
+#include "sre/impl/Export.hpp"
+
+namespace sre {
+
+    /**
+     * Records how long named scopes of code take, on any thread. Scopes are measured with the SRE_PROFILE_SCOPE macro:
+     *
+     *     void Physics::update() {
+     *         SRE_PROFILE_SCOPE("Physics::update");
+     *         ...
+     *     }
+     *
+     * Every thread writes the finished scopes to its own ring buffer without locking, so the oldest scopes are
+     * overwritten once a buffer is full. Nothing is recorded until setEnabled(true) is called, a disabled scope only
+     * checks a flag. Defining SRE_DISABLE_PROFILE_SCOPES removes the scopes from the build entirely.
+     * The Profiler shows the recorded scopes of the last frames as a timeline.
+     */
+    class DllExport ScopeProfiler {
+    public:
+        struct Event {
+            const char* name;           // Name given to the scope, must outlive the profiler (usually a string literal)
+            uint64_t start;             // Nanoseconds, see now()
+            uint64_t end;
+            int thread;                 // Index of the thread, see getThreadName()
+            int depth;                  // Number of scopes the scope was nested in on its thread
+        };
+
+        static bool isEnabled() { return enabled.load(std::memory_order_relaxed); }
+        static void setEnabled(bool enabled);   // Start or stop recording, scopes that are already open still finish
+
+        static uint64_t now();                  // Nanoseconds on a steady clock
+
+        static void setThreadName(std::string name);    // Name of the calling thread in the timeline and trace
+        static std::string getThreadName(int thread);
+        static int getThreadCount();                    // Threads that recorded a scope or were named
+
+        // Appends the recorded scopes that overlap the time from start to end, of all threads
+        static void getEvents(uint64_t start, uint64_t end, std::vector<Event>& events);
+
+        // Adds a track that is not bound to a thread, for events measured elsewhere such as on the GPU. Returns its thread index.
+        static int addTrack(std::string name);
+        // Records an event on a track. Only one thread may add to a track, in the order the events ended.
+        static void addEvent(int track, const char* name, uint64_t start, uint64_t end, int depth);
+
+        // Writes all recorded scopes as Chrome trace JSON, which can be opened in chrome://tracing or Perfetto
+        static void writeChromeTrace(std::ostream& out);
+
+        static const int eventsPerThread = 1<<16;       // Size of the ring buffer of each thread
+
+    private:
+        static void begin();
+        static void end(const char* name, uint64_t start);
+
+        static std::atomic<bool> enabled;
+
+        friend class ProfileScope;
+    };
+
+    // Measures the time from its construction to its destruction, see SRE_PROFILE_SCOPE.
+    class ProfileScope {
+    public:
+        explicit ProfileScope(const char* name)
+        :name(ScopeProfiler::isEnabled() ? name : nullptr), start(0)
+        {
+            if (this->name != nullptr){
+                ScopeProfiler::begin();
+                start = ScopeProfiler::now();
+            }
+        }
+
+        ~ProfileScope() {
+            if (name != nullptr){
+                ScopeProfiler::end(name, start);
+            }
+        }
+    private:
+        ProfileScope(const ProfileScope&) = delete;
+        const char* name;
+        uint64_t start;
+    };
+}
+
+#define SRE_PROFILE_CONCAT_(a, b) a##b
+#define SRE_PROFILE_CONCAT(a, b) SRE_PROFILE_CONCAT_(a, b)
+
+#ifdef SRE_DISABLE_PROFILE_SCOPES
+#define SRE_PROFILE_SCOPE(name)
+#else
+#define SRE_PROFILE_SCOPE(name) sre::ProfileScope SRE_PROFILE_CONCAT(sreProfileScope, __LINE__)(name)   // Measures the rest of the enclosing scope
+#endif
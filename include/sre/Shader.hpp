@@ -87,6 +87,8 @@ namespace sre {
                                       const std::string& fragmentShaderGLSL);
             ShaderBuilder& withSourceStandard();
             ShaderBuilder& withSourceUnlit();
+            ShaderBuilder& withSourceStandardInstanced();
+            ShaderBuilder& withSourceUnlitInstanced();
             ShaderBuilder& withSourceUnlitSprite();
             ShaderBuilder& withSourceStandardParticles();
             ShaderBuilder& withSourceDebugUV();
@@ -125,6 +127,14 @@ namespace sre {
                                                                // "color" vec4 (default (1,1,1,1))
                                                                // "tex" shared_ptr<Texture> (default white texture)
 
+        static std::shared_ptr<Shader> getStandardInstanced(); // Standard for RenderPass::drawInstanced.
+                                                               // Same uniforms and vertex attributes as Standard, the model
+                                                               // transform comes from the "instanceTransform" mat4 attribute
+
+        static std::shared_ptr<Shader> getUnlitInstanced();    // Unlit for RenderPass::drawInstanced.
+                                                               // Same uniforms as Unlit, the model transform comes from the
+                                                               // "instanceTransform" mat4 attribute
+
         static std::shared_ptr<Shader> getUnlitSprite();       // UnlitSprite = no depth examples and alpha blending
                                                                // Uniforms
                                                                // "color" vec4 (default (1,1,1,1))
@@ -19,6 +19,7 @@
 namespace sre{
 
     class RenderPass;
+    class TextureLoader;
 
     /**
      * Represent a texture (uploaded to the GPU).
@@ -52,6 +53,8 @@ public:
         TextureBuilder& withWrappedTextureCoordinates(bool enable);
         TextureBuilder& withFileCubemap(std::string filename, TextureCubemapSide side);     // Must define a cubemap for each side
         TextureBuilder& withFile(std::string filename);                                     // Currently only PNG files supported
+        TextureBuilder& withFileAsync(std::string filename, TextureLoader* loader);         // Loads the file in the background, the texture
+                                                                                            // is white until then. See TextureLoader
         TextureBuilder& withRGBData(const char* data, int width, int height);               // data may be null (for a uninitialized texture)
         TextureBuilder& withRGBAData(const char* data, int width, int height);              // data may be null (for a uninitialized texture)
         TextureBuilder& withWhiteData(int width=2, int height=2);
@@ -70,6 +73,8 @@ public:
         bool wrapTextureCoordinates = true;
         uint32_t target = 0;
         unsigned int textureId = 0;
+        std::string asyncFilename;
+        TextureLoader* asyncLoader = nullptr;
 
         friend class Texture;
         friend class RenderPass;
@@ -92,19 +97,27 @@ public:
     bool isCubemap();                                                                       // is cubemap texture
     bool isMipmapped();                                                                     // has texture mipmapped enabled
 	bool isTransparent();																	// Does texture has alpha channel
+    bool isLoading();                                                                       // true while a file is loaded in the background (see withFileAsync)
 
     const std::string& getName();                                                           // name of the string
 
     int getDataSize();                                                                      // get size of the texture in bytes on GPU
+
+    void updateRGBAData(const char* data, int x, int y, int width, int height);            // Overwrites a region of a 2D texture with RGBA data,
+                                                                                            // the size of the texture stays the same
 private:
     Texture(unsigned int textureId, int width, int height, uint32_t target, std::string string);
     void updateTextureSampler(bool filterSampling, bool wrapTextureCoordinates);
     void invokeGenerateMipmap();
+    void replaceStorage(unsigned int textureId, int width, int height, bool mipmapped, bool transparent);  // Swaps in a texture object loaded in the background
+    // Decodes a PNG file to rows of RGB or RGBA pixels, safe to call from any thread. Returns false if the file could not be loaded.
+    static bool decodeFile(const std::string& filename, bool invertY, std::vector<char>& pixels, int& width, int& height, int& bytesPerPixel, bool& transparent);
     int width;
     int height;
     uint32_t target;
     bool generateMipmap;
 	bool transparent;
+    bool loading = false;
     std::string name;
     bool filterSampling = true; // true = linear/trilinear sampling, false = point sampling
     bool wrapTextureCoordinates = true;
@@ -114,6 +127,7 @@ private:
     friend class Framebuffer;
     friend class RenderPass;
     friend class Profiler;
+    friend class TextureLoader;
     friend class sre::Framebuffer::FrameBufferBuilder;
 };
 
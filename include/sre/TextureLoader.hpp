@@ -0,0 +1,64 @@
+/*
+ *  SimpleRenderEngine (https://github.com/mortennobel/SimpleRenderEngine)
+ *
+ *  Created by Morten Nobel-Jørgensen ( http://www.nobel-joergnesen.com/ )
+ *  License: MIT
+ */
+
+#pragma once
+
+#include <deque>
+#include <functional>
+#include <memory>
+#include <string>
+#include <thread>
+#include "sre/impl/Export.hpp"
+
+namespace sre {
+
+    class Texture;
+
+    /**
+     * Loads texture files in the background, so loading never blocks a frame:
+     *
+     *     auto texture = Texture::create().withFileAsync("tileset.png", &textureLoader).build();
+     *
+     * The texture is white until its file is loaded. Decoding the file and creating the mipmaps happens on worker
+     * threads. The pixels are then uploaded on the render thread by update(), through a pixel buffer object and never
+     * more than the upload budget per frame. When all levels are uploaded, they replace the white texture at once, so
+     * materials that already use the texture show the loaded one.
+     */
+    class DllExport TextureLoader {
+    public:
+        using JobRunner = std::function<void(std::function<void()>)>;
+
+        explicit TextureLoader(JobRunner runJob = nullptr);     // Decodes files with runJob, such as a job pool, or on
+                                                                // its own worker thread when runJob is null
+        ~TextureLoader();                                       // Textures that are still loading stay white
+
+        void update();                                          // Uploads decoded textures, call once per frame on the render thread
+
+        void setUploadBudget(int bytesPerFrame);                // Bytes uploaded per frame. At least one row is uploaded per frame.
+        int getUploadBudget();
+        int getPendingCount();                                  // Textures that are decoding or uploading
+    private:
+        struct Request;
+        struct State;
+
+        static void decode(Request& request);                   // Decodes the file and creates the mipmaps, on a worker thread
+        static void workerLoop(std::shared_ptr<State> state);
+
+        void load(std::shared_ptr<Texture> texture, std::string filename, bool generateMipmaps, bool filterSampling, bool wrapTextureCoordinates);
+        int upload(Request& request, int budget);               // Uploads rows of the current level, returns the bytes uploaded
+        void finish(Texture& texture, Request& request);
+
+        JobRunner runJob;
+        std::shared_ptr<State> state;                           // Shared with the jobs, which may outlive the loader
+        std::thread worker;
+        std::deque<std::shared_ptr<Request>> uploads;           // Decoded, in the order they finished decoding
+        unsigned int pixelBuffer = 0;
+        int uploadBudget = 4*1024*1024;
+
+        friend class Texture;
+    };
+}
@@ -0,0 +1,183 @@
+/*
+ *  SimpleRenderEngine (https://github.com/mortennobel/SimpleRenderEngine)
+ *
+ *  Created by Morten Nobel-Jørgensen ( http://www.nobel-joergnesen.com/ )
+ *  License: MIT
+ */
+
+#include "sre/GpuTimer.hpp"
+#include <algorithm>
+#include <unordered_set>
+#include "sre/ScopeProfiler.hpp"
+#include "sre/impl/GL.hpp"
+
+namespace sre {
+    namespace {
+        // A timestamp is written when the GPU reaches the query. Unlike GL_TIME_ELAPSED queries, timestamps can be nested.
+        struct Query {
+            std::string name;
+            int depth;
+            GLuint begin;
+            GLuint end;
+        };
+
+        struct Frame {
+            std::vector<Query> queries;
+            std::vector<GLuint> queryIds;   // Kept from frame to frame, only grows
+            int usedIds = 0;
+            bool pending = false;           // Submitted, but not read back yet
+            int64_t clockOffset = 0;        // Added to the GPU time to get the ScopeProfiler time
+            int frameNumber = 0;
+        };
+
+        bool timingEnabled = false;
+        bool measuring = false;             // Enabled at the start of the current frame
+        Frame frames[GpuTimer::framesInFlight];
+        int currentFrame = 0;
+        int frameNumber = 0;
+        std::vector<int> openQueries;       // Index of the queries of the current frame that have not ended yet
+        std::vector<GpuTimer::Timing> lastTimings;
+        int lastFrameLatency = 0;
+        int gpuTrack = -1;                  // ScopeProfiler track of the timings
+        std::unordered_set<std::string> trackNames; // The ScopeProfiler keeps pointers to the names
+
+        GLuint takeQueryId(Frame& frame) {
+            if (frame.usedIds == (int)frame.queryIds.size()){
+                GLuint id;
+                glGenQueries(1, &id);
+                frame.queryIds.push_back(id);
+            }
+            return frame.queryIds[frame.usedIds++];
+        }
+
+        void readBack(Frame& frame) {
+            lastTimings.clear();
+            for (auto& query : frame.queries){
+                GLuint64 begin = 0;
+                GLuint64 end = 0;
+#ifndef EMSCRIPTEN
+                glGetQueryObjectui64v(query.begin, GL_QUERY_RESULT, &begin);
+                glGetQueryObjectui64v(query.end, GL_QUERY_RESULT, &end);
+#endif
+                uint64_t start = (uint64_t)((int64_t)begin + frame.clockOffset);
+                lastTimings.push_back({query.name, query.depth, start, start + (end - begin), (end - begin) / 1000000.0f});
+            }
+            lastFrameLatency = frameNumber - frame.frameNumber;
+
+            // The ScopeProfiler expects the events of a track in the order they ended.
+            if (ScopeProfiler::isEnabled()){
+                if (gpuTrack < 0){
+                    gpuTrack = ScopeProfiler::addTrack("GPU");
+                }
+                std::vector<const GpuTimer::Timing*> byEnd;
+                for (auto& timing : lastTimings){
+                    byEnd.push_back(&timing);
+                }
+                std::stable_sort(byEnd.begin(), byEnd.end(), [](const GpuTimer::Timing* a, const GpuTimer::Timing* b){
+                    return a->end < b->end || (a->end == b->end && a->depth > b->depth);
+                });
+                for (auto timing : byEnd){
+                    const char* name = trackNames.insert(timing->name).first->c_str();
+                    ScopeProfiler::addEvent(gpuTrack, name, timing->start, timing->end, timing->depth);
+                }
+            }
+
+            frame.queries.clear();
+            frame.usedIds = 0;
+            frame.pending = false;
+        }
+    }
+
+    bool GpuTimer::isSupported() {
+#ifdef EMSCRIPTEN
+        return false;
+#else
+        return true;
+#endif
+    }
+
+    bool GpuTimer::isEnabled() {
+        return timingEnabled;
+    }
+
+    void GpuTimer::setEnabled(bool enabled) {
+        timingEnabled = enabled && isSupported();
+    }
+
+    void GpuTimer::begin(const std::string& name) {
+        if (!measuring) return;
+#ifndef EMSCRIPTEN
+        Frame& frame = frames[currentFrame];
+        GLuint id = takeQueryId(frame);
+        glQueryCounter(id, GL_TIMESTAMP);
+        openQueries.push_back((int)frame.queries.size());
+        frame.queries.push_back({name, (int)openQueries.size() - 1, id, 0});
+#endif
+    }
+
+    void GpuTimer::end() {
+        if (!measuring || openQueries.empty()) return;
+#ifndef EMSCRIPTEN
+        Frame& frame = frames[currentFrame];
+        GLuint id = takeQueryId(frame);
+        glQueryCounter(id, GL_TIMESTAMP);
+        frame.queries[openQueries.back()].end = id;
+        openQueries.pop_back();
+#endif
+    }
+
+    const std::vector<GpuTimer::Timing>& GpuTimer::getLastTimings() {
+        return lastTimings;
+    }
+
+    int GpuTimer::getFrameLatency() {
+        return lastFrameLatency;
+    }
+
+    void GpuTimer::endFrame() {
+#ifndef EMSCRIPTEN
+        if (measuring){
+            // Timings that are still open end with the frame.
+            while (!openQueries.empty()){
+                end();
+            }
+
+            Frame& frame = frames[currentFrame];
+            if (!frame.queries.empty()){
+                // Relate the GPU clock to the CPU clock, the GPU time is taken when the commands so far reached the GPU.
+                GLint64 gpuTime;
+                glGetInteger64v(GL_TIMESTAMP, &gpuTime);
+                frame.clockOffset = (int64_t)ScopeProfiler::now() - (int64_t)gpuTime;
+                frame.frameNumber = frameNumber;
+                frame.pending = true;
+            }
+        }
+        frameNumber++;
+        currentFrame = (currentFrame + 1) % framesInFlight;
+
+        // Read back the oldest frames first, stop at the first one the GPU is still working on.
+        for (int i = 0; i < framesInFlight; i++){
+            Frame& frame = frames[(currentFrame + i) % framesInFlight];
+            if (!frame.pending){
+                continue;
+            }
+            // Timestamps are written in order, so the frame is done when its last one is.
+            GLint available = 0;
+            glGetQueryObjectiv(frame.queryIds[frame.usedIds - 1], GL_QUERY_RESULT_AVAILABLE, &available);
+            if (!available){
+                break;
+            }
+            readBack(frame);
+        }
+
+        // The GPU is too far behind to reuse the queries of the next frame, drop its timings rather than waiting.
+        Frame& next = frames[currentFrame];
+        if (next.pending){
+            next.queries.clear();
+            next.usedIds = 0;
+            next.pending = false;
+        }
+#endif
+        measuring = timingEnabled;
+    }
+}
@@ -13,10 +13,12 @@
 
 
 namespace sre {
+    uint16_t Material::materialIdCount = 0;
 
     Material::Material(std::shared_ptr<Shader> shader)
     :shader{nullptr}
     {
+        materialId = materialIdCount++;
         setShader(shader);
         name = "Undefined material";
     }
@@ -30,6 +32,7 @@ namespace sre {
             glActiveTexture(GL_TEXTURE0 + textureSlot);
             glBindTexture(t.value->target, t.value->textureId);
             glUniform1i(t.id, textureSlot);
+            textureSlot++;
         }
         for (auto t : vectorValues) {
             glUniform4fv(t.id, 1, glm::value_ptr(t.value));
@@ -13,6 +13,8 @@
 #include <iostream>
 #include <glm/gtx/string_cast.hpp>
 #include <iomanip>
+#include <cassert>
+#include <type_traits>
 #include "sre/Renderer.hpp"
 #include "sre/Shader.hpp"
 #include "sre/Log.hpp"
@@ -22,14 +24,14 @@
 namespace sre {
     uint16_t Mesh::meshIdCount = 0;
 
-    Mesh::Mesh(std::map<std::string,std::vector<float>>& attributesFloat,std::map<std::string,std::vector<glm::vec2>>& attributesVec2, std::map<std::string,std::vector<glm::vec3>>& attributesVec3,std::map<std::string,std::vector<glm::vec4>>& attributesVec4,std::map<std::string,std::vector<glm::ivec4>>& attributesIVec4, const std::vector<std::vector<uint16_t>> &indices, std::vector<MeshTopology> meshTopology, std::string name,RenderStats& renderStats)
+    Mesh::Mesh(std::map<std::string,std::vector<float>>& attributesFloat,std::map<std::string,std::vector<glm::vec2>>& attributesVec2, std::map<std::string,std::vector<glm::vec3>>& attributesVec3,std::map<std::string,std::vector<glm::vec4>>& attributesVec4,std::map<std::string,std::vector<glm::ivec4>>& attributesIVec4,std::map<std::string,std::vector<glm::u8vec4>>& attributesU8Vec4,std::map<std::string,bool>& attributesNormalized, const std::vector<std::vector<uint32_t>> &indices, std::vector<MeshTopology> meshTopology, std::string name,RenderStats& renderStats)
     {
         meshId = meshIdCount++;
         if ( Renderer::instance == nullptr){
             LOG_FATAL("Cannot instantiate sre::Mesh before sre::Renderer is created.");
         }
         glGenBuffers(1, &vertexBufferId);
-        update(attributesFloat, attributesVec2, attributesVec3,attributesVec4,attributesIVec4, indices, meshTopology,name,renderStats);
+        update(attributesFloat, attributesVec2, attributesVec3,attributesVec4,attributesIVec4,attributesU8Vec4,attributesNormalized, indices, meshTopology,name,renderStats);
         Renderer::instance->meshes.emplace_back(this);
     }
 
@@ -87,7 +89,7 @@ namespace sre {
         return vertexCount;
     }
 
-    void Mesh::update(std::map<std::string,std::vector<float>>& attributesFloat,std::map<std::string,std::vector<glm::vec2>>& attributesVec2, std::map<std::string,std::vector<glm::vec3>>& attributesVec3,std::map<std::string,std::vector<glm::vec4>>& attributesVec4,std::map<std::string,std::vector<glm::ivec4>>& attributesIVec4, const std::vector<std::vector<uint16_t>> &indices, std::vector<MeshTopology> meshTopology,std::string name,RenderStats& renderStats) {
+    void Mesh::update(std::map<std::string,std::vector<float>>& attributesFloat,std::map<std::string,std::vector<glm::vec2>>& attributesVec2, std::map<std::string,std::vector<glm::vec3>>& attributesVec3,std::map<std::string,std::vector<glm::vec4>>& attributesVec4,std::map<std::string,std::vector<glm::ivec4>>& attributesIVec4,std::map<std::string,std::vector<glm::u8vec4>>& attributesU8Vec4,std::map<std::string,bool>& attributesNormalized, const std::vector<std::vector<uint32_t>> &indices, std::vector<MeshTopology> meshTopology,std::string name,RenderStats& renderStats) {
         this->meshTopology = meshTopology;
         this->name = name;
         meshId = meshIdCount++;
@@ -110,37 +112,45 @@ namespace sre {
         for (auto & pair : attributesVec3){
             vertexCount = std::max(vertexCount, (int)pair.second.size());
             offset.push_back(totalBytesPerVertex);
-            attributeByName[pair.first] = {totalBytesPerVertex, 3, GL_FLOAT, GL_FLOAT_VEC3};
+            attributeByName[pair.first] = {totalBytesPerVertex, 3, GL_FLOAT, GL_FLOAT_VEC3, false};
             totalBytesPerVertex += sizeof(glm::vec4); // note use vec4 size
         }
         for (auto & pair : attributesVec4){
             vertexCount = std::max(vertexCount, (int)pair.second.size());
             offset.push_back(totalBytesPerVertex);
-            attributeByName[pair.first] = {totalBytesPerVertex, 4, GL_FLOAT, GL_FLOAT_VEC4};
+            attributeByName[pair.first] = {totalBytesPerVertex, 4, GL_FLOAT, GL_FLOAT_VEC4, false};
             totalBytesPerVertex += sizeof(glm::vec4);
         }
         for (auto & pair : attributesIVec4){
             vertexCount = std::max(vertexCount, (int)pair.second.size());
             offset.push_back(totalBytesPerVertex);
-            attributeByName[pair.first] = {totalBytesPerVertex, 4,GL_INT, GL_INT_VEC4};
+            attributeByName[pair.first] = {totalBytesPerVertex, 4,GL_INT, GL_INT_VEC4, false};
             totalBytesPerVertex += sizeof(glm::i32vec4);
         }
         for (auto & pair : attributesVec2){
             vertexCount = std::max(vertexCount, (int)pair.second.size());
             offset.push_back(totalBytesPerVertex);
-            attributeByName[pair.first] = {totalBytesPerVertex, 2, GL_FLOAT,GL_FLOAT_VEC2};
+            attributeByName[pair.first] = {totalBytesPerVertex, 2, GL_FLOAT,GL_FLOAT_VEC2, false};
             totalBytesPerVertex += sizeof(glm::vec2);
         }
         for (auto & pair : attributesFloat){
             vertexCount = std::max(vertexCount, (int)pair.second.size());
             offset.push_back(totalBytesPerVertex);
-            attributeByName[pair.first] = {totalBytesPerVertex, 1, GL_FLOAT, GL_FLOAT};
+            attributeByName[pair.first] = {totalBytesPerVertex, 1, GL_FLOAT, GL_FLOAT, false};
             totalBytesPerVertex += sizeof(float);
         }
         // add final padding (make vertex align with vec4)
         if (totalBytesPerVertex%(sizeof(float)*4) != 0) {
             totalBytesPerVertex += sizeof(float)*4 - totalBytesPerVertex%(sizeof(float)*4);
         }
+        // packed attributes go last and are only aligned to 4 bytes, so a mesh of only packed attributes stays small
+        for (auto & pair : attributesU8Vec4){
+            vertexCount = std::max(vertexCount, (int)pair.second.size());
+            offset.push_back(totalBytesPerVertex);
+            bool normalized = attributesNormalized[pair.first];
+            attributeByName[pair.first] = {totalBytesPerVertex, 4, GL_UNSIGNED_BYTE, normalized ? GL_FLOAT_VEC4 : GL_UNSIGNED_INT_VEC4, normalized};
+            totalBytesPerVertex += sizeof(glm::u8vec4);
+        }
         std::vector<float> interleavedData((vertexCount * totalBytesPerVertex) / sizeof(float), 0);
         const char * dataPtr = (char*) interleavedData.data();
 
@@ -180,6 +190,13 @@ namespace sre {
                 *locationPtr = pair.second[i];
             }
         }
+        for (auto & pair : attributesU8Vec4){
+            auto& offsetBytes = attributeByName[pair.first];
+            for (int i=0;i<pair.second.size();i++) {
+                glm::u8vec4 * locationPtr = (glm::u8vec4 *) (dataPtr + totalBytesPerVertex * i + offsetBytes.offset);
+                *locationPtr = pair.second[i];
+            }
+        }
 
 #ifndef EMSCRIPTEN
         glBindVertexArray(0);
@@ -187,6 +204,7 @@ namespace sre {
         glBindBuffer(GL_ARRAY_BUFFER, vertexBufferId);
         glBufferData(GL_ARRAY_BUFFER, sizeof(float)*interleavedData.size(), interleavedData.data(), GL_STATIC_DRAW);
 
+        indexTypes.clear();
         if (!indices.empty()){
             for (int i=0;i<indices.size();i++){
                 unsigned int eBufferId;
@@ -197,8 +215,23 @@ namespace sre {
                     eBufferId = elementBufferId[i];
                 }
                 glBindBuffer(GL_ELEMENT_ARRAY_BUFFER, eBufferId);
-                GLsizeiptr indicesSize = indices[i].size()*sizeof(uint16_t);
-                glBufferData(GL_ELEMENT_ARRAY_BUFFER, indicesSize, indices[i].data(), GL_STATIC_DRAW);
+
+                // use 16 bit indices unless the index set references vertices which do not fit
+                uint32_t maxIndex = 0;
+                for (auto index : indices[i]){
+                    maxIndex = std::max(maxIndex, index);
+                }
+                GLsizeiptr indicesSize;
+                if (maxIndex <= std::numeric_limits<uint16_t>::max()){
+                    std::vector<uint16_t> shortIndices(indices[i].begin(), indices[i].end());
+                    indicesSize = shortIndices.size()*sizeof(uint16_t);
+                    glBufferData(GL_ELEMENT_ARRAY_BUFFER, indicesSize, shortIndices.data(), GL_STATIC_DRAW);
+                    indexTypes.push_back(GL_UNSIGNED_SHORT);
+                } else {
+                    indicesSize = indices[i].size()*sizeof(uint32_t);
+                    glBufferData(GL_ELEMENT_ARRAY_BUFFER, indicesSize, indices[i].data(), GL_STATIC_DRAW);
+                    indexTypes.push_back(GL_UNSIGNED_INT);
+                }
                 dataSize += indicesSize;
             }
         }
@@ -209,6 +242,8 @@ namespace sre {
         this->attributesVec3  = std::move(attributesVec3);
         this->attributesVec4  = std::move(attributesVec4);
         this->attributesIVec4 = std::move(attributesIVec4);
+        this->attributesU8Vec4 = std::move(attributesU8Vec4);
+        this->attributesNormalized = std::move(attributesNormalized);
 
         boundsMinMax[0] = glm::vec3{std::numeric_limits<float>::max()};
         boundsMinMax[1] = glm::vec3{-std::numeric_limits<float>::max()};
@@ -219,12 +254,52 @@ namespace sre {
                 boundsMinMax[1] = glm::max(boundsMinMax[1], v);
             }
         }
-        dataSize = totalBytesPerVertex*vertexCount;
+        dataSize += totalBytesPerVertex*vertexCount;
 
         renderStats.meshBytes += dataSize;
         renderStats.meshBytesAllocated += dataSize;
     }
 
+    void Mesh::updateAttributes(int firstVertex, const std::map<std::string,std::vector<glm::u8vec4>>& values) {
+        int count = 0;
+        for (auto & pair : values){
+            auto& stored = attributesU8Vec4[pair.first];
+            assert(firstVertex >= 0 && firstVertex + pair.second.size() <= stored.size());
+            std::copy(pair.second.begin(), pair.second.end(), stored.begin() + firstVertex);
+            count = std::max(count, (int)pair.second.size());
+        }
+        if (count == 0){
+            return;
+        }
+
+        // the vertex buffer is interleaved, so whole vertices are rebuilt from the stored attributes and uploaded as one range
+        std::vector<char> interleavedData(count * totalBytesPerVertex, 0);
+        char * dataPtr = interleavedData.data();
+        auto copyRange = [&](auto& attributes){
+            for (auto & pair : attributes){
+                using T = typename std::decay<decltype(pair.second)>::type::value_type;
+                auto& offsetBytes = attributeByName[pair.first];
+                int end = std::min(firstVertex + count, (int)pair.second.size());
+                for (int i=firstVertex;i<end;i++) {
+                    T * locationPtr = (T *) (dataPtr + totalBytesPerVertex * (i - firstVertex) + offsetBytes.offset);
+                    *locationPtr = pair.second[i];
+                }
+            }
+        };
+        copyRange(attributesVec3);
+        copyRange(attributesVec4);
+        copyRange(attributesIVec4);
+        copyRange(attributesVec2);
+        copyRange(attributesFloat);
+        copyRange(attributesU8Vec4);
+
+#ifndef EMSCRIPTEN
+        glBindVertexArray(0);
+#endif
+        glBindBuffer(GL_ARRAY_BUFFER, vertexBufferId);
+        glBufferSubData(GL_ARRAY_BUFFER, firstVertex * totalBytesPerVertex, interleavedData.size(), interleavedData.data());
+    }
+
     void Mesh::setVertexAttributePointers(Shader* shader) {
         glBindBuffer(GL_ARRAY_BUFFER, vertexBufferId);
         int vertexAttribArray = 0;
@@ -239,11 +314,21 @@ namespace sre {
                     (shaderAttribute.second.type >= GL_FLOAT_VEC2 && shaderAttribute.second.type <= GL_FLOAT_VEC4 && shaderAttribute.second.type>= meshAttribute->second.attributeType)
 #ifndef EMSCRIPTEN
                     || (shaderAttribute.second.type >= GL_INT_VEC2 && shaderAttribute.second.type <= GL_INT_VEC4 && shaderAttribute.second.type>= meshAttribute->second.attributeType)
+                    || (shaderAttribute.second.type >= GL_UNSIGNED_INT_VEC2 && shaderAttribute.second.type <= GL_UNSIGNED_INT_VEC4 && shaderAttribute.second.type>= meshAttribute->second.attributeType)
 #endif
                                                      );
             if (attributeFoundInMesh &&  equalType && shaderAttribute.second.arraySize == 1) {
 				glEnableVertexAttribArray(shaderAttribute.second.position);
-                glVertexAttribPointer(shaderAttribute.second.position, meshAttribute->second.elementCount, meshAttribute->second.dataType, GL_FALSE, totalBytesPerVertex, BUFFER_OFFSET(meshAttribute->second.offset));
+                bool integerAttribute = meshAttribute->second.dataType != GL_FLOAT && !meshAttribute->second.normalized;
+#ifndef EMSCRIPTEN
+                if (integerAttribute) {
+                    // integer attributes must use the I variant, otherwise they are converted to floats
+                    glVertexAttribIPointer(shaderAttribute.second.position, meshAttribute->second.elementCount, meshAttribute->second.dataType, totalBytesPerVertex, BUFFER_OFFSET(meshAttribute->second.offset));
+                } else
+#endif
+                {
+                    glVertexAttribPointer(shaderAttribute.second.position, meshAttribute->second.elementCount, meshAttribute->second.dataType, meshAttribute->second.normalized ? GL_TRUE : GL_FALSE, totalBytesPerVertex, BUFFER_OFFSET(meshAttribute->second.offset));
+                }
                 vertexAttribArray++;
             } else {
 				assert(shaderAttribute.second.arraySize == 1 && "Constant vertex attributes not supported as arrays");
@@ -251,6 +336,9 @@ namespace sre {
 				static const float a[] = { 0, 0, 0, 0, 0, 0, 0, 0, 0, 0, 0, 0, 0, 0, 0, 0};
                 switch (shaderAttribute.second.type) {
 #ifndef EMSCRIPTEN
+				case GL_UNSIGNED_INT_VEC4:
+					glVertexAttribI4uiv(shaderAttribute.second.position, (GLuint*)a);
+					break;
 				case GL_INT_VEC4:
 					glVertexAttribI4iv(shaderAttribute.second.position, (GLint*)a);
 					break;
@@ -276,6 +364,9 @@ namespace sre {
 				case GL_FLOAT:
 					glVertexAttrib1fv(shaderAttribute.second.position, a);
 					break;
+				case GL_FLOAT_MAT4:
+					// per instance transform, pointed at the instance buffer by RenderPass::drawInstanced
+					break;
                 default:
 					throw std::runtime_error("Unhandled attribute type");
                 	break;
@@ -312,10 +403,14 @@ namespace sre {
         return res;
     }
 
-    const std::vector<uint16_t>& Mesh::getIndices(int indexSet) {
+    const std::vector<uint32_t>& Mesh::getIndices(int indexSet) {
         return indices.at(indexSet);
     }
 
+    int Mesh::getIndexBytes(int indexSet) {
+        return indexTypes.at(indexSet) == GL_UNSIGNED_INT ? sizeof(uint32_t) : sizeof(uint16_t);
+    }
+
     Mesh::MeshBuilder Mesh::update() {
         Mesh::MeshBuilder res;
         res.updateMesh = this;
@@ -325,6 +420,8 @@ namespace sre {
         res.attributesVec3 = attributesVec3;
         res.attributesVec4 = attributesVec4;
         res.attributesIVec4 = attributesIVec4;
+        res.attributesU8Vec4 = attributesU8Vec4;
+        res.attributesNormalized = attributesNormalized;
 
         res.indices = indices;
         res.meshTopology = meshTopology;
@@ -423,6 +520,10 @@ namespace sre {
     }
 
     Mesh::MeshBuilder &Mesh::MeshBuilder::withIndices(const std::vector<uint16_t> &indices,MeshTopology meshTopology, int indexSet) {
+        return withIndices(std::vector<uint32_t>(indices.begin(), indices.end()), meshTopology, indexSet);
+    }
+
+    Mesh::MeshBuilder &Mesh::MeshBuilder::withIndices(const std::vector<uint32_t> &indices,MeshTopology meshTopology, int indexSet) {
         while (indexSet >= this->indices.size()){
             this->indices.emplace_back();
         }
@@ -445,13 +546,13 @@ namespace sre {
 
         if (updateMesh != nullptr){
             renderStats.meshBytes -= updateMesh->getDataSize();
-            updateMesh->update(this->attributesFloat, this->attributesVec2, this->attributesVec3, this->attributesVec4, this->attributesIVec4, indices, meshTopology,name,renderStats);
+            updateMesh->update(this->attributesFloat, this->attributesVec2, this->attributesVec3, this->attributesVec4, this->attributesIVec4, this->attributesU8Vec4, this->attributesNormalized, indices, meshTopology,name,renderStats);
 
 
             return updateMesh->shared_from_this();
         }
 
-        auto res = new Mesh(this->attributesFloat, this->attributesVec2, this->attributesVec3, this->attributesVec4, this->attributesIVec4, indices, meshTopology,name,renderStats);
+        auto res = new Mesh(this->attributesFloat, this->attributesVec2, this->attributesVec3, this->attributesVec4, this->attributesIVec4, this->attributesU8Vec4, this->attributesNormalized, indices, meshTopology,name,renderStats);
         renderStats.meshCount++;
 
         return std::shared_ptr<Mesh>(res);
@@ -787,6 +888,16 @@ namespace sre {
         return *this;
     }
 
+    Mesh::MeshBuilder &Mesh::MeshBuilder::withAttribute(std::string name, const std::vector<glm::u8vec4> &values, bool normalized) {
+        if (updateMesh != nullptr && attributesU8Vec4.find(name) == attributesU8Vec4.end()){
+            LOG_ERROR("Cannot change mesh structure. %s dis not exist in the original mesh as a u8vec4.",name.c_str());
+        } else {
+            attributesU8Vec4[name] = values;
+            attributesNormalized[name] = normalized;
+        }
+        return *this;
+    }
+
     Mesh::MeshBuilder &Mesh::MeshBuilder::withName(const std::string& name) {
         this->name = name;
         return *this;
@@ -6,6 +6,8 @@
  */
 #include "sre/Profiler.hpp"
 #include <algorithm>
+#include <fstream>
+#include <functional>
 #include <iostream>
 #include <glm/gtx/euler_angles.hpp>
 #include <glm/gtx/transform.hpp>
@@ -16,6 +18,7 @@
 #include "sre/Texture.hpp"
 #include "sre/SpriteAtlas.hpp"
 #include "sre/Framebuffer.hpp"
+#include "sre/GpuTimer.hpp"
 #include "sre/Sprite.hpp"
 #include "imgui_internal.h"
 #include <SDL_image.h>
@@ -57,7 +60,13 @@ namespace sre {
                 case GL_INT_VEC4:
                     typeStr = "ivec4";
                     break;
+                case GL_UNSIGNED_INT_VEC4:
+                    typeStr = "uvec4";
+                    break;
 #endif
+                case GL_UNSIGNED_BYTE:
+                    typeStr = "ubyte";
+                    break;
             }
             return typeStr;
         }
@@ -68,7 +77,9 @@ namespace sre {
     {
         stats.resize(frames);
         milliseconds.resize(frames);
+        gpuMilliseconds.resize(frames);
         data.resize(frames);
+        frameStarts.resize(frames);
         lastTick = Clock::now();
     }
 
@@ -112,7 +123,7 @@ namespace sre {
                     for (int i=0;i<mesh->getIndexSets();i++){
                         char res[128];
                         sprintf(res,"Index %i size",i);
-                        ImGui::LabelText(res, "%i", mesh->getIndicesSize(i));
+                        ImGui::LabelText(res, "%i (%i bit)", mesh->getIndicesSize(i), mesh->getIndexBytes(i)*8);
                     }
                 }
                 ImGui::TreePop();
@@ -356,6 +367,16 @@ namespace sre {
             sprintf(res,"Avg: %4.1f\nMax: %4.1f",avg,max);
 
             ImGui::PlotLines(res,data.data(),frames, 0, "State changes", -1,max*1.2f,ImVec2(ImGui::CalcItemWidth(),150));
+
+            const RenderStats& lastStats = stats[(frameCount + frames - 1)%frames];
+            ImGui::LabelText("Visible objects", "%i", lastStats.objectsVisible);
+            ImGui::LabelText("Culled objects", "%i", lastStats.objectsCulled);
+        }
+        if (ImGui::CollapsingHeader("Scopes")){
+            showScopes();
+        }
+        if (ImGui::CollapsingHeader("GPU")){
+            showGpuTimings();
         }
         if (ImGui::CollapsingHeader("Memory")){
             float max = 0;
@@ -445,7 +466,153 @@ namespace sre {
 
         stats[frameCount%frames] = Renderer::instance->getRenderStats();
         milliseconds[frameCount%frames] = deltaTime;
+        float gpuTime = 0;
+        if (GpuTimer::isEnabled()){
+            for (auto& timing : GpuTimer::getLastTimings()){
+                if (timing.depth == 0){
+                    gpuTime += timing.milliseconds;
+                }
+            }
+        }
+        gpuMilliseconds[frameCount%frames] = gpuTime;
         frameCount++;
+
+        // Frames are only marked while recording, so the timeline stays put when recording stops.
+        if (ScopeProfiler::isEnabled()){
+            frameStarts[scopeFrameCount%frames] = ScopeProfiler::now();
+            scopeFrameCount++;
+        }
+    }
+
+    void Profiler::showScopes() {
+        bool recording = ScopeProfiler::isEnabled();
+        if (ImGui::Checkbox("Record scopes", &recording)){
+            ScopeProfiler::setEnabled(recording);
+        }
+
+        // The newest frame is still running, so the last complete frame is one back.
+        int recordedFrames = std::min(scopeFrameCount, frames) - 1;
+        if (recordedFrames < 1){
+            ImGui::LabelText("", "No frames recorded");
+        } else {
+            selectedScopeFrame = std::min(std::max(selectedScopeFrame, 1), recordedFrames);
+            ImGui::SliderInt("Frames back", &selectedScopeFrame, 1, recordedFrames);
+
+            uint64_t start = frameStarts[(scopeFrameCount - 1 - selectedScopeFrame)%frames];
+            uint64_t end = frameStarts[(scopeFrameCount - selectedScopeFrame)%frames];
+            ImGui::LabelText("Frame time", "%.2f ms", (end - start) / 1000000.0f);
+            showScopeTimeline(start, end);
+        }
+
+        if (ImGui::Button("Export Chrome trace")){
+            std::ofstream out("trace.json");
+            ScopeProfiler::writeChromeTrace(out);
+            traceMessage = out.good() ? "Written to trace.json" : "Could not write trace.json";
+        }
+        if (!traceMessage.empty()){
+            ImGui::SameLine();
+            ImGui::Text("%s", traceMessage.c_str());
+        }
+    }
+
+    void Profiler::showGpuTimings() {
+        if (!GpuTimer::isSupported()){
+            ImGui::LabelText("", "Not supported");
+            return;
+        }
+        bool measuring = GpuTimer::isEnabled();
+        if (ImGui::Checkbox("Measure GPU time", &measuring)){
+            GpuTimer::setEnabled(measuring);
+        }
+        if (!measuring){
+            return;
+        }
+
+        float max = 0;
+        float sum = 0;
+        for (int i=0;i<frames;i++){
+            int idx = (frameCount + i)%frames;
+            float t = gpuMilliseconds[idx];
+            data[(-frameCount%frames+idx+frames)%frames] = t;
+            max = std::max(max, t);
+            sum += t;
+        }
+        float avg = 0;
+        if (frameCount > 0){
+            avg = sum / std::min(frameCount, frames);
+        }
+        char res[128];
+        sprintf(res,"Avg time: %4.2f ms\nMax time: %4.2f ms",avg,max);
+        ImGui::PlotLines(res,data.data(),frames, 0, "GPU milliseconds", -1,max*1.2f,ImVec2(ImGui::CalcItemWidth(),150));
+
+        // The GPU finishes a frame some frames after the CPU submitted it.
+        ImGui::LabelText("Latency", "%i frames", GpuTimer::getFrameLatency());
+        for (auto& timing : GpuTimer::getLastTimings()){
+            std::string label = std::string(timing.depth * 2, ' ') + timing.name;
+            ImGui::LabelText(label.c_str(), "%.3f ms", timing.milliseconds);
+        }
+    }
+
+    void Profiler::showScopeTimeline(uint64_t start, uint64_t end) {
+        scopeEvents.clear();
+        ScopeProfiler::getEvents(start, end, scopeEvents);
+
+        // Every thread gets a row with its name, followed by a row per nesting depth.
+        int threadCount = ScopeProfiler::getThreadCount();
+        std::vector<int> maxDepth(threadCount, -1);
+        for (auto& event : scopeEvents){
+            maxDepth[event.thread] = std::max(maxDepth[event.thread], event.depth);
+        }
+        float rowHeight = ImGui::GetTextLineHeight() + 2;
+        std::vector<float> threadTop(threadCount);
+        float height = 0;
+        for (int i = 0; i < threadCount; i++){
+            threadTop[i] = height;
+            if (maxDepth[i] >= 0){
+                height += rowHeight * (maxDepth[i] + 2);
+            }
+        }
+        if (height == 0){
+            ImGui::LabelText("", "No scopes in this frame");
+            return;
+        }
+
+        float width = ImGui::GetContentRegionAvailWidth();
+        ImVec2 origin = ImGui::GetCursorScreenPos();
+        ImGui::InvisibleButton("##scopeTimeline", ImVec2(width, height));
+        bool hovered = ImGui::IsItemHovered();
+        ImVec2 mouse = ImGui::GetIO().MousePos;
+
+        ImDrawList* drawList = ImGui::GetWindowDrawList();
+        ImU32 textColor = ImGui::GetColorU32(ImGuiCol_Text);
+        for (int i = 0; i < threadCount; i++){
+            if (maxDepth[i] >= 0){
+                drawList->AddText(ImVec2(origin.x, origin.y + threadTop[i]), textColor, ScopeProfiler::getThreadName(i).c_str());
+            }
+        }
+
+        float scale = width / std::max<uint64_t>(end - start, 1);
+        std::hash<std::string> hashName;
+        for (auto& event : scopeEvents){
+            float x0 = origin.x + (std::max(event.start, start) - start) * scale;
+            float x1 = origin.x + (std::min(event.end, end) - start) * scale;
+            x1 = std::max(x1, x0 + 1);
+            float y0 = origin.y + threadTop[event.thread] + rowHeight * (event.depth + 1);
+            float y1 = y0 + rowHeight - 1;
+
+            // The same scope keeps its color from frame to frame.
+            float hue = (hashName(event.name) % 360) / 360.0f;
+            drawList->AddRectFilled(ImVec2(x0, y0), ImVec2(x1, y1), ImColor::HSV(hue, 0.5f, 0.6f));
+            if (x1 - x0 > 20){
+                drawList->PushClipRect(ImVec2(x0, y0), ImVec2(x1, y1), true);
+                drawList->AddText(ImVec2(x0 + 2, y0 + 1), textColor, event.name);
+                drawList->PopClipRect();
+            }
+
+            if (hovered && mouse.x >= x0 && mouse.x < x1 && mouse.y >= y0 && mouse.y < y1){
+                ImGui::SetTooltip("%s\n%.3f ms", event.name, (event.end - event.start) / 1000000.0f);
+            }
+        }
     }
 
     void Profiler::showSpriteAtlas(SpriteAtlas *pAtlas) {
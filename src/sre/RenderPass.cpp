@@ -11,8 +11,11 @@
 #include "sre/Material.hpp"
 #include "sre/RenderStats.hpp"
 #include "sre/Texture.hpp"
+#include "sre/ScopeProfiler.hpp"
+#include "sre/GpuTimer.hpp"
 #include "sre/impl/GL.hpp"
 #include <cassert>
+#include <cstring>
 #include <algorithm>
 #include <glm/gtc/type_ptr.hpp>
 #include <sre/imgui_sre.hpp>
@@ -21,6 +24,7 @@
 #include <glm/gtc/type_precision.hpp>
 namespace sre {
     RenderPass* RenderPass::instance = nullptr;
+    unsigned int RenderPass::instanceBufferId = 0;
 
     std::shared_ptr<Framebuffer> RenderPass::lastFramebuffer;
 
@@ -71,6 +75,11 @@ namespace sre {
         return *this;
     }
 
+    RenderPass::RenderPassBuilder &RenderPass::RenderPassBuilder::withSortedDraws(bool enabled) {
+        this->sortedDraws = enabled;
+        return *this;
+    }
+
     RenderPass RenderPass::RenderPassBuilder::build(){
 
         return RenderPass(*this);
@@ -84,9 +93,14 @@ namespace sre {
     RenderPass::RenderPass(RenderPass::RenderPassBuilder& builder)
         :builder(builder)
     {
+        // draws recorded by the previous renderpass must end up in its own framebuffer
+        if (RenderPass::instance != nullptr){
+            RenderPass::instance->flushCommands();
+        }
         lastInstance = RenderPass::instance;
         RenderPass::instance = this;
         bind(true);
+        GpuTimer::begin(builder.name.empty() ? "RenderPass" : builder.name);
     }
 
     RenderPass::RenderPass(RenderPass &&rp) noexcept {
@@ -99,9 +113,15 @@ namespace sre {
         std::swap(lastBoundShader,rp.lastBoundShader);
         std::swap(lastBoundMaterial,rp.lastBoundMaterial);
         std::swap(lastBoundMeshId,rp.lastBoundMeshId);
+        std::swap(lastBoundIndexSet,rp.lastBoundIndexSet);
         std::swap(projection,rp.projection);
         std::swap(viewportOffset,rp.viewportOffset);
         std::swap(viewportSize,rp.viewportSize);
+        std::swap(commands,rp.commands);
+        std::swap(commandRanges,rp.commandRanges);
+        std::swap(commandInstances,rp.commandInstances);
+        std::swap(sortItems,rp.sortItems);
+        std::swap(sortScratch,rp.sortScratch);
     }
 
     RenderPass &RenderPass::operator=(RenderPass &&rp) noexcept {
@@ -109,18 +129,26 @@ namespace sre {
             instance = this;
         }
         builder = rp.builder;
+        std::swap(lastInstance,rp.lastInstance);
         std::swap(lastBoundShader,rp.lastBoundShader);
         std::swap(lastBoundMaterial,rp.lastBoundMaterial);
         std::swap(lastBoundMeshId,rp.lastBoundMeshId);
+        std::swap(lastBoundIndexSet,rp.lastBoundIndexSet);
         std::swap(projection,rp.projection);
         std::swap(viewportOffset,rp.viewportOffset);
         std::swap(viewportSize,rp.viewportSize);
+        std::swap(commands,rp.commands);
+        std::swap(commandRanges,rp.commandRanges);
+        std::swap(commandInstances,rp.commandInstances);
+        std::swap(sortItems,rp.sortItems);
+        std::swap(sortScratch,rp.sortScratch);
         return *this;
     }
 
     RenderPass::~RenderPass(){
         if (RenderPass::instance == this){
             RenderPass::finish();
+            GpuTimer::end();
             RenderPass::instance = lastInstance;
             if (RenderPass::instance != nullptr){
                 RenderPass::instance->bind(false);
@@ -130,32 +158,206 @@ namespace sre {
 
     void RenderPass::draw(std::shared_ptr<Mesh>& meshPtr, glm::mat4 modelTransform, std::shared_ptr<Material>& material_ptr) {
         assert(instance == this && "You can only invoke methods on the currently bound renderpass");
+        assert(meshPtr != nullptr);
+        if (builder.sortedDraws){
+            record(meshPtr, modelTransform, material_ptr, 0);
+            return;
+        }
+        drawIndexSet(meshPtr.get(), modelTransform, material_ptr.get(), 0);
+    }
 
-        Mesh* mesh = meshPtr.get();
-        auto material = material_ptr.get();
-        auto shader = material->getShader().get();
-        assert(mesh  != nullptr);
-        builder.renderStats->drawCalls++;
-        setupShader(modelTransform, shader);
+    void RenderPass::drawRanges(std::shared_ptr<Mesh>& meshPtr, const std::vector<MeshRange>& ranges, glm::mat4 modelTransform, std::shared_ptr<Material>& material_ptr) {
+        assert(instance == this && "You can only invoke methods on the currently bound renderpass");
+        if (ranges.empty()) return;
+        assert(meshPtr != nullptr && meshPtr->getIndexSets() > 0);
+        if (builder.sortedDraws){
+            // the caller may reuse its ranges right away, so keep a copy until the pass finishes
+            int firstRange = (int)commandRanges.size();
+            commandRanges.insert(commandRanges.end(), ranges.begin(), ranges.end());
+            record(meshPtr, modelTransform, material_ptr, 0, firstRange, (int)ranges.size());
+            return;
+        }
+        drawMeshRanges(meshPtr.get(), ranges.data(), (int)ranges.size(), modelTransform, material_ptr.get());
+    }
+
+    void RenderPass::drawInstanced(std::shared_ptr<Mesh>& meshPtr, const glm::mat4* modelTransforms, int instanceCount, std::shared_ptr<Material>& material_ptr) {
+        assert(instance == this && "You can only invoke methods on the currently bound renderpass");
+        if (instanceCount <= 0) return;
+        assert(meshPtr != nullptr);
+        if (builder.sortedDraws){
+            int firstInstance = (int)commandInstances.size();
+            commandInstances.insert(commandInstances.end(), modelTransforms, modelTransforms + instanceCount);
+            record(meshPtr, modelTransforms[0], material_ptr, 0, -1, 0, firstInstance, instanceCount);
+            return;
+        }
+        drawMeshInstances(meshPtr.get(), modelTransforms, instanceCount, material_ptr.get());
+    }
+
+    void RenderPass::drawInstanced(std::shared_ptr<Mesh>& meshPtr, const std::vector<glm::mat4>& modelTransforms, std::shared_ptr<Material>& material_ptr) {
+        drawInstanced(meshPtr, modelTransforms.data(), (int)modelTransforms.size(), material_ptr);
+    }
+
+    void RenderPass::bindMaterialAndMesh(Material* material, Mesh* mesh, Shader* shader, int indexSet) {
         if (material != lastBoundMaterial){
             builder.renderStats->stateChangesMaterial++;
             lastBoundMaterial = material;
-            lastBoundMeshId = -1;
+            lastBoundMeshId = -1; // force mesh to rebind
             material->bind();
         }
         if (mesh->meshId != lastBoundMeshId){
             builder.renderStats->stateChangesMesh++;
             lastBoundMeshId = mesh->meshId;
+            lastBoundIndexSet = -1;
             mesh->bind(shader);
-            mesh->bindIndexSet(0);
         }
+        if (indexSet != lastBoundIndexSet){
+            lastBoundIndexSet = indexSet;
+            mesh->bindIndexSet(indexSet);
+        }
+    }
+
+    void RenderPass::drawIndexSet(Mesh* mesh, const glm::mat4& modelTransform, Material* material, int indexSet) {
+        auto shader = material->getShader().get();
+        builder.renderStats->drawCalls++;
+        setupShader(modelTransform, shader);
+        bindMaterialAndMesh(material, mesh, shader, indexSet);
 
         if (mesh->getIndexSets() == 0){
             glDrawArrays((GLenum) mesh->getMeshTopology(), 0, mesh->getVertexCount());
+        } else {
+            GLsizei indexCount = (GLsizei) mesh->getIndicesSize(indexSet);
+            glDrawElements((GLenum) mesh->getMeshTopology(indexSet), indexCount, mesh->indexTypes[indexSet], 0);
+        }
+    }
+
+    void RenderPass::drawMeshRanges(Mesh* mesh, const MeshRange* ranges, int rangeCount, const glm::mat4& modelTransform, Material* material) {
+        auto shader = material->getShader().get();
+        builder.renderStats->drawCalls++;
+        setupShader(modelTransform, shader);
+        bindMaterialAndMesh(material, mesh, shader, 0);
+
+#ifndef EMSCRIPTEN
+        // every range starts at the beginning of the index set, only the base vertex differs
+        std::vector<GLsizei> counts(rangeCount);
+        std::vector<void*> offsets(rangeCount, nullptr);
+        std::vector<GLint> baseVertices(rangeCount);
+        for (int i=0;i<rangeCount;i++){
+            counts[i] = ranges[i].indexCount;
+            baseVertices[i] = ranges[i].baseVertex;
+        }
+        glMultiDrawElementsBaseVertex((GLenum) mesh->getMeshTopology(), counts.data(), mesh->indexTypes[0], offsets.data(), (GLsizei) rangeCount, baseVertices.data());
+#else
+        assert(false && "drawRanges requires base vertex support, which WebGL does not have");
+#endif
+    }
+
+    void RenderPass::drawMeshInstances(Mesh* mesh, const glm::mat4* modelTransforms, int instanceCount, Material* material) {
+        auto shader = material->getShader().get();
+        auto attribute = shader->attributes.find("instanceTransform");
+        assert(attribute != shader->attributes.end() && "drawInstanced requires a shader with an instanceTransform attribute");
+        builder.renderStats->drawCalls++;
+        setupShader(glm::mat4(1), shader);
+        bindMaterialAndMesh(material, mesh, shader, 0);
+
+#ifndef EMSCRIPTEN
+        // stream the transforms into the shared buffer, orphaning the previous contents so the GPU does not stall on them
+        if (instanceBufferId == 0){
+            glGenBuffers(1, &instanceBufferId);
+        }
+        glBindBuffer(GL_ARRAY_BUFFER, instanceBufferId);
+        glBufferData(GL_ARRAY_BUFFER, instanceCount * sizeof(glm::mat4), modelTransforms, GL_STREAM_DRAW);
+
+        // a mat4 attribute takes four locations, one per column, advanced once per instance
+        GLuint location = (GLuint)attribute->second.position;
+        for (int i=0;i<4;i++){
+            glEnableVertexAttribArray(location + i);
+            glVertexAttribPointer(location + i, 4, GL_FLOAT, GL_FALSE, sizeof(glm::mat4), (void*)(sizeof(glm::vec4) * i));
+            glVertexAttribDivisor(location + i, 1);
+        }
+
+        if (mesh->getIndexSets() == 0){
+            glDrawArraysInstanced((GLenum) mesh->getMeshTopology(), 0, mesh->getVertexCount(), instanceCount);
         } else {
             GLsizei indexCount = (GLsizei) mesh->getIndicesSize(0);
-            glDrawElements((GLenum) mesh->getMeshTopology(), indexCount, GL_UNSIGNED_SHORT, 0);
+            glDrawElementsInstanced((GLenum) mesh->getMeshTopology(), indexCount, mesh->indexTypes[0], 0, instanceCount);
+        }
+#else
+        assert(false && "drawInstanced requires instanced arrays, which WebGL 1 does not have");
+#endif
+    }
+
+    // Maps a view depth to 16 bits that sort the same way. The bits of a positive float sort like the float itself,
+    // so the sign, exponent and top mantissa bits make a coarse logarithmic depth.
+    static uint64_t depthBits(float depth) {
+        if (!(depth > 0)) return 0;
+        uint32_t bits;
+        memcpy(&bits, &depth, sizeof(bits));
+        return bits >> 16;
+    }
+
+    void RenderPass::record(std::shared_ptr<Mesh>& mesh, const glm::mat4& modelTransform, std::shared_ptr<Material>& material, int indexSet, int firstRange, int rangeCount, int firstInstance, int instanceCount) {
+        auto shader = material->getShader().get();
+        float depth = -(builder.camera.getViewTransform() * modelTransform[3]).z;
+
+        // Opaque draws are grouped by state, and front to back within the same state to save fragment work.
+        // Blended draws must be drawn back to front and sort after all opaque draws. Those at the same depth,
+        // like sprites, keep the order they were drawn in.
+        uint64_t key;
+        if (shader->getBlend() == BlendType::Disabled){
+            uint64_t shaderBits = shader->shaderProgramId & 0x7fff;
+            uint64_t materialBits = material->materialId;
+            uint64_t meshBits = mesh->meshId;
+            key = (shaderBits << 48) | (materialBits << 32) | (meshBits << 16) | depthBits(depth);
+        } else {
+            key = (1ull << 63) | ((0xffff - depthBits(depth)) << 47);
+        }
+
+        sortItems.push_back({key, (uint32_t)commands.size()});
+        commands.push_back({mesh, material, modelTransform, indexSet, firstRange, rangeCount, firstInstance, instanceCount});
+    }
+
+    void RenderPass::flushCommands() {
+        if (commands.empty()) return;
+        SRE_PROFILE_SCOPE("RenderPass::flushCommands");
+
+        // LSD radix sort on 8 bits at a time. It is stable, so draws with equal keys keep their order.
+        // Digits that are the same for all draws, such as the shader in a scene with only one, are skipped.
+        sortScratch.resize(sortItems.size());
+        for (int shift = 0; shift < 64; shift += 8){
+            int count[256] = {0};
+            for (auto& item : sortItems){
+                count[(item.key >> shift) & 0xff]++;
+            }
+            if (count[(sortItems[0].key >> shift) & 0xff] == (int)sortItems.size()){
+                continue;
+            }
+            int offset = 0;
+            for (int i=0;i<256;i++){
+                int c = count[i];
+                count[i] = offset;
+                offset += c;
+            }
+            for (auto& item : sortItems){
+                sortScratch[count[(item.key >> shift) & 0xff]++] = item;
+            }
+            std::swap(sortItems, sortScratch);
         }
+
+        for (auto& item : sortItems){
+            auto& command = commands[item.command];
+            if (command.firstRange >= 0){
+                drawMeshRanges(command.mesh.get(), commandRanges.data() + command.firstRange, command.rangeCount, command.modelTransform, command.material.get());
+            } else if (command.firstInstance >= 0){
+                drawMeshInstances(command.mesh.get(), commandInstances.data() + command.firstInstance, command.instanceCount, command.material.get());
+            } else {
+                drawIndexSet(command.mesh.get(), command.modelTransform, command.material.get(), command.indexSet);
+            }
+        }
+
+        commands.clear();
+        commandRanges.clear();
+        commandInstances.clear();
+        sortItems.clear();
     }
 
     void RenderPass::setupShader(const glm::mat4 &modelTransform, Shader *shader)  {
@@ -212,12 +414,16 @@ namespace sre {
         lastBoundMaterial = nullptr;
         lastBoundMeshId = -1;
 
-        draw(mesh, glm::mat4(1), material);
+        // the shared mesh changes with the next call, so lines are never recorded
+        drawIndexSet(mesh.get(), glm::mat4(1), material.get(), 0);
     }
 
     void RenderPass::finishInstance(){
+        flushCommands();
         if (builder.gui) {
+            GpuTimer::begin("ImGui");
             ImGui::Render();
+            GpuTimer::end();
         }
         glBindFramebuffer(GL_FRAMEBUFFER, 0);
         auto framebuffer = lastFramebuffer.get();
@@ -235,6 +441,18 @@ namespace sre {
 #endif
     }
 
+    void RenderPass::beginGroup(const std::string& name) {
+        assert(instance == this && "You can only invoke methods on the currently bound renderpass");
+        flushCommands();
+        GpuTimer::begin(name);
+    }
+
+    void RenderPass::endGroup() {
+        assert(instance == this && "You can only invoke methods on the currently bound renderpass");
+        flushCommands();
+        GpuTimer::end();
+    }
+
     void RenderPass::finish() {
         if (instance != nullptr){
             instance->finishInstance();
@@ -243,6 +461,7 @@ namespace sre {
 
     std::vector<glm::vec4> RenderPass::readPixels(unsigned int x, unsigned int y, unsigned int width, unsigned int height) {
         assert(instance == this && "You can only invoke methods on the currently bound renderpass");
+        flushCommands();
         std::vector<glm::vec4> res(width * height);
         std::vector<glm::u8vec4> resUnsigned(width * height);
 
@@ -265,30 +484,12 @@ namespace sre {
         }
         assert(meshPtr->indices.size() == materials.size());
 
-        // todo optimize (mesh vbo only need to be bound once)
         for (int i=0;i<materials.size();i++){
-            auto material_ptr = materials[i];
-            Mesh* mesh = meshPtr.get();
-            auto material = material_ptr.get();
-            auto shader = material->getShader().get();
-            assert(mesh  != nullptr);
-            builder.renderStats->drawCalls++;
-            setupShader(modelTransform, shader);
-            if (material != lastBoundMaterial) {
-                builder.renderStats->stateChangesMaterial++;
-                lastBoundMaterial = material;
-                lastBoundMeshId = -1; // force mesh to rebind
-                material->bind();
+            if (builder.sortedDraws){
+                record(meshPtr, modelTransform, materials[i], i);
+            } else {
+                drawIndexSet(meshPtr.get(), modelTransform, materials[i].get(), i);
             }
-            if (mesh->meshId != lastBoundMeshId) {
-                builder.renderStats->stateChangesMesh++;
-                lastBoundMeshId = mesh->meshId;
-                mesh->bind(shader);
-            }
-            mesh->bindIndexSet(i);
-
-            GLsizei indexCount = mesh->getIndicesSize(i);
-            glDrawElements((GLenum) mesh->getMeshTopology(i), indexCount, GL_UNSIGNED_SHORT, 0);
         }
     }
 
@@ -296,6 +497,11 @@ namespace sre {
         glFinish();
     }
 
+    void RenderPass::addCullingStats(int visible, int culled) {
+        builder.renderStats->objectsVisible += visible;
+        builder.renderStats->objectsCulled += culled;
+    }
+
     void RenderPass::draw(std::shared_ptr<SpriteBatch>& spriteBatch, glm::mat4 modelTransform) {
         assert(instance == this && "You can only invoke methods on the currently bound renderpass");
         if (spriteBatch == nullptr) return;
@@ -18,6 +18,7 @@ __declspec(dllexport) int AmdPowerXpressRequestHighPerformance = 1;
 
 #include "sre/Renderer.hpp"
 #include "sre/Framebuffer.hpp"
+#include "sre/GpuTimer.hpp"
 #include "sre/Texture.hpp"
 
 #include "sre/impl/GL.hpp"
@@ -104,6 +105,9 @@ namespace sre {
         renderStats.stateChangesShader = 0;
         renderStats.stateChangesMesh = 0;
         renderStats.stateChangesMaterial = 0;
+        renderStats.objectsVisible = 0;
+        renderStats.objectsCulled = 0;
+        GpuTimer::endFrame();
 #ifndef EMSCRIPTEN
         SDL_GL_SwapWindow(window);
 #endif
@@ -128,4 +132,14 @@ namespace sre {
     bool Renderer::usesVSync() {
         return vsync;
     }
+
+    bool Renderer::setVSync(bool enabled) {
+#ifndef EMSCRIPTEN
+        if (SDL_GL_SetSwapInterval(enabled ? 1 : 0) != 0){
+            return false;
+        }
+        vsync = enabled;
+#endif
+        return true;
+    }
 }
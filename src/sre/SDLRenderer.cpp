@@ -6,10 +6,13 @@
  */
 
 #include <chrono>
+#include <cmath>
 #include <iostream>
+#include <thread>
 #include <sre/imgui_sre.hpp>
 #include <sre/Log.hpp>
 #include "sre/SDLRenderer.hpp"
+#include "sre/ScopeProfiler.hpp"
 #define SDL_MAIN_HANDLED
 
 #ifdef EMSCRIPTEN
@@ -100,7 +103,8 @@ namespace sre{
 #endif
 
     SDLRenderer::SDLRenderer()
-    :frameUpdate ([](float){}),
+    :fixedUpdate ([](float){}),
+     frameUpdate ([](float){}),
      frameRender ([](){}),
      keyEvent ([](SDL_Event&){}),
      mouseEvent ([](SDL_Event&){}),
@@ -173,9 +177,23 @@ namespace sre{
             }
         }
 
+        // Simulate at the fixed rate for the time that passed. If the frame took too long the remaining time is dropped.
+        fixedUpdateTime += deltaTimeSec;
+        int fixedUpdates = 0;
+        while (fixedUpdateTime >= timePerFixedUpdate && fixedUpdates < maxFixedUpdatesPerFrame){
+            fixedUpdate(timePerFixedUpdate);
+            fixedUpdateTime -= timePerFixedUpdate;
+            fixedUpdates++;
+        }
+        if (fixedUpdateTime >= timePerFixedUpdate){
+            fixedUpdateTime = std::fmod(fixedUpdateTime, timePerFixedUpdate);
+        }
+
         frameUpdate(deltaTimeSec);
         frameRender();
 
+        // Waits for vsync and, depending on the driver, for the GPU to catch up.
+        SRE_PROFILE_SCOPE("SDLRenderer::swapWindow");
         r->swapWindow();
     }
 
@@ -247,17 +265,21 @@ namespace sre{
 
             frame(deltaTime);
 
+            // Sleep until the frame has taken timePerFrame. SDL_Delay only has millisecond precision (SDL raises the
+            // timer resolution to 1 ms on Windows), so the last millisecond is spent yielding instead.
+            auto frameEnd = lastTick + std::chrono::duration_cast<Clock::duration>(FpSeconds(timePerFrame));
             auto tick = Clock::now();
-            deltaTime = std::chrono::duration_cast<FpSeconds>(tick - lastTick).count();
-
-            // warn potential busy wait (SDL_Delay may truncate small numbers)
-            // https://forum.lazarus.freepascal.org/index.php?topic=35689.0
-            while (deltaTime < timePerFrame){
-                Uint32 delayMs = static_cast<Uint32>((timePerFrame - deltaTime) / 1000);
-                SDL_Delay(delayMs);
+            while (tick < frameEnd){
+                auto remainingMs = std::chrono::duration_cast<std::chrono::milliseconds>(frameEnd - tick).count();
+                if (remainingMs > 1){
+                    SDL_Delay(static_cast<Uint32>(remainingMs - 1));
+                } else {
+                    std::this_thread::yield();
+                }
                 tick = Clock::now();
-                deltaTime = std::chrono::duration_cast<FpSeconds>(tick - lastTick).count();
             }
+
+            deltaTime = std::chrono::duration_cast<FpSeconds>(tick - lastTick).count();
             lastTick = tick;
         }
 #endif
@@ -267,6 +289,26 @@ namespace sre{
         running = false;
     }
 
+    void SDLRenderer::setFixedUpdateRate(float updatesPerSecond) {
+        timePerFixedUpdate = 1.0f/updatesPerSecond;
+    }
+
+    float SDLRenderer::getFixedUpdateRate() {
+        return 1.0f/timePerFixedUpdate;
+    }
+
+    float SDLRenderer::getFixedUpdateInterpolation() {
+        return fixedUpdateTime/timePerFixedUpdate;
+    }
+
+    void SDLRenderer::setFrameRateLimit(float framesPerSecond) {
+        timePerFrame = framesPerSecond > 0 ? 1.0f/framesPerSecond : 0;
+    }
+
+    float SDLRenderer::getFrameRateLimit() {
+        return timePerFrame > 0 ? 1.0f/timePerFrame : 0;
+    }
+
     void SDLRenderer::setWindowSize(glm::ivec2 size) {
         int width = size.x;
         int height = size.y;
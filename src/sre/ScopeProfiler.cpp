@@ -0,0 +1,198 @@
+/*
+ *  SimpleRenderEngine (https://github.com/mortennobel/SimpleRenderEngine)
+ *
+ *  Created by Morten Nobel-Jørgensen ( http://www.nobel-joergnesen.com/ )
+ *  License: MIT
+ */
+
+#include "sre/ScopeProfiler.hpp"
+#include <algorithm>
+#include <chrono>
+#include <cstdio>
+#include <limits>
+#include <memory>
+#include <mutex>
+
+namespace sre {
+    namespace {
+        // Ring buffer of a single thread. Only the owning thread writes, readers copy the events and then check
+        // whether the thread came around and overwrote them in the meantime.
+        struct ThreadBuffer {
+            int index;
+            std::string name;
+            std::vector<ScopeProfiler::Event> events;   // Allocated with the first event
+            std::atomic<uint64_t> written;              // Events written since the start, the newest is at (written-1) % eventsPerThread
+            int depth = 0;                              // Scopes currently open
+        };
+
+        struct ThreadBuffers {
+            std::mutex mutex;                           // Guards the list, not the buffers
+            std::vector<std::unique_ptr<ThreadBuffer>> buffers; // Kept when a thread ends, so its scopes can still be read
+        };
+
+        ThreadBuffers& getThreadBuffers() {
+            static ThreadBuffers threadBuffers;
+            return threadBuffers;
+        }
+
+        thread_local ThreadBuffer* threadBuffer = nullptr;
+
+        const uint64_t readMargin = 1024;               // Slots a thread may write while its buffer is read, before the read is thrown away
+
+        ThreadBuffer* addThreadBuffer(std::string name) {
+            auto& threadBuffers = getThreadBuffers();
+            std::lock_guard<std::mutex> lock(threadBuffers.mutex);
+            auto buffer = new ThreadBuffer();
+            buffer->index = (int)threadBuffers.buffers.size();
+            buffer->name = name.empty() ? "Thread "+std::to_string(buffer->index) : name;
+            buffer->written = 0;
+            threadBuffers.buffers.emplace_back(buffer);
+            return buffer;
+        }
+
+        ThreadBuffer* getThreadBuffer() {
+            if (threadBuffer == nullptr){
+                threadBuffer = addThreadBuffer("");
+            }
+            return threadBuffer;
+        }
+
+        void write(ThreadBuffer* buffer, const char* name, uint64_t start, uint64_t end) {
+            if (buffer->events.empty()){
+                buffer->events.resize(ScopeProfiler::eventsPerThread);
+            }
+            uint64_t index = buffer->written.load(std::memory_order_relaxed);
+            buffer->events[index % ScopeProfiler::eventsPerThread] = {name, start, end, buffer->index, buffer->depth};
+            buffer->written.store(index + 1, std::memory_order_release);
+        }
+
+        std::string escapeJson(const std::string& s) {
+            std::string res;
+            for (char c : s){
+                if (c == '"' || c == '\\'){
+                    res += '\\';
+                }
+                res += c;
+            }
+            return res;
+        }
+    }
+
+    std::atomic<bool> ScopeProfiler::enabled{false};
+
+    void ScopeProfiler::setEnabled(bool enabled) {
+        ScopeProfiler::enabled.store(enabled, std::memory_order_relaxed);
+    }
+
+    uint64_t ScopeProfiler::now() {
+        return (uint64_t)std::chrono::duration_cast<std::chrono::nanoseconds>(std::chrono::steady_clock::now().time_since_epoch()).count();
+    }
+
+    void ScopeProfiler::setThreadName(std::string name) {
+        auto buffer = getThreadBuffer();
+        std::lock_guard<std::mutex> lock(getThreadBuffers().mutex);
+        buffer->name = name;
+    }
+
+    std::string ScopeProfiler::getThreadName(int thread) {
+        auto& threadBuffers = getThreadBuffers();
+        std::lock_guard<std::mutex> lock(threadBuffers.mutex);
+        if (thread < 0 || thread >= (int)threadBuffers.buffers.size()){
+            return "";
+        }
+        return threadBuffers.buffers[thread]->name;
+    }
+
+    int ScopeProfiler::getThreadCount() {
+        auto& threadBuffers = getThreadBuffers();
+        std::lock_guard<std::mutex> lock(threadBuffers.mutex);
+        return (int)threadBuffers.buffers.size();
+    }
+
+    void ScopeProfiler::begin() {
+        getThreadBuffer()->depth++;
+    }
+
+    void ScopeProfiler::end(const char* name, uint64_t start) {
+        ThreadBuffer* buffer = threadBuffer;
+        buffer->depth--;
+        write(buffer, name, start, now());
+    }
+
+    int ScopeProfiler::addTrack(std::string name) {
+        return addThreadBuffer(name)->index;
+    }
+
+    void ScopeProfiler::addEvent(int track, const char* name, uint64_t start, uint64_t end, int depth) {
+        ThreadBuffer* buffer;
+        {
+            auto& threadBuffers = getThreadBuffers();
+            std::lock_guard<std::mutex> lock(threadBuffers.mutex);
+            buffer = threadBuffers.buffers[track].get();
+        }
+        buffer->depth = depth;
+        write(buffer, name, start, end);
+    }
+
+    void ScopeProfiler::getEvents(uint64_t start, uint64_t end, std::vector<Event>& events) {
+        auto& threadBuffers = getThreadBuffers();
+        std::lock_guard<std::mutex> lock(threadBuffers.mutex);
+        for (auto& buffer : threadBuffers.buffers){
+            uint64_t written = buffer->written.load(std::memory_order_acquire);
+            if (written == 0){
+                continue;
+            }
+
+            // A thread finishes its scopes in order, so walking back from the newest can stop at the first one that ended before start.
+            // The oldest slots are skipped, they are the next ones the thread overwrites.
+            size_t first = events.size();
+            uint64_t oldest = written > eventsPerThread - readMargin ? written - (eventsPerThread - readMargin) : 0;
+            uint64_t lastCopied = written;          // Oldest event number that was copied
+            for (uint64_t index = written; index > oldest; index--){
+                const Event& event = buffer->events[(index - 1) % eventsPerThread];
+                if (event.end < start){
+                    break;
+                }
+                if (event.start <= end){
+                    events.push_back(event);
+                    lastCopied = index - 1;
+                }
+            }
+
+            // If the thread still came around while copying, some copies may be torn. Skip the thread this time.
+            uint64_t writtenAfter = buffer->written.load(std::memory_order_acquire);
+            if (writtenAfter + 1 > lastCopied + eventsPerThread){
+                events.resize(first);
+            }
+        }
+    }
+
+    void ScopeProfiler::writeChromeTrace(std::ostream& out) {
+        std::vector<Event> events;
+        getEvents(0, std::numeric_limits<uint64_t>::max(), events);
+
+        uint64_t origin = std::numeric_limits<uint64_t>::max();
+        for (auto& event : events){
+            origin = std::min(origin, event.start);
+        }
+
+        // Complete events with the time in microseconds, and the thread names as metadata.
+        out << "{\"traceEvents\":[";
+        bool firstEvent = true;
+        int threadCount = getThreadCount();
+        for (int i = 0; i < threadCount; i++){
+            out << (firstEvent ? "\n" : ",\n");
+            out << "{\"name\":\"thread_name\",\"ph\":\"M\",\"pid\":0,\"tid\":" << i << ",\"args\":{\"name\":\"" << escapeJson(getThreadName(i)) << "\"}}";
+            firstEvent = false;
+        }
+        char buffer[128];
+        for (auto& event : events){
+            out << (firstEvent ? "\n" : ",\n");
+            snprintf(buffer, sizeof(buffer), "\"ph\":\"X\",\"pid\":0,\"tid\":%i,\"ts\":%.3f,\"dur\":%.3f}",
+                     event.thread, (event.start - origin) / 1000.0, (event.end - event.start) / 1000.0);
+            out << "{\"name\":\"" << escapeJson(event.name) << "\"," << buffer;
+            firstEvent = false;
+        }
+        out << "\n]}\n";
+    }
+}
@@ -26,6 +26,8 @@ namespace sre {
     namespace {
         std::shared_ptr<Shader> standard;
         std::shared_ptr<Shader> unlit;
+        std::shared_ptr<Shader> standardInstanced;
+        std::shared_ptr<Shader> unlitInstanced;
         std::shared_ptr<Shader> unlitSprite;
         std::shared_ptr<Shader> standardParticles;
 
@@ -448,6 +450,28 @@ namespace sre {
         return unlit;
     }
 
+    std::shared_ptr<Shader> Shader::getStandardInstanced() {
+        if (standardInstanced != nullptr){
+            return standardInstanced;
+        }
+        standardInstanced = create()
+                .withSourceStandardInstanced()
+                .withName("Standard Instanced")
+                .build();
+        return standardInstanced;
+    }
+
+    std::shared_ptr<Shader> Shader::getUnlitInstanced() {
+        if (unlitInstanced != nullptr){
+            return unlitInstanced;
+        }
+        unlitInstanced = create()
+                .withSourceUnlitInstanced()
+                .withName("Unlit Instanced")
+                .build();
+        return unlitInstanced;
+    }
+
     std::shared_ptr<Shader> Shader::getUnlitSprite() {
         if (unlitSprite != nullptr){
             return unlitSprite;
@@ -542,6 +566,9 @@ namespace sre {
     bool Shader::validateMesh(Mesh *mesh, std::string &info) {
         bool valid = true;
         for (auto& shaderVertexAttribute : attributes){
+            if (shaderVertexAttribute.second.type == GL_FLOAT_MAT4){
+                continue; // per instance attribute, supplied by RenderPass::drawInstanced
+            }
             auto meshType = mesh->getType(shaderVertexAttribute.first);
             if (meshType.first == -1){
                 valid = false;
@@ -556,6 +583,8 @@ namespace sre {
                     info += "vec4";
                 } else if (shaderVertexAttribute.second.type == GL_INT_VEC4){
                     info += "ivec4";
+                } else if (shaderVertexAttribute.second.type == GL_UNSIGNED_INT_VEC4){
+                    info += "uvec4";
                 }
                 info += "\n";
             } else {
@@ -714,6 +743,53 @@ void main(void)
         return *this;
     }
 
+    Shader::ShaderBuilder &Shader::ShaderBuilder::withSourceStandardInstanced() {
+        withSourceStandard();
+        // the normal matrix differs per instance, so it is computed here instead of by RenderPass
+        this->vertexShaderStr = R"(#version 140
+in vec3 position;
+in vec3 normal;
+in vec4 uv;
+in mat4 instanceTransform;
+out vec3 vNormal;
+out vec2 vUV;
+out vec3 vEyePos;
+
+uniform mat4 g_view;
+uniform mat4 g_projection;
+
+void main(void) {
+    mat4 modelView = g_view * instanceTransform;
+    vec4 eyePos = modelView * vec4(position,1.0);
+    gl_Position = g_projection * eyePos;
+    vNormal = normalize(transpose(inverse(mat3(modelView))) * normal);
+    vUV = uv.xy;
+    vEyePos = eyePos.xyz;
+}
+)";
+        return *this;
+    }
+
+    Shader::ShaderBuilder &Shader::ShaderBuilder::withSourceUnlitInstanced() {
+        withSourceUnlit();
+        this->vertexShaderStr = R"(#version 140
+in vec3 position;
+in vec3 normal;
+in vec4 uv;
+in mat4 instanceTransform;
+out vec2 vUV;
+
+uniform mat4 g_view;
+uniform mat4 g_projection;
+
+void main(void) {
+    gl_Position = g_projection * g_view * instanceTransform * vec4(position,1.0);
+    vUV = uv.xy;
+}
+)";
+        return *this;
+    }
+
     Shader::ShaderBuilder &Shader::ShaderBuilder::withSourceUnlitSprite() {
         this->vertexShaderStr = R"(#version 140
         in vec3 position;
@@ -40,6 +40,7 @@
 #endif
 
 #include "sre/Log.hpp"
+#include "sre/TextureLoader.hpp"
 
 // anonymous (file local) namespace
 namespace {
@@ -142,16 +143,17 @@ namespace {
 
     std::vector<char> loadFileFromMemory(const char* data, int dataSize, GLenum& format, bool & alpha,int& width, int& height, int& bytesPerPixel, bool invertY = true){
 #ifndef EMSCRIPTEN
-        static bool initialized = false;
-        if (!initialized) {
-            initialized = true;
+        // initialized once, also when the first textures are decoded on several threads at the same time
+        static bool initialized = [](){
             int flags = IMG_INIT_PNG;
             int initted = IMG_Init(flags);
             if ((initted & flags) != flags) {
                 LOG_ERROR("IMG_Init: Failed to init required png support!\nIMG_Init() returned %s",IMG_GetError());
                 // handle error
             }
-        }
+            return true;
+        }();
+        (void)initialized;
 #endif
 
         SDL_RWops *source = SDL_RWFromConstMem(data, dataSize);
@@ -268,6 +270,17 @@ namespace sre {
         return *this;
     }
 
+    Texture::TextureBuilder &Texture::TextureBuilder::withFileAsync(std::string filename, TextureLoader* loader) {
+        if (name.length()==0){
+            name = filename;
+        }
+        asyncFilename = filename;
+        asyncLoader = loader;
+        // placeholder until the file is loaded
+        withWhiteData();
+        return *this;
+    }
+
     Texture::TextureBuilder &Texture::TextureBuilder::withFileCubemap(std::string filename, TextureCubemapSide side){
         auto fileData = readAllBytes(filename.c_str());
         GLenum format;
@@ -332,15 +345,22 @@ namespace sre {
             name = "Unnamed Texture";
         }
         Texture * res = new Texture(textureId, width, height, target, name);
-        res->generateMipmap = this->generateMipmaps;
-		res->transparent = this->transparent;
-        if (this->generateMipmaps){
+        // the placeholder of an async texture has no mipmaps, the loader creates them with the real pixels
+        bool placeholderOnly = asyncLoader != nullptr;
+        res->generateMipmap = this->generateMipmaps && !placeholderOnly;
+		res->transparent = this->transparent && !placeholderOnly;
+        if (res->generateMipmap){
             res->invokeGenerateMipmap();
         }
         res->updateTextureSampler(filterSampling, wrapTextureCoordinates);
 		
         textureId = 0;
-        return std::shared_ptr<Texture>(res);
+        auto texture = std::shared_ptr<Texture>(res);
+        if (asyncLoader != nullptr){
+            texture->loading = true;
+            asyncLoader->load(texture, asyncFilename, generateMipmaps, filterSampling, wrapTextureCoordinates);
+        }
+        return texture;
     }
 
 	Texture::TextureBuilder &Texture::TextureBuilder::withWhiteData(int width, int height) {
@@ -525,4 +545,48 @@ namespace sre {
     bool Texture::isMipmapped() {
         return generateMipmap;
     }
+
+    void Texture::updateRGBAData(const char* data, int x, int y, int width, int height) {
+        if (target != GL_TEXTURE_2D || x < 0 || y < 0 || x + width > this->width || y + height > this->height){
+            LOG_ERROR("Texture %s cannot update region %i,%i %ix%i",name.c_str(), x, y, width, height);
+            return;
+        }
+        glBindTexture(target, textureId);
+        glTexSubImage2D(target, 0, x, y, width, height, GL_RGBA, GL_UNSIGNED_BYTE, data);
+        if (generateMipmap){
+            glGenerateMipmap(target);
+        }
+    }
+
+    bool Texture::isLoading() {
+        return loading;
+    }
+
+    void Texture::replaceStorage(unsigned int textureId, int width, int height, bool mipmapped, bool transparent) {
+        int oldDataSize = getDataSize();
+        glDeleteTextures(1, &this->textureId);
+        this->textureId = textureId;
+        this->width = width;
+        this->height = height;
+        this->generateMipmap = mipmapped;
+        this->transparent = transparent;
+        loading = false;
+
+        // update stats
+        int dataSize = getDataSize();
+        RenderStats& renderStats = Renderer::instance->renderStats;
+        renderStats.textureBytes += dataSize - oldDataSize;
+        renderStats.textureBytesAllocated += dataSize;
+        renderStats.textureBytesDeallocated += oldDataSize;
+    }
+
+    bool Texture::decodeFile(const std::string& filename, bool invertY, std::vector<char>& pixels, int& width, int& height, int& bytesPerPixel, bool& transparent) {
+        auto fileData = readAllBytes(filename.c_str());
+        if (fileData.empty()){
+            return false;
+        }
+        GLenum format;
+        pixels = loadFileFromMemory(fileData.data(), (int) fileData.size(), format, transparent, width, height, bytesPerPixel, invertY);
+        return !pixels.empty();
+    }
 }
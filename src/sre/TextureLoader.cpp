@@ -0,0 +1,339 @@
+/*
+ *  SimpleRenderEngine (https://github.com/mortennobel/SimpleRenderEngine)
+ *
+ *  Created by Morten Nobel-Jørgensen ( http://www.nobel-joergnesen.com/ )
+ *  License: MIT
+ */
+
+#include "sre/TextureLoader.hpp"
+#include <algorithm>
+#include <atomic>
+#include <cmath>
+#include <condition_variable>
+#include <cstring>
+#include <mutex>
+#include <vector>
+#include "sre/Texture.hpp"
+#include "sre/Renderer.hpp"
+#include "sre/ScopeProfiler.hpp"
+#include "sre/Log.hpp"
+#include "sre/impl/GL.hpp"
+
+#ifndef GL_SRGB_ALPHA
+#define GL_SRGB_ALPHA 0x8C42
+#endif
+#ifndef GL_SRGB
+#define GL_SRGB 0x8C40
+#endif
+
+namespace sre {
+    namespace {
+        struct MipLevel {
+            int width;
+            int height;
+            std::vector<char> pixels;
+        };
+
+        bool isPowerOfTwo(int x) {
+            return x > 0 && (x & (x - 1)) == 0;
+        }
+
+        // The textures are stored as sRGB, so the colors are averaged as linear values.
+        float srgbToLinear(int value) {
+            static const std::vector<float> table = [](){
+                std::vector<float> res(256);
+                for (int i=0;i<256;i++){
+                    float c = i / 255.0f;
+                    res[i] = c <= 0.04045f ? c / 12.92f : std::pow((c + 0.055f) / 1.055f, 2.4f);
+                }
+                return res;
+            }();
+            return table[value];
+        }
+
+        unsigned char linearToSrgb(float value) {
+            float c = value <= 0.0031308f ? value * 12.92f : 1.055f * std::pow(value, 1.0f / 2.4f) - 0.055f;
+            return (unsigned char)std::round(std::min(std::max(c, 0.0f), 1.0f) * 255.0f);
+        }
+
+        // Halves a level with a box filter, a side of one pixel stays one pixel.
+        MipLevel downsample(const MipLevel& level, int bytesPerPixel) {
+            MipLevel res;
+            res.width = std::max(level.width / 2, 1);
+            res.height = std::max(level.height / 2, 1);
+            res.pixels.resize(res.width * res.height * bytesPerPixel);
+            auto src = reinterpret_cast<const unsigned char*>(level.pixels.data());
+            auto dst = reinterpret_cast<unsigned char*>(res.pixels.data());
+            for (int y=0;y<res.height;y++){
+                int y0 = std::min(y * 2, level.height - 1);
+                int y1 = std::min(y * 2 + 1, level.height - 1);
+                for (int x=0;x<res.width;x++){
+                    int x0 = std::min(x * 2, level.width - 1);
+                    int x1 = std::min(x * 2 + 1, level.width - 1);
+                    const unsigned char* p[4] = {
+                        src + (y0 * level.width + x0) * bytesPerPixel,
+                        src + (y0 * level.width + x1) * bytesPerPixel,
+                        src + (y1 * level.width + x0) * bytesPerPixel,
+                        src + (y1 * level.width + x1) * bytesPerPixel
+                    };
+                    unsigned char* out = dst + (y * res.width + x) * bytesPerPixel;
+                    for (int c=0;c<bytesPerPixel;c++){
+                        if (c == 3){
+                            out[c] = (unsigned char)((p[0][c] + p[1][c] + p[2][c] + p[3][c] + 2) / 4);
+                        } else {
+                            out[c] = linearToSrgb((srgbToLinear(p[0][c]) + srgbToLinear(p[1][c]) + srgbToLinear(p[2][c]) + srgbToLinear(p[3][c])) * 0.25f);
+                        }
+                    }
+                }
+            }
+            return res;
+        }
+    }
+
+    struct TextureLoader::Request {
+        std::weak_ptr<Texture> texture;         // Not kept alive by the loader, a texture dropped while loading is skipped
+        std::string filename;
+        bool generateMipmaps;
+        bool filterSampling;
+        bool wrapTextureCoordinates;
+
+        // Filled in by the decoding job
+        bool decoded = false;
+        bool powerOfTwo = false;
+        bool transparent = false;
+        int bytesPerPixel = 4;
+        std::vector<MipLevel> levels;
+
+        // Progress of the upload
+        unsigned int textureId = 0;
+        int level = 0;
+        int row = 0;
+    };
+
+    struct TextureLoader::State {
+        std::mutex mutex;
+        std::deque<std::shared_ptr<Request>> decoded;   // Waiting for the render thread
+        std::atomic<int> pending{0};
+
+        // Jobs of the own worker thread, when no job runner is given
+        std::deque<std::function<void()>> jobs;
+        std::condition_variable wakeUp;
+        bool running = true;
+    };
+
+    void TextureLoader::decode(Request& request) {
+        SRE_PROFILE_SCOPE("TextureLoader::decode");
+        MipLevel level;
+        if (!Texture::decodeFile(request.filename, true, level.pixels, level.width, level.height, request.bytesPerPixel, request.transparent)){
+            return;
+        }
+        request.powerOfTwo = isPowerOfTwo(level.width) && isPowerOfTwo(level.height);
+        request.levels.push_back(std::move(level));
+        if (request.generateMipmaps && request.powerOfTwo){
+            while (request.levels.back().width > 1 || request.levels.back().height > 1){
+                auto next = downsample(request.levels.back(), request.bytesPerPixel);
+                request.levels.push_back(std::move(next));
+            }
+        }
+        request.decoded = true;
+    }
+
+    void TextureLoader::workerLoop(std::shared_ptr<State> state) {
+        ScopeProfiler::setThreadName("Texture loader");
+        while (true){
+            std::function<void()> job;
+            {
+                std::unique_lock<std::mutex> lock(state->mutex);
+                state->wakeUp.wait(lock, [&]{ return !state->running || !state->jobs.empty(); });
+                if (!state->running){
+                    return;
+                }
+                job = std::move(state->jobs.front());
+                state->jobs.pop_front();
+            }
+            job();
+        }
+    }
+
+    TextureLoader::TextureLoader(JobRunner runJob)
+        :runJob(std::move(runJob)), state(std::make_shared<State>())
+    {
+        if (!this->runJob){
+            worker = std::thread(workerLoop, state);
+            auto jobState = state;
+            this->runJob = [jobState](std::function<void()> job){
+                {
+                    std::lock_guard<std::mutex> lock(jobState->mutex);
+                    jobState->jobs.push_back(std::move(job));
+                }
+                jobState->wakeUp.notify_one();
+            };
+        }
+    }
+
+    TextureLoader::~TextureLoader() {
+        if (worker.joinable()){
+            {
+                std::lock_guard<std::mutex> lock(state->mutex);
+                state->running = false;
+                state->jobs.clear();
+            }
+            state->wakeUp.notify_one();
+            worker.join();
+        }
+        if (Renderer::instance != nullptr){
+            for (auto& request : uploads){
+                if (request->textureId != 0){
+                    glDeleteTextures(1, &request->textureId);
+                }
+            }
+#ifndef EMSCRIPTEN
+            if (pixelBuffer != 0){
+                glDeleteBuffers(1, &pixelBuffer);
+            }
+#endif
+        }
+    }
+
+    void TextureLoader::load(std::shared_ptr<Texture> texture, std::string filename, bool generateMipmaps, bool filterSampling, bool wrapTextureCoordinates) {
+        auto request = std::make_shared<Request>();
+        request->texture = texture;
+        request->filename = filename;
+        request->generateMipmaps = generateMipmaps;
+        request->filterSampling = filterSampling;
+        request->wrapTextureCoordinates = wrapTextureCoordinates;
+        state->pending++;
+
+        auto jobState = state;
+        runJob([jobState, request](){
+            decode(*request);
+            std::lock_guard<std::mutex> lock(jobState->mutex);
+            jobState->decoded.push_back(request);
+        });
+    }
+
+    void TextureLoader::update() {
+        SRE_PROFILE_SCOPE("TextureLoader::update");
+        {
+            std::lock_guard<std::mutex> lock(state->mutex);
+            for (auto& request : state->decoded){
+                uploads.push_back(request);
+            }
+            state->decoded.clear();
+        }
+
+        int budget = uploadBudget;
+        while (!uploads.empty() && budget > 0){
+            Request& request = *uploads.front();
+            auto texture = request.texture.lock();
+            if (texture == nullptr || !request.decoded){
+                if (texture != nullptr){
+                    LOG_ERROR("Cannot load texture %s", request.filename.c_str());
+                    texture->loading = false;
+                }
+                if (request.textureId != 0){
+                    glDeleteTextures(1, &request.textureId);
+                }
+                uploads.pop_front();
+                state->pending--;
+                continue;
+            }
+
+            budget -= upload(request, budget);
+            if (request.level == (int)request.levels.size()){
+                finish(*texture, request);
+                uploads.pop_front();
+                state->pending--;
+            }
+        }
+    }
+
+    int TextureLoader::upload(Request& request, int budget) {
+#ifdef EMSCRIPTEN
+        GLenum internalFormat = request.bytesPerPixel == 4 ? GL_RGBA : GL_RGB;
+#else
+        GLenum internalFormat = request.bytesPerPixel == 4 ? GL_SRGB_ALPHA : GL_SRGB;
+#endif
+        GLenum format = request.bytesPerPixel == 4 ? GL_RGBA : GL_RGB;
+
+        // The storage of all levels is created up front, the rows are filled in over the next frames.
+        if (request.textureId == 0){
+            glGenTextures(1, &request.textureId);
+            glBindTexture(GL_TEXTURE_2D, request.textureId);
+            for (int i=0;i<(int)request.levels.size();i++){
+                auto& level = request.levels[i];
+                glTexImage2D(GL_TEXTURE_2D, i, internalFormat, level.width, level.height, 0, format, GL_UNSIGNED_BYTE, nullptr);
+            }
+#ifndef EMSCRIPTEN
+            glTexParameteri(GL_TEXTURE_2D, GL_TEXTURE_MAX_LEVEL, (GLint)request.levels.size() - 1);
+#endif
+        }
+
+        auto& level = request.levels[request.level];
+        int rowBytes = level.width * request.bytesPerPixel;
+        int rows = std::min(level.height - request.row, std::max(budget / rowBytes, 1));
+        int bytes = rows * rowBytes;
+        const char* pixels = level.pixels.data() + request.row * rowBytes;
+
+        glBindTexture(GL_TEXTURE_2D, request.textureId);
+        glPixelStorei(GL_UNPACK_ALIGNMENT, 1);  // rows of RGB pixels are not padded
+#ifdef EMSCRIPTEN
+        glTexSubImage2D(GL_TEXTURE_2D, request.level, 0, request.row, level.width, rows, format, GL_UNSIGNED_BYTE, pixels);
+#else
+        // The copy to the texture runs from the pixel buffer, without the driver holding up the frame. Reallocating
+        // the buffer each time lets the driver hand out fresh memory while the previous slice is still being read.
+        if (pixelBuffer == 0){
+            glGenBuffers(1, &pixelBuffer);
+        }
+        glBindBuffer(GL_PIXEL_UNPACK_BUFFER, pixelBuffer);
+        glBufferData(GL_PIXEL_UNPACK_BUFFER, bytes, nullptr, GL_STREAM_DRAW);
+        void* mapped = glMapBufferRange(GL_PIXEL_UNPACK_BUFFER, 0, bytes, GL_MAP_WRITE_BIT | GL_MAP_INVALIDATE_BUFFER_BIT);
+        if (mapped != nullptr){
+            memcpy(mapped, pixels, (size_t)bytes);
+            glUnmapBuffer(GL_PIXEL_UNPACK_BUFFER);
+            glTexSubImage2D(GL_TEXTURE_2D, request.level, 0, request.row, level.width, rows, format, GL_UNSIGNED_BYTE, nullptr);
+            glBindBuffer(GL_PIXEL_UNPACK_BUFFER, 0);
+        } else {
+            glBindBuffer(GL_PIXEL_UNPACK_BUFFER, 0);
+            glTexSubImage2D(GL_TEXTURE_2D, request.level, 0, request.row, level.width, rows, format, GL_UNSIGNED_BYTE, pixels);
+        }
+#endif
+        glPixelStorei(GL_UNPACK_ALIGNMENT, 4);
+
+        request.row += rows;
+        if (request.row == level.height){
+            // The pixels of a finished level are not needed anymore
+            std::vector<char>().swap(level.pixels);
+            request.level++;
+            request.row = 0;
+        }
+        return bytes;
+    }
+
+    void TextureLoader::finish(Texture& texture, Request& request) {
+        bool filterSampling = request.filterSampling;
+        if (!request.powerOfTwo && filterSampling){
+            LOG_WARNING("Texture %s is not power of two (was %i x %i ). filter sampling ",request.filename.c_str(), request.levels[0].width, request.levels[0].height);
+            filterSampling = false;
+        }
+        if (!request.powerOfTwo && request.generateMipmaps){
+            LOG_WARNING("Texture %s is not power of two (was %i x %i ). mipmapping disabled ",request.filename.c_str(), request.levels[0].width, request.levels[0].height);
+        }
+
+        texture.replaceStorage(request.textureId, request.levels[0].width, request.levels[0].height, request.levels.size() > 1, request.transparent);
+        texture.updateTextureSampler(filterSampling, request.wrapTextureCoordinates);
+        request.textureId = 0;
+    }
+
+    void TextureLoader::setUploadBudget(int bytesPerFrame) {
+        uploadBudget = bytesPerFrame;
+    }
+
+    int TextureLoader::getUploadBudget() {
+        return uploadBudget;
+    }
+
+    int TextureLoader::getPendingCount() {
+        return state->pending;
+    }
+}
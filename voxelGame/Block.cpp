@@ -1,6 +1,6 @@
 #include "Block.hpp"
-#include "Physics.hpp"
-#include "Game.hpp"
+#include "Chunk.hpp"
+#include "World.hpp"
 
 
 
@@ -8,157 +8,68 @@ Block::Block() {
 }
 
 
-Block::Block(BlockType type, glm::vec3 position) {
-	// Set the type of the block
-	setType(type);
-	this->position = position;
+Block::Block(Chunk* chunk, int x, int y, int z) 
+	: chunk(chunk), x(x), y(y), z(z) {
 }
 
 
-Block::~Block() {
-	removeColliderFromWorld();
-
-	if(rigidbody != nullptr){
-		delete rigidbody->getMotionState();
-		delete rigidbody;
-	}
-	if(collider != nullptr){
-		delete collider;
-	}
-}
-
-
-void Block::initCollider() {
-	// Setup the physics, but do not add it to the world yet. 
-	// Just have it ready for when we need it.
-	collider = new btBoxShape(btVector3(0.5f, 0.5f, 0.5f));
-
-	btScalar mass(0);
-	btTransform transform;
-	transform.setIdentity();
-	transform.setOrigin(btVector3(btScalar(position.x), btScalar(position.y), btScalar(position.z)));
-	btVector3 localInertia(0, 0, 0);
-	btDefaultMotionState* myMotionState = new btDefaultMotionState(transform);
-	btRigidBody::btRigidBodyConstructionInfo cInfo(mass, myMotionState, collider, localInertia);
-	rigidbody = new btRigidBody(cInfo);
+bool Block::isActive() {
+	return chunk->getBlockId(x, y, z) != AIR_BLOCK_ID;
 }
 
 
-void Block::addColliderToWorld() {
-	// Only add rigidbodies for blocks that are active and not yet in the physics world.
-	if (active && !inPhysicsWorld){
-		Game::getInstance()->getPhysics()->addRigidBody(rigidbody);
-		inPhysicsWorld = true;
-	}
+BlockType Block::getType() {
+	return blockTypeFromId(chunk->getBlockId(x, y, z));
 }
 
 
-void Block::removeColliderFromWorld() {
-	// Only remove rigidbodies for blocks that are in the physics world.
-	if(inPhysicsWorld){
-		Game::getInstance()->getPhysics()->removeRigidBody(rigidbody);
-		inPhysicsWorld = false;
-	}
+glm::vec3 Block::getPosition() {
+	return chunk->getPosition() + glm::vec3(x, y, z);
 }
 
 
 void Block::setType(BlockType type) {
-	this->type = type;
+	// Air has no type, a block only gets a type when it is activated.
+	if (!isActive())
+		return;
+
+	chunk->setBlockId(x, y, z, blockIdFromType(type));
 }
 
 
-void Block::setActive(bool active) {
+void Block::setActive(bool active, BlockType type) {
 	// If the block is already in the correct state, we do not have to do anything.
-	if(this->active == active)
+	if(isActive() == active)
 		return;
 
 	// Bedrock cannot be deactivated, therefore stop if this is  bedrock.
-	if (type == BlockType::Bedrock)
+	if (!active && getType() == BlockType::Bedrock)
 		return;
 
-	// If this is grass see if there is something above, if so turn into dirt since grass needs air
-	if(type == BlockType::Grass){
-		Block* b = Game::getInstance()->locationToBlock(position.x, position.y + 1, position.z, true);
+	glm::vec3 position = getPosition();
 
-		// If there is a block above us and it is active, this grass must turn into dirt.
-		if (b != nullptr && b->isActive()) {
-				type = BlockType::Dirt;
-		}
-	}
-	
 	// If block below is grass turn it into dirt, since now there is something on top.
-	auto b = Game::getInstance()->locationToBlock(position.x, position.y - 1, position.z, false);
-	if (b != nullptr && active && b->isActive() && b->getType() == BlockType::Grass){
-		b->setType(BlockType::Dirt);
+	World* world = chunk->getWorld();
+	Block below = world->locationToBlock(position.x, position.y - 1, position.z, false);
+	if (below.isValid() && active && below.isActive() && below.getType() == BlockType::Grass){
+		below.setType(BlockType::Dirt);
 	}
 
-	// Set the activation state
-	this->active = active;
+	// If this becomes grass see if there is something above, if so turn into dirt since grass needs air
+	if (active && type == BlockType::Grass) {
+		Block above = world->locationToBlock(position.x, position.y + 1, position.z, true);
 
-	// If the block is activated, add its collider back to the world.
-	if(active){
-		addColliderToWorld();
-	}
-	// Else if the block is deactivated, remove the collider form the world.
-	else {
-		removeColliderFromWorld();
-		Game::getInstance()->placeParticleSystem(position);
+		// If there is a block above us and it is active, this grass must turn into dirt.
+		if (above.isValid() && above.isActive()) {
+			type = BlockType::Dirt;
+		}
 	}
-}
 
+	// Set the activation state, air does not store a type.
+	chunk->setBlockId(x, y, z, active ? blockIdFromType(type) : AIR_BLOCK_ID);
 
-int Block::getTextureIndex(BlockType type, BlockSides side){
-	switch (type) {
-		case BlockType::Stone:
-			return 0;
-		case BlockType::Brick:
-			return 1;
-		case BlockType::Dirt:
-			return 9;
-		case BlockType::Gravel:
-			return 25;
-		case BlockType::Rock:
-			return 50;
-		case BlockType::IronOre:
-			return 51;
-		case BlockType::CoalOre:
-			return 53;
-		case BlockType::DiamondOre:
-			return 55;
-		case BlockType::Planks:
-			return 83;
-		case BlockType::Bedrock:
-			return 27;
-		case BlockType::Glass:
-			return 16;
-		case BlockType::Grass:
-			switch (side) {
-			case BlockSides::Top:
-				return 23;
-			case BlockSides::Bottom:
-				return 9;
-			default:
-				return 10;
-			}
-		case BlockType::Wood:
-			switch (side) {
-			case BlockSides::Top:
-				return 75;
-			case BlockSides::Bottom:
-				return 75;
-			default:
-				return 74;
-			}
-		case BlockType::WorkBench:
-			switch (side) {
-			case BlockSides::Top:
-				return 67;
-			case BlockSides::Bottom:
-				return 83;
-			default:
-				return 83;
-			}
-		default:
-			return 0;
+	// If the block is deactivated, let the world know so it can show some particles where it used to be.
+	if (!active && world->getListener() != nullptr) {
+		world->getListener()->onBlockRemoved(position);
 	}
-}
\ No newline at end of file
+}
@@ -1,46 +1,51 @@
 /*
 * Block - Created: 31-11-2017
 * This class represents a block in the world. All edges of a block are one unit.
+* A block is a lightweight handle into the packed block storage of the chunk it lives in,
+* the block data itself is owned by the chunk.
 */
 #pragma once
 
-#include "btBulletDynamicsCommon.h"
-#include "sre/SDLRenderer.hpp"
+#include <cstdint>
+#include <glm/glm.hpp>
 
 
 
 // Types of blocks
-enum BlockType { Stone, Brick, Grass, Dirt, Gravel, Rock, Wood, Planks, Bedrock, Glass, WorkBench, IronOre, CoalOre, DiamondOre, LENGTH }; 
+enum BlockType { Stone, Brick, Grass, Dirt, Gravel, Rock, Wood, Planks, Bedrock, Glass, WorkBench, IronOre, CoalOre, DiamondOre, LENGTH };
 
 // Faces of a cube
 enum BlockSides {Top, Bottom, Left, Right, Front, Back };
 
+// Packed block id as stored in a chunk. 0 is air (an inactive block), every other value is a BlockType + 1.
+typedef uint8_t BlockId;
+const BlockId AIR_BLOCK_ID = 0;
 
-class Game;
+inline BlockId blockIdFromType(BlockType type) { return (BlockId)(type + 1); }
+inline BlockType blockTypeFromId(BlockId id) { return id == AIR_BLOCK_ID ? BlockType::Dirt : (BlockType)(id - 1); }
+
+
+class Chunk;
 class Block {
 public:
-	Block();
-	Block(BlockType type, glm::vec3 position);
-	~Block();
+	Block();											// Creates an invalid block, used when there is no block at a location.
+	Block(Chunk* chunk, int x, int y, int z);			// Creates a handle to the block at local chunk coordinates x, y, z.
 
 	// This returns the correct texture index for a block type and the correct side.
 	static int getTextureIndex(BlockType type, BlockSides side = BlockSides::Top);
 
-	void addColliderToWorld();			// Adds the rigidbody of this box to the physics world.
-	void removeColliderFromWorld();		// Removes the rigidbody of this box from the physics world.
-	void initCollider();				// Initializes the collider for this box.
+	void setType(BlockType type);						// Changes the type of an active block.
+	void setActive(bool active, BlockType type = BlockType::Dirt);	// (De)activates the block. When activated the block becomes the passed in type.
+	bool isActive();
+	bool isValid() { return chunk != nullptr; }			// Whether this handle points to an actual block.
+	BlockType getType();
+	glm::vec3 getPosition();							// World position of this block
 
-	void setType(BlockType type);				
-	void setActive(bool active);
-	bool isActive() { return active; }
-	BlockType getType() { return type; }
-	glm::vec3 getPosition() { return position; }
+	bool operator==(const Block& other) const { return chunk == other.chunk && x == other.x && y == other.y && z == other.z; }
+	bool operator!=(const Block& other) const { return !(*this == other); }
 private:
-	btRigidBody* rigidbody = nullptr;	// Rigidbody of this block
-	btBoxShape* collider =  nullptr;	// The cube collider of this block
-
-	bool active = true;					// Whether the block is active (displayed / exists in the world).
-	bool inPhysicsWorld = false;		// Whether the rigidbody has been added to the physics world.
-	BlockType type = BlockType::Dirt;	// Current type of block.
-	glm::vec3 position;					// World position of this block
-};
\ No newline at end of file
+	Chunk* chunk = nullptr;		// Chunk that stores this block
+	int x = 0;					// Local coordinates of this block inside the chunk
+	int y = 0;
+	int z = 0;
+};
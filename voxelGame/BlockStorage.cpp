@@ -0,0 +1,225 @@
+#include "BlockStorage.hpp"
+#include <algorithm>
+
+
+
+BlockStorage::BlockStorage() {
+}
+
+
+BlockStorage::BlockStorage(int blockCount) 
+	: blockCount(blockCount) {
+	collapse(AIR_BLOCK_ID);
+}
+
+
+void BlockStorage::set(int index, BlockId id) {
+	BlockId current = get(index);
+	if (current == id)
+		return;
+
+	// Find the palette entry for the new id, adding it (and widening the indices if necessary) when it is new.
+	int paletteIndex = paletteIndexOf(id);
+	if (paletteIndex == -1) {
+		paletteIndex = addToPalette(id);
+	}
+
+	// A collapsed storage has to be expanded before individual blocks can differ.
+	if (bitsPerBlock == 0) {
+		resize(1);
+	}
+
+	counts[paletteIndexOf(current)]--;
+	counts[paletteIndex]++;
+	writeIndex(index, paletteIndex);
+
+	// If every block now has the same id, there is no need to store the indices anymore.
+	if (counts[paletteIndex] == blockCount) {
+		collapse(id);
+	}
+}
+
+
+void BlockStorage::fill(BlockId id) {
+	collapse(id);
+}
+
+
+void BlockStorage::pack(const BlockId* ids) {
+	// Build the palette of all distinct ids first, so we know the width before writing anything.
+	palette.clear();
+	counts.clear();
+	int lookup[256];
+	std::fill(lookup, lookup + 256, -1);
+	for (int i = 0; i < blockCount; i++) {
+		if (lookup[ids[i]] == -1) {
+			lookup[ids[i]] = (int)palette.size();
+			palette.push_back(ids[i]);
+			counts.push_back(0);
+		}
+		counts[lookup[ids[i]]]++;
+	}
+
+	if (palette.size() == 1) {
+		collapse(palette[0]);
+		return;
+	}
+
+	int bits = 1;
+	while ((1u << bits) < palette.size())
+		bits *= 2;
+
+	bitsPerBlock = bits;
+	data.assign((blockCount * bitsPerBlock + 31) / 32, 0);
+	for (int i = 0; i < blockCount; i++) {
+		writeIndex(i, lookup[ids[i]]);
+	}
+}
+
+
+void BlockStorage::unpack(BlockId* ids) const {
+	if (bitsPerBlock == 0) {
+		std::fill(ids, ids + blockCount, palette[0]);
+		return;
+	}
+
+	for (int i = 0; i < blockCount; i++) {
+		ids[i] = palette[readIndex(i)];
+	}
+}
+
+
+void BlockStorage::serialize(std::vector<uint8_t>& bytes) const {
+	// Layout: bits per block, palette size (2 bytes), the palette, then the packed words in little endian.
+	bytes.clear();
+	bytes.push_back((uint8_t)bitsPerBlock);
+	bytes.push_back((uint8_t)(palette.size() & 0xFF));
+	bytes.push_back((uint8_t)(palette.size() >> 8));
+	bytes.insert(bytes.end(), palette.begin(), palette.end());
+
+	for (uint32_t word : data) {
+		for (int i = 0; i < 4; i++) {
+			bytes.push_back((uint8_t)(word >> (i * 8)));
+		}
+	}
+}
+
+
+bool BlockStorage::deserialize(const uint8_t* bytes, size_t size) {
+	if (size < 3)
+		return false;
+
+	int bits = bytes[0];
+	size_t paletteSize = bytes[1] | (bytes[2] << 8);
+	size_t wordCount = bits == 0 ? 0 : (blockCount * bits + 31) / 32;
+
+	// Reject anything that does not describe a storage of our size.
+	if ((bits != 0 && bits != 1 && bits != 2 && bits != 4 && bits != 8) || paletteSize == 0 || paletteSize > 256)
+		return false;
+	if ((bits == 0 && paletteSize != 1) || (bits != 0 && paletteSize > (1u << bits)))
+		return false;
+	if (size != 3 + paletteSize + wordCount * 4)
+		return false;
+
+	std::vector<BlockId> newPalette(bytes + 3, bytes + 3 + paletteSize);
+	std::vector<uint32_t> newData(wordCount);
+	const uint8_t* words = bytes + 3 + paletteSize;
+	for (size_t w = 0; w < wordCount; w++) {
+		newData[w] = words[w * 4] | (words[w * 4 + 1] << 8) | (words[w * 4 + 2] << 16) | ((uint32_t)words[w * 4 + 3] << 24);
+	}
+
+	// Count the blocks per palette entry, which also catches indices pointing outside the palette.
+	std::vector<uint16_t> newCounts(paletteSize, 0);
+	if (bits == 0) {
+		newCounts[0] = (uint16_t)blockCount;
+	} else {
+		uint32_t mask = (1u << bits) - 1;
+		for (int i = 0; i < blockCount; i++) {
+			int bit = i * bits;
+			uint32_t paletteIndex = (newData[bit >> 5] >> (bit & 31)) & mask;
+			if (paletteIndex >= paletteSize)
+				return false;
+			newCounts[paletteIndex]++;
+		}
+	}
+
+	bitsPerBlock = bits;
+	palette.swap(newPalette);
+	counts.swap(newCounts);
+	data.swap(newData);
+	return true;
+}
+
+
+int BlockStorage::getPaletteSize() const {
+	return (int)std::count_if(counts.begin(), counts.end(), [](uint16_t count) { return count > 0; });
+}
+
+
+int BlockStorage::getMemoryUsage() const {
+	return (int)(sizeof(BlockStorage) 
+		+ palette.capacity() * sizeof(BlockId) 
+		+ counts.capacity() * sizeof(uint16_t) 
+		+ data.capacity() * sizeof(uint32_t));
+}
+
+
+int BlockStorage::paletteIndexOf(BlockId id) const {
+	for (int i = 0; i < (int)palette.size(); i++) {
+		if (palette[i] == id && counts[i] > 0)
+			return i;
+	}
+	return -1;
+}
+
+
+int BlockStorage::addToPalette(BlockId id) {
+	// Reuse an entry that no block points to anymore.
+	for (int i = 0; i < (int)palette.size(); i++) {
+		if (counts[i] == 0) {
+			palette[i] = id;
+			return i;
+		}
+	}
+
+	palette.push_back(id);
+	counts.push_back(0);
+
+	// Widen the indices when the palette no longer fits in the current width.
+	int bits = std::max(bitsPerBlock, 1);
+	while ((1u << bits) < palette.size())
+		bits *= 2;
+	if (bits != bitsPerBlock && bitsPerBlock != 0) {
+		resize(bits);
+	}
+
+	return (int)palette.size() - 1;
+}
+
+
+void BlockStorage::resize(int bits) {
+	std::vector<uint32_t> oldData;
+	oldData.swap(data);
+	int oldBits = bitsPerBlock;
+
+	bitsPerBlock = bits;
+	data.assign((blockCount * bitsPerBlock + 31) / 32, 0);
+
+	// A collapsed storage only has palette entry 0, which is what the zeroed indices already point to.
+	if (oldBits == 0)
+		return;
+
+	uint32_t oldMask = (1u << oldBits) - 1;
+	for (int i = 0; i < blockCount; i++) {
+		int bit = i * oldBits;
+		writeIndex(i, (oldData[bit >> 5] >> (bit & 31)) & oldMask);
+	}
+}
+
+
+void BlockStorage::collapse(BlockId id) {
+	bitsPerBlock = 0;
+	palette.assign(1, id);
+	counts.assign(1, (uint16_t)blockCount);
+	std::vector<uint32_t>().swap(data);
+}
@@ -0,0 +1,66 @@
+/*
+* BlockStorage - Created: 16-10-2026
+* Palette compressed storage of the block ids of a chunk. Every chunk keeps a palette of the block ids it contains,
+* and stores per block an index into that palette, bit packed at 1, 2, 4 or 8 bits. The width grows automatically
+* when a new id is added, and a storage which only holds a single id collapses to just that value.
+* The position of a block is derived from its index so no per block data has to be stored.
+*/
+#pragma once
+
+#include <vector>
+#include <cstdint>
+#include "Block.hpp"
+
+
+
+class BlockStorage {
+public:
+	BlockStorage();
+	explicit BlockStorage(int blockCount);	// Creates a storage of blockCount blocks which are all air.
+
+	BlockId get(int index) const;			// Returns the block id at index.
+	void set(int index, BlockId id);		// Sets the block id at index, grows the palette and bit width when necessary.
+	void fill(BlockId id);					// Sets all blocks to the same id, which collapses the storage to a single value.
+
+	void pack(const BlockId* ids);			// Replaces all blocks with the size() ids passed in, using the smallest width that fits.
+	void unpack(BlockId* ids) const;		// Decodes all blocks into the size() ids passed in.
+
+	// Writes the palette and packed indices as bytes, the compressed form is stored as is so saving needs no extra encoding.
+	void serialize(std::vector<uint8_t>& bytes) const;
+	// Restores the blocks from serialized bytes. Returns false and leaves the storage untouched when the bytes are not valid.
+	bool deserialize(const uint8_t* bytes, size_t size);
+
+	int size() const { return blockCount; }					// Number of blocks in the storage.
+	int getBitsPerBlock() const { return bitsPerBlock; }	// Bits used per block, 0 when the storage holds a single value.
+	int getPaletteSize() const;								// Number of distinct block ids in the storage.
+	int getMemoryUsage() const;								// Bytes used to store the blocks.
+private:
+	int paletteIndexOf(BlockId id) const;	// Returns the palette index of an id or -1 when it is not in the palette.
+	int addToPalette(BlockId id);			// Adds the id to the palette (reusing unused entries) and returns its index.
+	void resize(int bits);					// Repacks all palette indices using the passed in amount of bits.
+	void collapse(BlockId id);				// Drops the packed indices, all blocks are the passed in id.
+
+	int readIndex(int index) const {
+		int bit = index * bitsPerBlock;
+		return (data[bit >> 5] >> (bit & 31)) & ((1u << bitsPerBlock) - 1);
+	}
+	void writeIndex(int index, int paletteIndex) {
+		int bit = index * bitsPerBlock;
+		uint32_t mask = ((1u << bitsPerBlock) - 1) << (bit & 31);
+		data[bit >> 5] = (data[bit >> 5] & ~mask) | ((uint32_t)paletteIndex << (bit & 31));
+	}
+
+	int blockCount = 0;
+	int bitsPerBlock = 0;				// 0, 1, 2, 4 or 8. Since these divide 32 a block never straddles two words.
+	std::vector<BlockId> palette;		// The block ids stored, palette[0] is the value when the storage is collapsed.
+	std::vector<uint16_t> counts;		// Number of blocks using each palette entry. An entry with 0 blocks can be reused.
+	std::vector<uint32_t> data;			// Bit packed palette indices.
+};
+
+
+inline BlockId BlockStorage::get(int index) const {
+	if (bitsPerBlock == 0)
+		return palette[0];
+
+	return palette[readIndex(index)];
+}
@@ -0,0 +1,60 @@
+#include "Block.hpp"
+
+// Kept apart from the rest of Block, which needs the game, so tools like the voxel benchmark can mesh chunks without it.
+
+
+int Block::getTextureIndex(BlockType type, BlockSides side){
+	switch (type) {
+		case BlockType::Stone:
+			return 0;
+		case BlockType::Brick:
+			return 1;
+		case BlockType::Dirt:
+			return 9;
+		case BlockType::Gravel:
+			return 25;
+		case BlockType::Rock:
+			return 50;
+		case BlockType::IronOre:
+			return 51;
+		case BlockType::CoalOre:
+			return 53;
+		case BlockType::DiamondOre:
+			return 55;
+		case BlockType::Planks:
+			return 83;
+		case BlockType::Bedrock:
+			return 27;
+		case BlockType::Glass:
+			return 16;
+		case BlockType::Grass:
+			switch (side) {
+			case BlockSides::Top:
+				return 23;
+			case BlockSides::Bottom:
+				return 9;
+			default:
+				return 10;
+			}
+		case BlockType::Wood:
+			switch (side) {
+			case BlockSides::Top:
+				return 75;
+			case BlockSides::Bottom:
+				return 75;
+			default:
+				return 74;
+			}
+		case BlockType::WorkBench:
+			switch (side) {
+			case BlockSides::Top:
+				return 67;
+			case BlockSides::Bottom:
+				return 83;
+			default:
+				return 83;
+			}
+		default:
+			return 0;
+	}
+}
\ No newline at end of file
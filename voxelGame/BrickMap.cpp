@@ -0,0 +1,200 @@
+#include "BrickMap.hpp"
+
+
+
+bool BrickMap::getBrick(glm::ivec3 chunkPosition, BlockStorage& brick) const {
+	const Node* leaf = findLeaf(chunkPosition);
+	if (leaf == nullptr || leaf->state == NodeState::Unknown)
+		return false;
+
+	if (leaf->state == NodeState::Uniform)
+		brick.fill(leaf->value);
+	else
+		brick = bricks[leaf->index];
+	return true;
+}
+
+
+void BrickMap::setBrick(glm::ivec3 chunkPosition, const BlockStorage& brick) {
+	// A storage of a single value already collapsed, so there is no need to keep it around.
+	if (brick.getBitsPerBlock() == 0)
+		setLeaf(chunkPosition, NodeState::Uniform, brick.get(0), nullptr);
+	else
+		setLeaf(chunkPosition, NodeState::Brick, AIR_BLOCK_ID, &brick);
+}
+
+
+void BrickMap::removeBrick(glm::ivec3 chunkPosition) {
+	const Node* leaf = findLeaf(chunkPosition);
+	if (leaf != nullptr && leaf->state != NodeState::Unknown)
+		setLeaf(chunkPosition, NodeState::Unknown, AIR_BLOCK_ID, nullptr);
+}
+
+
+void BrickMap::removeOutside(glm::ivec3 minChunk, glm::ivec3 maxChunk) {
+	for (auto it = roots.begin(); it != roots.end();) {
+		clip(-1, &it->second, it->first * rootSize, rootSize, minChunk, maxChunk);
+
+		if (it->second.state == NodeState::Unknown)
+			it = roots.erase(it);
+		else
+			it++;
+	}
+}
+
+
+size_t BrickMap::getMemoryUsage() const {
+	size_t bytes = roots.size() * (sizeof(glm::ivec3) + sizeof(Node)) + nodes.capacity() * sizeof(Node);
+	for (auto& brick : bricks) {
+		bytes += brick.getMemoryUsage();
+	}
+	return bytes;
+}
+
+
+const BrickMap::Node* BrickMap::findLeaf(glm::ivec3 chunkPosition) const {
+	glm::ivec3 rootPosition = toRootPosition(chunkPosition);
+	auto it = roots.find(rootPosition);
+	if (it == roots.end())
+		return nullptr;
+
+	// Walk down until a node that is not split, which may be far above the chunk when the region is uniform.
+	glm::ivec3 local = chunkPosition - rootPosition * rootSize;
+	const Node* node = &it->second;
+	for (int level = rootLevels - 1; node->state == NodeState::Split; level--) {
+		node = &nodes[node->index + childIndex(local, level)];
+	}
+	return node;
+}
+
+
+void BrickMap::setLeaf(glm::ivec3 chunkPosition, NodeState state, BlockId value, const BlockStorage* brick) {
+	glm::ivec3 rootPosition = toRootPosition(chunkPosition);
+	glm::ivec3 local = chunkPosition - rootPosition * rootSize;
+	Node* root = &roots[rootPosition];
+
+	// Split the nodes down to the chunk, remembering the way so the nodes can be merged again on the way back.
+	int path[rootLevels];
+	int current = -1;
+	for (int level = rootLevels - 1; level >= 0; level--) {
+		if (nodeAt(current, root).state != NodeState::Split)
+			split(current, root);
+
+		path[level] = current;
+		current = nodeAt(current, root).index + childIndex(local, level);
+	}
+
+	Node& leaf = nodes[current];
+	if (state == NodeState::Brick) {
+		// Reuse the brick the chunk already had, or a freed one.
+		if (leaf.state != NodeState::Brick) {
+			if (freeBricks.empty()) {
+				leaf.index = (int32_t)bricks.size();
+				bricks.push_back(*brick);
+			} else {
+				leaf.index = freeBricks.back();
+				freeBricks.pop_back();
+				bricks[leaf.index] = *brick;
+			}
+		} else {
+			bricks[leaf.index] = *brick;
+		}
+	} else {
+		release(leaf);
+	}
+	leaf.state = state;
+	leaf.value = value;
+
+	for (int level = 0; level < rootLevels; level++) {
+		if (!tryCollapse(path[level], root))
+			break;
+	}
+
+	if (root->state == NodeState::Unknown)
+		roots.erase(rootPosition);
+}
+
+
+void BrickMap::split(int index, Node* root) {
+	int group;
+	if (freeGroups.empty()) {
+		group = (int)nodes.size();
+		nodes.resize(nodes.size() + 8);
+	} else {
+		group = freeGroups.back();
+		freeGroups.pop_back();
+	}
+
+	// Look the node up after growing nodes, since that may have moved it.
+	Node& node = nodeAt(index, root);
+	for (int i = 0; i < 8; i++) {
+		nodes[group + i] = node;
+	}
+
+	node.state = NodeState::Split;
+	node.index = group;
+}
+
+
+bool BrickMap::tryCollapse(int index, Node* root) {
+	Node& node = nodeAt(index, root);
+	const Node* children = &nodes[node.index];
+
+	if (children[0].state != NodeState::Unknown && children[0].state != NodeState::Uniform)
+		return false;
+
+	for (int i = 1; i < 8; i++) {
+		if (children[i].state != children[0].state || (children[0].state == NodeState::Uniform && children[i].value != children[0].value))
+			return false;
+	}
+
+	Node merged = children[0];
+	release(node);
+	node = merged;
+	return true;
+}
+
+
+void BrickMap::clip(int index, Node* root, glm::ivec3 first, int extent, glm::ivec3 minChunk, glm::ivec3 maxChunk) {
+	glm::ivec3 last = first + glm::ivec3(extent - 1);
+
+	// Nodes completely inside are kept, nodes completely outside are dropped.
+	if (glm::all(glm::greaterThanEqual(first, minChunk)) && glm::all(glm::lessThanEqual(last, maxChunk)))
+		return;
+
+	if (glm::any(glm::lessThan(last, minChunk)) || glm::any(glm::greaterThan(first, maxChunk))) {
+		release(nodeAt(index, root));
+		return;
+	}
+
+	// The box cuts through this node, which can only happen above single chunks.
+	if (nodeAt(index, root).state == NodeState::Unknown)
+		return;
+
+	if (nodeAt(index, root).state != NodeState::Split)
+		split(index, root);
+
+	int group = nodeAt(index, root).index;
+	int half = extent / 2;
+	for (int i = 0; i < 8; i++) {
+		clip(group + i, root, first + childOffset(i) * half, half, minChunk, maxChunk);
+	}
+
+	tryCollapse(index, root);
+}
+
+
+void BrickMap::release(Node& node) {
+	if (node.state == NodeState::Split) {
+		for (int i = 0; i < 8; i++) {
+			release(nodes[node.index + i]);
+		}
+		freeGroups.push_back(node.index);
+	} else if (node.state == NodeState::Brick) {
+		// Drop the blocks right away, the brick itself is reused by the next mixed chunk.
+		bricks[node.index] = BlockStorage();
+		freeBricks.push_back(node.index);
+	}
+
+	node = Node();
+}
@@ -0,0 +1,66 @@
+/*
+* BrickMap - Created: 16-10-2026
+* Sparse storage of the blocks of chunks that are kept in memory without being loaded. Every chunk is a brick of
+* chunkSize^3 blocks, and bricks are grouped in octrees of rootSize^3 chunks. A node whose chunks all hold the same
+* single block id, like open sky or solid rock, is stored as just that id, so such regions cost a single node.
+*/
+#pragma once
+
+#include <unordered_map>
+#include <vector>
+#include <glm/glm.hpp>
+#include "Chunk.hpp"
+#include "BlockStorage.hpp"
+
+
+
+class BrickMap {
+public:
+	const static int rootLevels = 4;				// Levels of the octree below a root
+	const static int rootSize = 1 << rootLevels;	// Chunks along every axis of a root
+
+	bool getBrick(glm::ivec3 chunkPosition, BlockStorage& brick) const;	// Copies the blocks of a chunk into brick, false when the chunk is not in the map
+
+	void setBrick(glm::ivec3 chunkPosition, const BlockStorage& brick);	// Stores the blocks of a chunk, a brick of a single id is stored as just that id
+	void removeBrick(glm::ivec3 chunkPosition);							// Drops the blocks of a chunk
+	void removeOutside(glm::ivec3 minChunk, glm::ivec3 maxChunk);		// Drops all chunks outside the box of chunk coordinates, inclusive
+
+	int getBrickCount() const { return (int)(bricks.size() - freeBricks.size()); }	// Chunks stored with their blocks
+	int getNodeCount() const { return (int)(roots.size() + nodes.size() - freeGroups.size() * 8); }
+	size_t getMemoryUsage() const;		// Bytes used by the nodes and bricks
+private:
+	enum class NodeState : uint8_t {
+		Unknown,	// Nothing stored for these chunks
+		Uniform,	// All blocks are value
+		Split,		// index is the first of the eight children
+		Brick		// A single chunk, index is its brick
+	};
+
+	struct Node {
+		int32_t index = -1;
+		BlockId value = AIR_BLOCK_ID;
+		NodeState state = NodeState::Unknown;
+	};
+
+	// Children are ordered x first, then y, then z.
+	static int childIndex(glm::ivec3 local, int level) { return ((local.x >> level) & 1) | (((local.y >> level) & 1) << 1) | (((local.z >> level) & 1) << 2); }
+	static glm::ivec3 childOffset(int child) { return glm::ivec3(child & 1, (child >> 1) & 1, (child >> 2) & 1); }
+	static int floorDivide(int value) { return value >= 0 ? value / rootSize : -((-value + rootSize - 1) / rootSize); }
+	static glm::ivec3 toRootPosition(glm::ivec3 chunk) { return glm::ivec3(floorDivide(chunk.x), floorDivide(chunk.y), floorDivide(chunk.z)); }
+
+	// Nodes are referred to by index, -1 being the root passed along. Indices stay valid when nodes grows, references do not.
+	Node& nodeAt(int index, Node* root) { return index < 0 ? *root : nodes[index]; }
+
+	const Node* findLeaf(glm::ivec3 chunkPosition) const;	// The node which holds the chunk, null when there is no root for it
+	void setLeaf(glm::ivec3 chunkPosition, NodeState state, BlockId value, const BlockStorage* brick);
+	void split(int index, Node* root);						// Gives a uniform or unknown node eight children in the same state
+	bool tryCollapse(int index, Node* root);				// Merges the children back when they are all unknown or the same uniform value
+	void clip(int index, Node* root, glm::ivec3 first, int extent, glm::ivec3 minChunk, glm::ivec3 maxChunk);
+	void release(Node& node);								// Frees the children and brick of a node, leaving it unknown
+
+	std::unordered_map<glm::ivec3, Node, ChunkPositionHash> roots;	// By chunk coordinates divided by rootSize
+	std::vector<Node> nodes;			// Groups of eight children
+	std::vector<int> freeGroups;		// First index of groups that can be reused
+	std::vector<BlockStorage> bricks;
+	std::vector<int> freeBricks;
+};
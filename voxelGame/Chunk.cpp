@@ -1,378 +1,319 @@
 #include "Chunk.hpp"
-#include "Game.hpp"
+#include "World.hpp"
+#include "ChunkMesher.hpp"
+#include "TerrainGenerator.hpp"
+#include "VoxelShape.hpp"
+#include "btBulletDynamicsCommon.h"
+#include "sre/ScopeProfiler.hpp"
+#include <algorithm>
 #include <glm/glm.hpp>
 #include <glm/gtc/type_ptr.hpp>
-#include <string>
 
-
-Chunk::Chunk() { 
-}
+// Every segment of the mesh has a bit in the changed segments mask.
+static_assert(ChunkMesher::segmentCount <= 64, "Chunk mesh segments do not fit the changed segments mask");
 
 
-Chunk::Chunk(glm::vec3 position){
-	//Set the position of the chunk
-	this->position = position;
-	chunkTransform = glm::translate(position);
-	
-	// Create the block array for this chunk.
-	blocksInChunk = new Block**[chunkSize];
-	for (int x = 0; x < chunkSize; x++){
-		blocksInChunk[x] = new Block*[chunkSize];
-		for (int y = 0; y < chunkSize; y++) {
-			blocksInChunk[x][y] = new Block[chunkSize];		
-			for (int z = 0; z < chunkSize; z++) {
-				// Set blocktype based on height.
-				// Bedrock on world Y = 0.
-				if (position.y + y == 0) {
-					blocksInChunk[x][y][z] = Block(BlockType::Bedrock, glm::vec3(position.x + x, position.y + y, position.z + z));
-				} 
-				// Rock and ores on world Y for 1 to 2.
-				else if (position.y + y <= 2) {
-					int p = rand() % 5;
-
-					if(p == 0)
-						blocksInChunk[x][y][z] = Block(BlockType::IronOre, glm::vec3(position.x + x, position.y + y, position.z + z));
-					else if(p == 1)
-						blocksInChunk[x][y][z] = Block(BlockType::CoalOre, glm::vec3(position.x + x, position.y + y, position.z + z));
-					else
-						blocksInChunk[x][y][z] = Block(BlockType::Rock, glm::vec3(position.x + x, position.y + y, position.z + z));					
-				} 
-				// At world Y of chunkSize - 1 we place grass.
-				else if (position.y + y == chunkSize - 1) {
-					blocksInChunk[x][y][z] = Block(BlockType::Grass, glm::vec3(position.x + x, position.y + y, position.z + z));
-				} 
-				// In all other cases we place dirt and gravel.
-				else {
-					int p = rand() % 3;
-
-					if (p == 0)
-						blocksInChunk[x][y][z] = Block(BlockType::Gravel, glm::vec3(position.x + x, position.y + y, position.z + z));
-					else
-						blocksInChunk[x][y][z] = Block(BlockType::Dirt, glm::vec3(position.x + x, position.y + y, position.z + z));
-				}
+Chunk::Chunk(World* world)
+	: world(world), blocks(blockCount) {
+	createCollider();
+}
 
-				// If this is not the bottom chunk, deactivate the blocks so it acts as air in which we can place blocks.
-				if (position.y + y >= chunkSize) {
-					blocksInChunk[x][y][z].setActive(false);
-				}
 
-				// Initialize the collider pointers for the block.
-				blocksInChunk[x][y][z].initCollider();
-			}
-		}
-	}
+Chunk::Chunk(World* world, glm::vec3 position)
+	: world(world), blocks(blockCount) {
+	createCollider();
+	reset(position);
+	generateBlocks();
 }
 
 
 Chunk::~Chunk(){
-	for (int i = 0; i < chunkSize; ++i){
-		for (int j = 0; j < chunkSize; ++j){
-			delete[] blocksInChunk[i][j];
-		}
-		delete[] blocksInChunk[i];
-	}
-	delete[] blocksInChunk;
+	removeCollidersFromWorld();
+	releaseMesh();
+	delete collider;
+	delete shape;
 }
 
 
-void Chunk::update(float dt) {
-	// If the flag is raised to recalculate the mesh, generate it.
-	if (recalculateMesh)
-		generateMesh();
-}
-
+void Chunk::reset(glm::vec3 position) {
+	//Set the position of the chunk
+	this->position = position;
+	chunkPosition = toChunkCoordinates(glm::ivec3(position));
+
+	// Whatever mesh we had belongs to the previous blocks, a new one is generated on the next update.
+	releaseMesh();
+	meshTask = nullptr;
+	generateTask = nullptr;
+	faceCount = 0;
+	quadCount = 0;
+	meshLod = 0;
+	connectivity = ~(uint64_t)0;
+	segments.clear();
+	changedSegments = 0;
+	recalculateMesh = true;
 
-void Chunk::draw(sre::RenderPass& renderpass) {
-	// If for some reason we do not have a mesh, generate one immediately!
-	if (mesh == nullptr) {
-		generateMesh();
-		std::cout << "Chunk (" << position.x / chunkSize << ", " << position.y / chunkSize << ", " << position.z / chunkSize << ") had no mesh, calculating one now!" << std::endl;
-	}
-		
-	// Draw mesh of this chunk.
-	renderpass.draw(mesh, chunkTransform, Game::getInstance()->getBlockMaterial());
+	blocks.fill(AIR_BLOCK_ID);
+	dirty = false;
 }
 
 
-// # TODO better function name
-void Chunk::generateMesh() {
-	std::cout << "Recalculating mesh for chunk (" << position.x / chunkSize << ", " << position.y / chunkSize << ", " << position.z / chunkSize << ")." << std::endl;
+void Chunk::generateBlocks() {
+	// Generated chunks are only saved once a block in them changes.
+	dirty = false;
 
-	std::vector<glm::vec3> vertexPositions;
-	std::vector<glm::vec4> uvCoords;
-	std::vector<glm::vec3> normals;
+	// The generator fills a task on the job pool. When the chunk is unloaded before it finishes, the result is dropped.
+	auto task = std::make_shared<ChunkGenerateTask>();
+	auto generator = world->getTerrainGenerator();
+	glm::ivec3 position = chunkPosition;
+	generateTask = task;
+
+	world->getJobPool()->submit([task, generator, position]() {
+		SRE_PROFILE_SCOPE("TerrainGenerator::generate");
+		generator->generate(position, task->blocks);
+		task->done = true;
+	});
+}
 
-	// Calculate vertex positions, UV coordinates and normals.
-	calculateMesh(vertexPositions, uvCoords, normals);
 
-	// Create the chunk  mesh.
-	mesh = sre::Mesh::create()
-				.withPositions(vertexPositions)
-				.withUVs(uvCoords)
-				.withName("Chunk_" + std::to_string(position.x) + '_' + std::to_string(position.y) + '_' + std::to_string(position.z))
-				.withNormals(normals)
-				.build();
+void Chunk::setBlocks(const BlockStorage& storage) {
+	generateTask = nullptr;
+	blocks = storage;
+	dirty = false;
+	recalculateMesh = true;
+}
 
-	// Clean up after we used them.
-	vertexPositions.clear();
-	uvCoords.clear();
-	normals.clear();
 
-	// Lower the flag for recalculation, since we just did that.
-	recalculateMesh = false;
+void Chunk::unload() {
+	// Release everything that is not needed while the chunk waits in the pool.
+	removeCollidersFromWorld();
+	releaseMesh();
+	meshTask = nullptr;
+	generateTask = nullptr;
+	segments.clear();
+	changedSegments = 0;
+	blocks.fill(AIR_BLOCK_ID);
+	dirty = false;
 }
 
 
-// # TODO better function name
-void Chunk::calculateMesh(std::vector<glm::vec3>& vertexPositions, std::vector<glm::vec4>& uvCoords, std::vector<glm::vec3>& normals) {
-	// Flags for what sides should be drawn, by default faces should be drawn unless told otherwise.
-	bool left = true;  
-	bool right = true; 
-	bool bottom = true; 
-	bool top = true; 
-	bool front = true;
-	bool back = true;
-
-	// Loop over all blocks in this chunk, and see what sides should be added to  the mesh
-	for (int x = 0; x < chunkSize; x++){
-		for (int y = 0; y < chunkSize; y++){
-			for (int z = 0; z < chunkSize; z++){
-
-				// If the block is not activated, it not displayed so skip it alltogether.
-				if (blocksInChunk[x][y][z].isActive() == false)
-					continue;
-
-				// Check if there is a block left of us (either in this chunk or the chunk next to us if were on an edge), ifso we do not need to show our left side.
-				if (x > 0) {
-					left = !blocksInChunk[x - 1][y][z].isActive();
-				} else {
-					auto b = Game::getInstance()->locationToBlock(position.x + x - 1, position.y + y, position.z + z, true);
-					if (b != nullptr){
-						left = !b->isActive();
-					}
-				}
+void Chunk::update(float dt) {
+	// Nothing to mesh until the terrain is generated. Once it is, the neighbours have to cull their faces against it.
+	if (generateTask != nullptr) {
+		if (!generateTask->done)
+			return;
+
+		blocks.pack(generateTask->blocks);
+		generateTask = nullptr;
+		recalculateMesh = true;
+		world->flagNeighbourChunksForRecalculate(chunkPosition);
+	}
 
-				// Check if there is a block right of us (either in this chunk or the chunk next to us if were on an edge), ifso we do not need to show our left side.
-				if (x < chunkSize - 1){
-					right = !blocksInChunk[x + 1][y][z].isActive();
-				} else {
-					auto b = Game::getInstance()->locationToBlock(position.x + x + 1, position.y + y, position.z + z, true);
-					if (b != nullptr){
-						right = !b->isActive();
-					}
-				}
+	// Upload the mesh once the job pool finished it.
+	if (meshTask != nullptr && meshTask->done) {
+		meshLod = meshTask->lod;
+		uploadMesh(meshTask->mesh);
+		meshTask = nullptr;
+	}
 
-				// Check if there is a block below us (either in this chunk or the chunk next to us if were on an edge), ifso we do not need to show our left side.
-				if (y > 0) {
-					bottom = !blocksInChunk[x][y - 1][z].isActive();
-				} else {
-					auto b = Game::getInstance()->locationToBlock(position.x + x, position.y + y - 1, position.z + z, true);
-					if (b != nullptr){
-						bottom = !b->isActive();
-					}
-				}
-					
-				// Check if there is a block above us (either in this chunk or the chunk next to us if were on an edge), ifso we do not need to show our left side.
-				if (y < chunkSize - 1) {
-					top = !blocksInChunk[x][y + 1][z].isActive();
-				} else {
-					auto b = Game::getInstance()->locationToBlock(position.x + x, position.y + y + 1, position.z + z, true);
-					if (b != nullptr){
-						top = !b->isActive();
-					}
-				}
-				
-				// Check if there is a block in front of us (either in this chunk or the chunk next to us if were on an edge), ifso we do not need to show our left side.
-				if (z > 0) {
-					front = !blocksInChunk[x][y][z - 1].isActive();
-				} else {
-					auto b = Game::getInstance()->locationToBlock(position.x + x, position.y + y, position.z + z - 1, true);
-					if (b != nullptr) {
-						front = !b->isActive();
-					}
-				}
-					
-				// Check if there is a block behind us (either in this chunk or the chunk next to us if were on an edge), ifso we do not need to show our left side.
-				if (z < chunkSize - 1) {
-					back = !blocksInChunk[x][y][z + 1].isActive();
-				} else {
-					auto b = Game::getInstance()->locationToBlock(position.x + x, position.y + y, position.z + z + 1, true);
-					if(b != nullptr){
-						back = !b->isActive();
-					}
-				} 
-					
-				// Now that we have determined which sides should be added to the mesh, call the function which addes them.
-				addToMesh(glm::vec3(x, y, z), blocksInChunk[x][y][z].getType(), left, right, bottom, top, front, back, vertexPositions, uvCoords, normals);
-
-				// Reset the flags for the next loop
-				left = true;
-				right = true;
-				bottom = true;
-				top = true;
-				front = true;
-				back = true;
-			}
-		}
+	// If the flag is raised to recalculate the mesh, or another level of detail is wanted, generate it. Changed blocks only remesh
+	// the segments around them, unless there is no full detail mesh yet or a rebuild is already running on an older snapshot.
+	int pendingLod = meshTask != nullptr ? meshTask->lod : meshLod;
+	if (recalculateMesh || pendingLod != lod) {
+		generateMesh();
+	} else if (changedSegments != 0) {
+		if (arenaVertex < 0 || meshTask != nullptr || meshLod != 0)
+			generateMesh();
+		else
+			updateSegments();
 	}
 }
 
 
-// # TODO find proper name for function
-void Chunk::addToMesh(	glm::vec3 position, BlockType type, bool left, bool right, bool bottom, bool top, bool front, bool back, 
-						std::vector<glm::vec3>& vertexPositions, std::vector<glm::vec4>& uvCoords, std::vector<glm::vec3>& normals) {
-
-	// Store points for all corners of the cube
-	glm::vec3 p1 = glm::vec3(position.x - 0.5, position.y - 0.5, position.z + 0.5);
-	glm::vec3 p2 = glm::vec3(position.x + 0.5, position.y - 0.5, position.z + 0.5);
-	glm::vec3 p3 = glm::vec3(position.x + 0.5, position.y + 0.5, position.z + 0.5);
-	glm::vec3 p4 = glm::vec3(position.x - 0.5, position.y + 0.5, position.z + 0.5);
-	glm::vec3 p5 = glm::vec3(position.x + 0.5, position.y - 0.5, position.z - 0.5);
-	glm::vec3 p6 = glm::vec3(position.x - 0.5, position.y - 0.5, position.z - 0.5);
-	glm::vec3 p7 = glm::vec3(position.x - 0.5, position.y + 0.5, position.z - 0.5);
-	glm::vec3 p8 = glm::vec3(position.x + 0.5, position.y + 0.5, position.z - 0.5);
-
-	// Used to store the UV coordinates for this side.
-	glm::vec4 uvs;
-
-	// Check al sides and add vertex positions, uv coordinates and normals where necessary.
-	if (left) {
-		vertexPositions.insert(vertexPositions.end(), {
-			p6,p1,p4,
-			p6,p4,p7
-		});
-
-		uvs = textureCoordinates(Block::getTextureIndex(type, BlockSides::Left));
-		uvCoords.insert(uvCoords.end(), {
-			glm::vec4(uvs.x,uvs.w,0,0), glm::vec4(uvs.z,uvs.w,0,0), glm::vec4(uvs.z,uvs.y,0,0),
-			glm::vec4(uvs.x,uvs.w,0,0), glm::vec4(uvs.z,uvs.y,0,0), glm::vec4(uvs.x,uvs.y,0,0),
-		});
-
-		normals.insert(normals.end(), {
-			glm::vec3(-1, 0, 0), glm::vec3(-1, 0, 0), glm::vec3(-1, 0, 0),
-			glm::vec3(-1, 0, 0), glm::vec3(-1, 0, 0), glm::vec3(-1, 0, 0)
-		});
-	}
+void Chunk::draw() {
+	// The first mesh of this chunk is still being generated, or there is nothing to draw.
+	if (arenaVertex < 0)
+		return;
+		
+	// Draw mesh of this chunk, together with all other chunks of the renderer.
+	world->getRenderer()->addDraw(arenaVertex, arenaQuads);
+}
+
+
+// # TODO better function name
+void Chunk::generateMesh() {
+	SRE_PROFILE_SCOPE("Chunk::generateMesh");
+
+	// Take a snapshot of the blocks and let the job pool mesh it. A task that is still running for an older snapshot
+	// is replaced, its result is dropped when it finishes.
+	auto task = std::make_shared<ChunkMeshTask>();
+	snapshotBlocks(task->paddedBlocks);
+	task->greedy = world->isGreedyMeshing();
+	task->lod = lod;
+	meshTask = task;
+
+	world->getJobPool()->submit([task]() {
+		SRE_PROFILE_SCOPE("ChunkMesher::calculateMesh");
+		if (task->lod == 0)
+			ChunkMesher::calculateMesh(task->paddedBlocks, task->greedy, task->mesh);
+		else
+			ChunkMesher::calculateLodMesh(task->paddedBlocks, task->lod, task->greedy, task->mesh);
+		task->mesh.connectivity = ChunkMesher::calculateConnectivity(task->paddedBlocks);
+		task->done = true;
+	});
+
+	// Lower the flag for recalculation, since we just did that. The snapshot also covers all changed segments.
+	recalculateMesh = false;
+	changedSegments = 0;
+}
 
 
-	if (right) {
-		vertexPositions.insert(vertexPositions.end(), {
-			p2,p5,p8,
-			p2,p8,p3
-		});
+void Chunk::uploadMesh(ChunkMeshData& meshData) {
+	SRE_PROFILE_SCOPE("Chunk::uploadMesh");
 
-		uvs = textureCoordinates(Block::getTextureIndex(type, BlockSides::Right));
-		uvCoords.insert(uvCoords.end(), {
-			glm::vec4(uvs.x,uvs.w,0,0), glm::vec4(uvs.z,uvs.w,0,0), glm::vec4(uvs.z,uvs.y,0,0),
-			glm::vec4(uvs.x,uvs.w,0,0), glm::vec4(uvs.z,uvs.y,0,0), glm::vec4(uvs.x,uvs.y,0,0),
-		});
+	// Keep track of how much merging saved, shown in the world statistics.
+	faceCount = meshData.faceCount;
+	quadCount = meshData.quadCount;
+	connectivity = meshData.connectivity;
 
-		normals.insert(normals.end(), {
-			glm::vec3(1, 0, 0), glm::vec3(1, 0, 0), glm::vec3(1, 0, 0),
-			glm::vec3(1, 0, 0), glm::vec3(1, 0, 0), glm::vec3(1, 0, 0)
-		});
+	// Chunks that are all air or completely enclosed have nothing to draw, they do not get a mesh at all.
+	// Neither do chunks of a world without a renderer, those only keep the statistics and connectivity.
+	releaseMesh();
+	if (quadCount == 0 || world->getRenderer() == nullptr) {
+		segments.clear();
+		return;
 	}
 
-	
-	if (bottom) {
-		vertexPositions.insert(vertexPositions.end(), {
-			p6,p5,p2,
-			p6,p2,p1
-		});
-
-		uvs = textureCoordinates(Block::getTextureIndex(type, BlockSides::Bottom));
-		uvCoords.insert(uvCoords.end(), {
-			glm::vec4(uvs.x,uvs.y,0,0), glm::vec4(uvs.z,uvs.y,0,0), glm::vec4(uvs.z,uvs.w,0,0),
-			glm::vec4(uvs.x,uvs.y,0,0), glm::vec4(uvs.z,uvs.w,0,0), glm::vec4(uvs.x,uvs.w,0,0),
-		});
-
-		normals.insert(normals.end(), {
-			glm::vec3(0, -1, 0), glm::vec3(0, -1, 0), glm::vec3(0, -1, 0),
-			glm::vec3(0, -1, 0), glm::vec3(0, -1, 0), glm::vec3(0, -1, 0)
-		});
+	// Lay the segments out one after another, each with room for a few more quads. The unused room is filled with
+	// degenerate quads, which have all corners on the same point so nothing is drawn for them.
+	// Meshes at a lower level of detail are always rebuilt as a whole, so they get no room.
+	segments.resize(ChunkMesher::segmentCount);
+	int capacity = 0;
+	for (int s = 0; s < ChunkMesher::segmentCount; s++) {
+		int quads = meshData.segmentQuads[s];
+		int room = meshLod == 0 ? quads / 4 + 2 : 0;
+		segments[s] = { capacity, quads + room, quads, meshData.segmentFaces[s] };
+		capacity += segments[s].capacity;
 	}
 
+	std::vector<glm::u8vec4> positions(capacity * 4, glm::u8vec4(0));
+	std::vector<glm::u8vec4> tiles(capacity * 4, glm::u8vec4(0));
+	int source = 0;
+	for (auto& segment : segments) {
+		std::copy(meshData.positions.begin() + source * 4, meshData.positions.begin() + (source + segment.quads) * 4, positions.begin() + segment.firstQuad * 4);
+		std::copy(meshData.tiles.begin() + source * 4, meshData.tiles.begin() + (source + segment.quads) * 4, tiles.begin() + segment.firstQuad * 4);
+		source += segment.quads;
+	}
 
-	if (top) {
-		vertexPositions.insert(vertexPositions.end(), {
-			p4,p3,p8,
-			p4,p8,p7
-		});
+	// Hand the chunk mesh to the renderer of the world.
+	arenaVertex = world->getRenderer()->allocate(chunkPosition, positions, tiles);
+	arenaQuads = capacity;
+}
 
-		uvs = textureCoordinates(Block::getTextureIndex(type, BlockSides::Top));
-		uvCoords.insert(uvCoords.end(), {
-			glm::vec4(uvs.x,uvs.y,0,0), glm::vec4(uvs.z,uvs.y,0,0), glm::vec4(uvs.z,uvs.w,0,0),
-			glm::vec4(uvs.x,uvs.y,0,0), glm::vec4(uvs.z,uvs.w,0,0), glm::vec4(uvs.x,uvs.w,0,0),
-		});
 
-		normals.insert(normals.end(), {
-			glm::vec3(0, 1, 0), glm::vec3(0, 1, 0), glm::vec3(0, 1, 0),
-			glm::vec3(0, 1, 0), glm::vec3(0, 1, 0), glm::vec3(0, 1, 0)
-		});
-	}
+void Chunk::updateSegments() {
+	SRE_PROFILE_SCOPE("Chunk::updateSegments");
+	BlockId padded[ChunkMesher::paddedBlockCount];
+	snapshotBlocks(padded);
+	bool greedy = world->isGreedyMeshing();
 
+	ChunkMeshData segmentMesh;
+	std::vector<glm::u8vec4> positions;
+	std::vector<glm::u8vec4> tiles;
+	for (int s = 0; s < ChunkMesher::segmentCount; s++) {
+		if ((changedSegments & ((uint64_t)1 << s)) == 0)
+			continue;
 
-	if (front) {
-		vertexPositions.insert(vertexPositions.end(), {
-			p5, p6, p7,
-			p5, p7, p8
-		});
+		segmentMesh.clear();
+		ChunkMesher::calculateSegment(padded, greedy, s / chunkSize, s % chunkSize, segmentMesh);
 
-		uvs = textureCoordinates(Block::getTextureIndex(type, BlockSides::Back));
-		uvCoords.insert(uvCoords.end(), {
-			glm::vec4(uvs.x,uvs.w,0,0), glm::vec4(uvs.z,uvs.w,0,0), glm::vec4(uvs.z,uvs.y,0,0),
-			glm::vec4(uvs.x,uvs.w,0,0), glm::vec4(uvs.z,uvs.y,0,0), glm::vec4(uvs.x,uvs.y,0,0),
-		});
+		// A segment that outgrew its room needs a new layout, so rebuild the whole mesh instead.
+		MeshSegment& segment = segments[s];
+		if (segmentMesh.quadCount > segment.capacity) {
+			generateMesh();
+			return;
+		}
 
-		normals.insert(normals.end(), {
-			glm::vec3(0, 0, -1), glm::vec3(0, 0, -1), glm::vec3(0, 0, -1), 
-			glm::vec3(0, 0, -1), glm::vec3(0, 0, -1), glm::vec3(0, 0, -1)
-		});
+		// Overwrite the whole room of the segment, so quads that disappeared turn degenerate.
+		positions = segmentMesh.positions;
+		tiles = segmentMesh.tiles;
+		positions.resize(segment.capacity * 4, glm::u8vec4(0));
+		tiles.resize(segment.capacity * 4, glm::u8vec4(0));
+		world->getRenderer()->update(arenaVertex + segment.firstQuad * 4, positions, tiles);
+
+		quadCount += segmentMesh.quadCount - segment.quads;
+		faceCount += segmentMesh.faceCount - segment.faces;
+		segment.quads = segmentMesh.quadCount;
+		segment.faces = segmentMesh.faceCount;
 	}
 
-	
-	if (back) {
-		vertexPositions.insert(vertexPositions.end(), {
-			p1,p2,p3,
-			p1,p3,p4
-		});
-
-		glm::vec4 coords = textureCoordinates(Block::getTextureIndex(type, BlockSides::Front));
-		uvCoords.insert(uvCoords.end(), {
-			glm::vec4(coords.x,coords.w,0,0), glm::vec4(coords.z,coords.w,0,0), glm::vec4(coords.z,coords.y,0,0),
-			glm::vec4(coords.x,coords.w,0,0), glm::vec4(coords.z,coords.y,0,0), glm::vec4(coords.x,coords.y,0,0)
-		});
-
-		normals.insert(normals.end(), {
-			glm::vec3(0, 0, 1), glm::vec3(0, 0, 1), glm::vec3(0, 0, 1),
-			glm::vec3(0, 0, 1), glm::vec3(0, 0, 1), glm::vec3(0, 0, 1)
-		});
-	}
+	connectivity = ChunkMesher::calculateConnectivity(padded);
+	changedSegments = 0;
 }
 
 
-glm::vec4 Chunk::textureCoordinates(int textureID) {
-	glm::vec2 textureSize(1024, 2048);
-	glm::vec2 tileSize(128, 128);
-
-	float tileWidth = tileSize.x / textureSize.x;
-	float tileHeight = tileSize.y / textureSize.y;
+void Chunk::releaseMesh() {
+	if (arenaVertex < 0)
+		return;
 
-	glm::vec2 min = glm::vec2(0, 1.0f);							// Start at top left
-	glm::vec2 max = min + glm::vec2(tileWidth, -tileHeight);	// Move max to bottom right corner of this block
+	world->getRenderer()->release(arenaVertex);
+	arenaVertex = -1;
+	arenaQuads = 0;
+}
 
-	int tilesX = textureSize.x / tileSize.x;
 
-	float xOffset = (textureID % tilesX) * tileWidth;
-	float yOffset = ((textureID - (textureID % tilesX)) / tilesX) * tileHeight;
+void Chunk::snapshotBlocks(BlockId* padded) {
+	// Copy the blocks into a padded array with a one block border of the neighbouring chunks, 
+	// so the mesher can see whether faces on the chunk edges are covered. Where there is no neighbour the border stays air.
+	// A neighbour at another level of detail has its surface elsewhere, so it counts as air too and this chunk closes its side towards it.
+	std::fill(padded, padded + ChunkMesher::paddedBlockCount, AIR_BLOCK_ID);
 
-	min.x += xOffset;
-	max.x += xOffset;
+	BlockId ids[blockCount];
+	blocks.unpack(ids);
+	for (int index = 0; index < blockCount; index++) {
+		glm::ivec3 local = toLocalPosition(index);
+		padded[ChunkMesher::toPaddedIndex(local.x, local.y, local.z)] = ids[index];
+	}
 
-	min.y -= yOffset;
-	max.y -= yOffset;
+	// Offsets of the six neighbouring chunks.
+	const glm::ivec3 directions[6] = {
+		glm::ivec3(-1, 0, 0), glm::ivec3(1, 0, 0),
+		glm::ivec3(0, -1, 0), glm::ivec3(0, 1, 0),
+		glm::ivec3(0, 0, -1), glm::ivec3(0, 0, 1)
+	};
+
+	for (int d = 0; d < 6; d++) {
+		glm::ivec3 direction = directions[d];
+		auto neighbour = world->getChunk(chunkPosition.x + direction.x, chunkPosition.y + direction.y, chunkPosition.z + direction.z);
+		if (neighbour == nullptr || neighbour->getLod() != lod)
+			continue;
+
+		// Walk over the layer of this chunk facing the neighbour, and copy the blocks of the neighbour just beyond it.
+		// At a lower level of detail only the first block of every cell is filled in, with the cell of the neighbour beyond it.
+		int scale = 1 << lod;
+		BlockId neighbourIds[blockCount];
+		if (scale > 1)
+			neighbour->getBlockStorage().unpack(neighbourIds);
+
+		for (int i = 0; i < chunkSize; i += scale) {
+			for (int j = 0; j < chunkSize; j += scale) {
+				glm::ivec3 border;
+				for (int axis = 0, k = 0; axis < 3; axis++) {
+					if (direction[axis] < 0)
+						border[axis] = -1;
+					else if (direction[axis] > 0)
+						border[axis] = chunkSize;
+					else
+						border[axis] = (k++ == 0) ? i : j;
+				}
 
-	return glm::vec4(min.x, min.y, max.x, max.y);
+				// Coordinates of the same block, local to the neighbour.
+				glm::ivec3 inNeighbour = border - direction * chunkSize;
+				padded[ChunkMesher::toPaddedIndex(border.x, border.y, border.z)] = scale == 1
+					? neighbour->getBlockId(inNeighbour.x, inNeighbour.y, inNeighbour.z)
+					: ChunkMesher::sampleCell(neighbourIds, scale, inNeighbour / scale);
+			}
+		}
+	}
 }
 
 
@@ -381,47 +322,79 @@ void Chunk::flagRecalculateMesh() {
 }
 
 
-void Chunk::addCollidersToWorld() {
-	// If colliders are already active, we do not have to do anything
-	if(collidersActive)
+void Chunk::setLod(int lod) {
+	if (lod == this->lod)
 		return;
 
-	for (int x = 0; x < chunkSize; x++)	{
-		for (int y = 0; y < chunkSize; y++) {
-			for (int z = 0; z < chunkSize; z++) {
-				blocksInChunk[x][y][z].addColliderToWorld();
-			}
+	// The neighbours only cull their sides against this chunk while it is at their level, so they have to be meshed again.
+	this->lod = lod;
+	world->flagNeighbourChunksForRecalculate(chunkPosition);
+}
+
+
+void Chunk::flagBlockChanged(glm::ivec3 local) {
+	for (int face = 0; face < 6; face++) {
+		int axis = face / 2;
+		int sign = face % 2 == 0 ? -1 : 1;
+
+		// A block just outside the chunk only touches the faces of this chunk along the axis it lies outside on.
+		int uAxis = (axis + 1) % 3;
+		int vAxis = (axis + 2) % 3;
+		if (local[uAxis] < 0 || local[uAxis] >= chunkSize || local[vAxis] < 0 || local[vAxis] >= chunkSize)
+			continue;
+
+		// The faces in this direction that can change are those of the block itself, and the one of the block behind it which points at the block.
+		int slices[2] = { local[axis], local[axis] - sign };
+		for (int slice : slices) {
+			if (slice >= 0 && slice < chunkSize)
+				changedSegments |= (uint64_t)1 << ChunkMesher::toSegment(face, slice);
 		}
 	}
+}
+
+
+void Chunk::addCollidersToWorld() {
+	// If colliders are already active, we do not have to do anything. Neither in a world without physics.
+	if(collidersActive || world->getPhysics() == nullptr)
+		return;
+
+	// The shape is local to the chunk, so the body sits on the chunk position.
+	btTransform transform;
+	transform.setIdentity();
+	transform.setOrigin(btVector3(btScalar(position.x), btScalar(position.y), btScalar(position.z)));
+	collider->setWorldTransform(transform);
 
+	world->getPhysics()->addRigidBody(collider);
 	collidersActive = true;
 }
 
 
 void Chunk::removeCollidersFromWorld() {
-	// If colliders are already active, we do not have to do anything
+	// If colliders are already not active, we do not have to do anything
 	if(!collidersActive)
 		return;
 
-	// If colliders are already not active, we do not have to do anything
-	for (int x = 0; x < chunkSize; x++) {
-		for (int y = 0; y < chunkSize; y++) {
-			for (int z = 0; z < chunkSize; z++) {
-				blocksInChunk[x][y][z].removeColliderFromWorld();
-			}
-		}
-	}
-
+	world->getPhysics()->removeRigidBody(collider);
 	collidersActive = false;
 }
 
 
-Block* Chunk::getBlock(int x, int y, int z) {	
-	// If the requested block is without bounds return a nullpointer
+void Chunk::createCollider() {
+	// A single static body for the whole chunk. The shape reads the blocks when Bullet asks for them, so it never has to be rebuilt.
+	shape = new VoxelShape(this);
+
+	// Static rigidbodies never move, so they do not need a motion state.
+	btRigidBody::btRigidBodyConstructionInfo cInfo(btScalar(0), nullptr, shape, btVector3(0, 0, 0));
+	collider = new btRigidBody(cInfo);
+}
+
+
+Block Chunk::getBlock(int x, int y, int z) {	
+	// If the requested block is without bounds return an invalid block
 	if (x < 0 || x >= chunkSize || y < 0 || y >= chunkSize || z < 0 || z >= chunkSize) {
-		return nullptr;
+		return Block();
 	}
 
 	// Else return the block
-	return &blocksInChunk[x][y][z];
-}
\ No newline at end of file
+	return Block(this, x, y, z);
+}
@@ -1,54 +1,134 @@
 /*
 * Chunk - Created: 01-12-2017
-* Holds a three dimensional array of blocks that are contained in this chunk.
+* Holds the packed ids of all blocks that are contained in this chunk.
 */
 #pragma once
 
-#include <glm\gtx\rotate_vector.hpp>
-#include "sre/SDLRenderer.hpp"
-#include "sre/Material.hpp"
-#include "ParticleSystem.hpp"
+#include <memory>
+#include <vector>
+#include <glm/glm.hpp>
+#include <glm/gtx/rotate_vector.hpp>
 #include "Block.hpp"
+#include "BlockStorage.hpp"
 
 
 
+struct ChunkMeshData;
+struct ChunkMeshTask;
+struct ChunkGenerateTask;
+class World;
+class VoxelShape;
+class btRigidBody;
 class Chunk {
 public:
-	Chunk();
-	Chunk(glm::vec3 position);
+	explicit Chunk(World* world);		// The chunk reaches its neighbours, the job pool and the optional hooks through world
+	Chunk(World* world, glm::vec3 position);
 	~Chunk();
 
+	void reset(glm::vec3 position);		// Moves the chunk to a new world position with all blocks air, used when taken from the pool.
+	void generateBlocks();				// Generates the terrain for its position on the job pool, the blocks stay air until update picks up the result.
+	void setBlocks(const BlockStorage& storage);	// Replaces all blocks, used for chunks loaded from disk.
+	void unload();						// Releases colliders, mesh and blocks, used when the chunk goes back to the pool.
+
 	void update(float dt);
-	void draw(sre::RenderPass& renderpass);
+	void draw();						// Queues the mesh of this chunk for the next draw of the renderer of the world
 
-	Block* getBlock(int x, int y, int z);	// Returns a block with the passed in coordinates. These are local chunk coordinates!
+	Block getBlock(int x, int y, int z);				// Returns a block with the passed in coordinates. These are local chunk coordinates!
+	BlockId getBlockId(int x, int y, int z) { return blocks.get(toIndex(x, y, z)); }				// Returns the packed id of a block at local coordinates.
+	void setBlockId(int x, int y, int z, BlockId id) { blocks.set(toIndex(x, y, z), id); dirty = true; }	// Sets the packed id of a block at local coordinates.
 	
 	void flagRecalculateMesh();			// Raises the flag to recalculate the mesh.
-	void addCollidersToWorld();			// Tells all the blocks in this chunk to add their rigidbodies to the world.
-	void removeCollidersFromWorld();	// Tells all the blocks to remove their rigidbodies from the world.
+	void setLod(int lod);				// Level of detail to show, the current mesh stays until the new one is ready
+	int getLod() { return lod; }
+	void flagBlockChanged(glm::ivec3 local);	// Marks the mesh segments around a changed block for patching, local may lie just outside the chunk for a block of a neighbour.
+	void addCollidersToWorld();			// Adds the rigidbody of this chunk to the world, it collides with the active blocks.
+	void removeCollidersFromWorld();	// Removes the rigidbody of this chunk from the world.
 
 	bool isCollidersActive() { return collidersActive; }
-	glm::vec3 getPosition() { return position; }		
+	bool isGenerating() { return generateTask != nullptr; }	// Whether the terrain of this chunk is still being generated
+	bool isDirty() { return dirty; }			// Whether blocks changed since the chunk was loaded or last saved
+	void clearDirty() { dirty = false; }
+	int getFaceCount() { return faceCount; }			// Visible block faces in the current mesh
+	int getTriangleCount() { return quadCount * 2; }	// Triangles in the current mesh, lower than two per face when faces were merged
+	int getMeshBytes() { return arenaQuads * 4 * 2 * sizeof(glm::u8vec4); }	// Vertex memory the current mesh takes up in the renderer
+	int getMeshLod() { return meshLod; }				// Level of detail of the current mesh
+	bool hasMesh() { return arenaVertex >= 0; }		// Whether there is anything to draw, chunks without visible faces have no mesh
+	// Whether the chunk can be seen through from side from to side to, sides are ordered like the faces of a block.
+	// Until the chunk is meshed it counts as open.
+	bool isConnected(int from, int to) { return (connectivity >> (from * 6 + to)) & 1; }
+	glm::vec3 getBoundsMin() { return position - glm::vec3(0.5f); }					// Corners of the box around all blocks of this chunk,
+	glm::vec3 getBoundsMax() { return position + glm::vec3(chunkSize - 0.5f); }		// blocks are centered on their position
+	glm::vec3 getPosition() { return position; }						// World position of the first block in this chunk
+	glm::ivec3 getChunkPosition() { return chunkPosition; }			// Position of this chunk in chunk coordinates
+	World* getWorld() { return world; }								// World this chunk belongs to
+
+	const BlockStorage& getBlockStorage() { return blocks; }	// The palette compressed blocks of this chunk.
 
 	const static int chunkSize = 8;		// Size of the chunk in all dimensions, e.g. when 8 the chunk is 8x8x8.
+	const static int blockCount = chunkSize * chunkSize * chunkSize;
+
+	// Index of a block in the block storage. Blocks are stored x first, then z, then y so horizontal layers are contiguous.
+	static int toIndex(int x, int y, int z) { return x + chunkSize * (z + chunkSize * y); }
+	static glm::ivec3 toLocalPosition(int index) { return glm::ivec3(index % chunkSize, index / (chunkSize * chunkSize), (index / chunkSize) % chunkSize); }
+
+	// Splits world block coordinates into the chunk that holds them and the local coordinates inside that chunk.
+	// These round towards negative infinity, so they also hold for negative coordinates.
+	static glm::ivec3 toChunkCoordinates(glm::ivec3 world) { return glm::ivec3(floorDivide(world.x), floorDivide(world.y), floorDivide(world.z)); }
+	static glm::ivec3 toLocalCoordinates(glm::ivec3 world) { return world - toChunkCoordinates(world) * chunkSize; }
 private:
-	void generateMesh();
-	void calculateMesh(std::vector<glm::vec3>& vertexPositions, std::vector<glm::vec4>& uvCoords, std::vector<glm::vec3>& normals);
-	void addToMesh(	glm::vec3 position, BlockType type, bool left, bool right, bool bottom, bool top, bool front, bool back, 
-					std::vector<glm::vec3>& vertexPositions, std::vector<glm::vec4>& uvCoords, std::vector<glm::vec3>& normals);
-	glm::vec4 textureCoordinates(int blockID);
+	static int floorDivide(int value) { return value >= 0 ? value / chunkSize : -((-value + chunkSize - 1) / chunkSize); }
+
+	void generateMesh();								// Snapshots the blocks and queues them for meshing on the job pool
+	void uploadMesh(ChunkMeshData& meshData);			// Turns finished vertex data into the mesh, must run on the main thread
+	void snapshotBlocks(BlockId* paddedBlocks);			// Copies the blocks and the border of the neighbours for the mesher
+	void updateSegments();								// Remeshes only the flagged segments and patches them into the mesh
+	void releaseMesh();									// Gives the vertices of the mesh back to the renderer
 
 
+	World* world;
 	glm::vec3 position;			// The position of this chunk
-	glm::mat4 chunkTransform;	// Transform matrix of this chunk
+	glm::ivec3 chunkPosition;	// The position of this chunk in chunk coordinates
 
 	// Flag to see if we need to recalculate our mesh
 	bool recalculateMesh = true; 
-	std::shared_ptr<sre::Mesh> mesh;
+	int arenaVertex = -1;		// First vertex of the mesh in the renderer of the world, -1 when there is no mesh
+	int arenaQuads = 0;			// Quads allocated for the mesh, including the room of the segments
+	std::shared_ptr<ChunkMeshTask> meshTask;	// Meshing job in flight, if any
+	std::shared_ptr<ChunkGenerateTask> generateTask;	// Terrain generation job in flight, if any
+	int faceCount = 0;
+	int quadCount = 0;
+	uint64_t connectivity = ~(uint64_t)0;	// Sides connected through air, computed along with the mesh
+	int lod = 0;			// Level of detail wanted
+	int meshLod = 0;		// Level of detail of the current mesh
+
+	// Where the quads of every mesh segment live in the vertex buffer. Each segment has some room to grow,
+	// so a block change can be patched in place until a segment outgrows it and the whole mesh is rebuilt.
+	struct MeshSegment {
+		int firstQuad;
+		int capacity;
+		int quads;
+		int faces;
+	};
+	std::vector<MeshSegment> segments;
+	uint64_t changedSegments = 0;	// One bit per segment that has to be remeshed
 
 	// Whether colliders are active on this chunk
 	bool collidersActive = false;
 
-	// The actual blocks in this chunk
-	Block*** blocksInChunk;
+	// Static rigidbody with a shape that is read from the blocks, reused for every position the chunk gets.
+	VoxelShape* shape = nullptr;
+	btRigidBody* collider = nullptr;
+	void createCollider();
+
+	// The palette compressed ids of all blocks in this chunk
+	BlockStorage blocks;
+	bool dirty = false;		// Raised when a block changes, only dirty chunks are saved
+};
+
+
+// Hashes chunk coordinates, used to look up chunks in the world.
+struct ChunkPositionHash {
+	size_t operator()(const glm::ivec3& position) const {
+		return ((size_t)position.x * 73856093) ^ ((size_t)position.y * 19349663) ^ ((size_t)position.z * 83492791);
+	}
 };
\ No newline at end of file
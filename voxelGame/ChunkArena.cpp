@@ -0,0 +1,207 @@
+#include "ChunkArena.hpp"
+#include "Chunk.hpp"
+#include <algorithm>
+#include <cassert>
+
+
+// Index pattern of quadCount quads laid out one after another, four vertices each. Shared by all chunks through the base vertex.
+static std::vector<uint32_t> quadIndices(int quadCount) {
+	std::vector<uint32_t> indices;
+	indices.reserve(quadCount * 6);
+	for (uint32_t first = 0; first < (uint32_t)quadCount * 4; first += 4) {
+		indices.insert(indices.end(), {
+			first, first + 1, first + 2,
+			first, first + 2, first + 3
+		});
+	}
+	return indices;
+}
+
+
+ChunkArena::ChunkArena(int pageCount)
+	: origin(0), pageCount(pageCount) {
+	freeRuns[0] = pageCount;
+	pageEntries.resize(pageCount, glm::u8vec4(128, 128, 128, 0));
+}
+
+
+int ChunkArena::allocate(glm::ivec3 chunkPosition, const std::vector<glm::u8vec4>& positions, const std::vector<glm::u8vec4>& tiles) {
+	assert(!positions.empty() && positions.size() == tiles.size());
+	int pages = ((int)positions.size() + pageVertices - 1) / pageVertices;
+
+	if (!fitsOrigin(chunkPosition))
+		recenter(chunkPosition);
+
+	// First fit, chunks come and go at similar sizes so the runs get reused well.
+	auto run = std::find_if(freeRuns.begin(), freeRuns.end(), [pages](const std::pair<const int, int>& run) { return run.second >= pages; });
+	if (run == freeRuns.end()) {
+		grow(pages);
+		run = std::prev(freeRuns.end());
+	}
+
+	int firstPage = run->first;
+	int remaining = run->second - pages;
+	freeRuns.erase(run);
+	if (remaining > 0)
+		freeRuns[firstPage + pages] = remaining;
+
+	Allocation& allocation = allocations[firstPage];
+	allocation = { pages, chunkPosition };
+	usedPages += pages;
+	writePageEntries(firstPage, allocation);
+	growIndices((int)positions.size() / 4);
+
+	// The buffer is only created now, since that needs the renderer.
+	if (mesh == nullptr) {
+		std::vector<glm::u8vec4> empty(pageCount * pageVertices, glm::u8vec4(0));
+		mesh = sre::Mesh::create()
+			.withAttribute("packedPosition", empty)
+			.withAttribute("packedTile", empty)
+			.withIndices(quadIndices(indexQuads))
+			.withName("ChunkArena")
+			.build();
+	}
+
+	update(firstPage * pageVertices, positions, tiles);
+	return firstPage * pageVertices;
+}
+
+
+void ChunkArena::update(int firstVertex, const std::vector<glm::u8vec4>& positions, const std::vector<glm::u8vec4>& tiles) {
+	mesh->updateAttributes(firstVertex, { { "packedPosition", positions }, { "packedTile", tiles } });
+}
+
+
+void ChunkArena::release(int firstVertex) {
+	int firstPage = firstVertex / pageVertices;
+	auto it = allocations.find(firstPage);
+	assert(it != allocations.end());
+	int pages = it->second.pageCount;
+	allocations.erase(it);
+	usedPages -= pages;
+
+	// Merge with the free runs on either side, so large chunks keep finding room.
+	auto next = freeRuns.find(firstPage + pages);
+	if (next != freeRuns.end()) {
+		pages += next->second;
+		freeRuns.erase(next);
+	}
+
+	auto after = freeRuns.lower_bound(firstPage);
+	if (after != freeRuns.begin()) {
+		auto before = std::prev(after);
+		if (before->first + before->second == firstPage) {
+			before->second += pages;
+			return;
+		}
+	}
+	freeRuns[firstPage] = pages;
+}
+
+
+void ChunkArena::addDraw(int firstVertex, int quadCount) {
+	ranges.push_back({ quadCount * 6, firstVertex });
+}
+
+
+void ChunkArena::draw(sre::RenderPass& renderPass, std::shared_ptr<sre::Material>& material) {
+	if (mesh == nullptr || ranges.empty()) {
+		ranges.clear();
+		return;
+	}
+
+	// The page table is created when the arena is created or grew, otherwise only the rows that changed are uploaded.
+	int rows = pageCount / pageTableWidth;
+	if (pageTable == nullptr || pageTable->getHeight() != rows) {
+		pageTable = sre::Texture::create()
+			.withRGBAData((const char*)pageEntries.data(), pageTableWidth, rows)
+			.withFilterSampling(false)
+			.withGenerateMipmaps(false)
+			.withWrappedTextureCoordinates(false)
+			.withName("ChunkPageTable")
+			.build();
+	} else if (changedRowsBegin < changedRowsEnd) {
+		pageTable->updateRGBAData((const char*)&pageEntries[changedRowsBegin * pageTableWidth], 0, changedRowsBegin, pageTableWidth, changedRowsEnd - changedRowsBegin);
+	}
+	changedRowsBegin = changedRowsEnd = 0;
+
+	material->set("pageTable", pageTable);
+	material->set("arenaOrigin", glm::vec4(origin, 0));
+	material->set("arenaLayout", glm::vec4(pageVertices, pageTableWidth, Chunk::chunkSize, 0));
+	renderPass.drawRanges(mesh, ranges, glm::mat4(1), material);
+	ranges.clear();
+}
+
+
+void ChunkArena::grow(int minimumPages) {
+	// A free run at the end of the arena grows along with it.
+	int oldCount = pageCount;
+	int trailing = 0;
+	if (!freeRuns.empty()) {
+		auto last = std::prev(freeRuns.end());
+		if (last->first + last->second == oldCount)
+			trailing = last->second;
+	}
+
+	while (trailing + pageCount - oldCount < minimumPages)
+		pageCount *= 2;
+
+	freeRuns[oldCount - trailing] = trailing + pageCount - oldCount;
+	pageEntries.resize(pageCount, glm::u8vec4(128, 128, 128, 0));
+
+	if (mesh != nullptr) {
+		std::vector<glm::u8vec4> positions = mesh->get<const std::vector<glm::u8vec4>&>("packedPosition");
+		std::vector<glm::u8vec4> tiles = mesh->get<const std::vector<glm::u8vec4>&>("packedTile");
+		positions.resize(pageCount * pageVertices, glm::u8vec4(0));
+		tiles.resize(pageCount * pageVertices, glm::u8vec4(0));
+		mesh->update()
+			.withAttribute("packedPosition", positions)
+			.withAttribute("packedTile", tiles)
+			.build();
+	}
+}
+
+
+void ChunkArena::growIndices(int quadCount) {
+	if (quadCount <= indexQuads)
+		return;
+
+	// Round up, so the pattern is only rebuilt a few times.
+	indexQuads = std::max(indexQuads, 1024);
+	while (indexQuads < quadCount)
+		indexQuads *= 2;
+
+	if (mesh != nullptr)
+		mesh->update().withIndices(quadIndices(indexQuads)).build();
+}
+
+
+void ChunkArena::writePageEntries(int firstPage, const Allocation& allocation) {
+	glm::u8vec4 entry(glm::ivec3(128) + allocation.chunkPosition - origin, 0);
+	std::fill(pageEntries.begin() + firstPage, pageEntries.begin() + firstPage + allocation.pageCount, entry);
+
+	int firstRow = firstPage / pageTableWidth;
+	int endRow = (firstPage + allocation.pageCount - 1) / pageTableWidth + 1;
+	if (changedRowsBegin >= changedRowsEnd) {
+		changedRowsBegin = firstRow;
+		changedRowsEnd = endRow;
+	} else {
+		changedRowsBegin = std::min(changedRowsBegin, firstRow);
+		changedRowsEnd = std::max(changedRowsEnd, endRow);
+	}
+}
+
+
+void ChunkArena::recenter(glm::ivec3 chunkPosition) {
+	// Loaded chunks lie close together, so they all fit around any one of them.
+	origin = chunkPosition;
+	for (auto& pair : allocations) {
+		writePageEntries(pair.first, pair.second);
+	}
+}
+
+
+bool ChunkArena::fitsOrigin(glm::ivec3 chunkPosition) {
+	glm::ivec3 offset = chunkPosition - origin;
+	return glm::all(glm::greaterThanEqual(offset, glm::ivec3(-127))) && glm::all(glm::lessThanEqual(offset, glm::ivec3(127)));
+}
@@ -0,0 +1,67 @@
+/*
+* ChunkArena - Created: 16-10-2026
+* Keeps the meshes of all chunks in one large vertex buffer, so every visible chunk is drawn with a single multi draw call.
+* The buffer is split into pages of pageVertices vertices and every chunk gets a run of pages. A small texture tells the
+* chunk shader which chunk each page belongs to, the shader looks it up by the vertex id, so vertices stay local to their chunk.
+* Chunk positions are stored as byte offsets from an origin, which moves along when chunks are allocated too far from it.
+*/
+#pragma once
+
+#include <map>
+#include <unordered_map>
+#include <vector>
+#include "sre/RenderPass.hpp"
+#include "sre/Texture.hpp"
+#include "sre/Material.hpp"
+#include "World.hpp"
+
+
+
+class ChunkArena : public ChunkRenderer {
+public:
+	const static int pageVertices = 256;	// Vertices per page, the chunk shader divides the vertex id by this
+	const static int pageTableWidth = 256;	// Pages per row of the page table texture
+
+	explicit ChunkArena(int pageCount = 4096);	// The arena doubles in size whenever a chunk does not fit
+
+	// Copies the vertices of a chunk mesh into the arena and returns the first vertex, quads are drawn four vertices at a time.
+	int allocate(glm::ivec3 chunkPosition, const std::vector<glm::u8vec4>& positions, const std::vector<glm::u8vec4>& tiles) override;
+	// Overwrites vertices inside an allocation, firstVertex is relative to the arena.
+	void update(int firstVertex, const std::vector<glm::u8vec4>& positions, const std::vector<glm::u8vec4>& tiles) override;
+	void release(int firstVertex) override;	// Gives the pages of an allocation back
+
+	void addDraw(int firstVertex, int quadCount) override;	// Queues quads of an allocation for the next draw
+	void draw(sre::RenderPass& renderPass, std::shared_ptr<sre::Material>& material);	// Draws all queued quads in a single call
+
+	int getAllocationCount() { return (int)allocations.size(); }
+	int getUsedPages() { return usedPages; }
+	int getPageCount() { return pageCount; }
+	int getDataSize() { return mesh != nullptr ? mesh->getDataSize() : 0; }	// GPU memory of the vertex and index buffer
+private:
+	struct Allocation {
+		int pageCount;
+		glm::ivec3 chunkPosition;
+	};
+
+	void grow(int minimumPages);				// Doubles the page count until a run of minimumPages fits at the end
+	void growIndices(int quadCount);			// Makes the shared quad pattern long enough for an allocation of quadCount quads
+	void writePageEntries(int firstPage, const Allocation& allocation);
+	void recenter(glm::ivec3 chunkPosition);	// Moves the origin to chunkPosition and writes all page entries again
+	bool fitsOrigin(glm::ivec3 chunkPosition);	// Whether the offset to the origin fits in a page entry
+
+	std::shared_ptr<sre::Mesh> mesh;			// Created with the first allocation, when the renderer is running
+	std::shared_ptr<sre::Texture> pageTable;
+	std::vector<glm::u8vec4> pageEntries;		// Offset of the chunk from the origin plus 128 for every page
+	// Rows of the page table that changed since the last upload, empty when changedRowsBegin >= changedRowsEnd.
+	// The texture is only created again when the page count changes.
+	int changedRowsBegin = 0;
+	int changedRowsEnd = 0;
+	glm::ivec3 origin;
+
+	int pageCount;
+	int usedPages = 0;
+	int indexQuads = 0;							// Quads covered by the shared index pattern
+	std::map<int, int> freeRuns;				// Page count of every run of free pages, by first page
+	std::unordered_map<int, Allocation> allocations;	// By first page
+	std::vector<sre::MeshRange> ranges;			// Queued for the next draw
+};
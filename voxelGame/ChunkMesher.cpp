@@ -0,0 +1,315 @@
+#include "ChunkMesher.hpp"
+#include <algorithm>
+
+
+
+// Describes how a face direction is laid out. The u and v axis are the directions in which the texture runs over the face,
+// the corners are the four corners of a quad in the order they are triangulated, given as steps along u and v.
+struct FaceDescription {
+	BlockSides side;	// Side of the block used to pick the texture
+	int axis;			// Axis the face points along, 0 = x, 1 = y, 2 = z
+	int sign;			// Whether the face points in the positive or negative direction of that axis
+	int uAxis;
+	int uSign;
+	int vAxis;
+	int vSign;
+	int corners[4][2];
+};
+
+// Left, right, bottom, top, front and back, matching the orientation the blocks always had. The chunk shader looks up the normal by this order.
+static const FaceDescription faces[6] = {
+	{ BlockSides::Left,   0, -1, 2,  1, 1,  1, { { 0, 0 }, { 1, 0 }, { 1, 1 }, { 0, 1 } } },
+	{ BlockSides::Right,  0,  1, 2, -1, 1,  1, { { 0, 0 }, { 1, 0 }, { 1, 1 }, { 0, 1 } } },
+	{ BlockSides::Bottom, 1, -1, 0,  1, 2, -1, { { 0, 1 }, { 1, 1 }, { 1, 0 }, { 0, 0 } } },
+	{ BlockSides::Top,    1,  1, 0,  1, 2,  1, { { 0, 1 }, { 1, 1 }, { 1, 0 }, { 0, 0 } } },
+	{ BlockSides::Back,   2, -1, 0, -1, 1,  1, { { 0, 0 }, { 1, 0 }, { 1, 1 }, { 0, 1 } } },
+	{ BlockSides::Front,  2,  1, 0,  1, 1,  1, { { 0, 0 }, { 1, 0 }, { 1, 1 }, { 0, 1 } } }
+};
+
+
+void ChunkMeshData::clear() {
+	positions.clear();
+	tiles.clear();
+	segmentQuads.clear();
+	segmentFaces.clear();
+	connectivity = 0;
+	faceCount = 0;
+	quadCount = 0;
+}
+
+
+void ChunkMesher::calculateMesh(const BlockId* paddedBlocks, bool greedy, ChunkMeshData& mesh, int size) {
+	mesh.segmentQuads.assign(segmentCount, 0);
+	mesh.segmentFaces.assign(segmentCount, 0);
+
+	// Walk through the chunk one slice at a time, a slice being a layer of blocks perpendicular to the face direction.
+	for (int face = 0; face < 6; face++) {
+		for (int slice = 0; slice < size; slice++) {
+			int quadsBefore = mesh.quadCount;
+			int facesBefore = mesh.faceCount;
+			calculateSegment(paddedBlocks, greedy, face, slice, mesh, size);
+
+			mesh.segmentQuads[toSegment(face, slice)] = mesh.quadCount - quadsBefore;
+			mesh.segmentFaces[toSegment(face, slice)] = mesh.faceCount - facesBefore;
+		}
+	}
+}
+
+
+void ChunkMesher::calculateSegment(const BlockId* paddedBlocks, bool greedy, int face, int slice, ChunkMeshData& mesh, int size) {
+	const FaceDescription& description = faces[face];
+
+	// Texture index of every visible face in the slice, or -1 when there is no face.
+	int mask[Chunk::chunkSize * Chunk::chunkSize];
+
+	// Find all visible faces in this slice, a face is visible when the block is active and its neighbour is air.
+	for (int b = 0; b < size; b++) {
+		for (int a = 0; a < size; a++) {
+			int position[3];
+			position[description.axis] = slice;
+			position[description.uAxis] = a;
+			position[description.vAxis] = b;
+
+			BlockId id = paddedBlocks[toPaddedIndex(position[0], position[1], position[2])];
+			position[description.axis] += description.sign;
+			BlockId neighbour = paddedBlocks[toPaddedIndex(position[0], position[1], position[2])];
+
+			if (id != AIR_BLOCK_ID && neighbour == AIR_BLOCK_ID) {
+				mask[a + b * size] = Block::getTextureIndex(blockTypeFromId(id), description.side);
+				mesh.faceCount++;
+			} else {
+				mask[a + b * size] = -1;
+			}
+		}
+	}
+
+	// Cover the visible faces with quads. In greedy mode a quad first grows along u as long as the texture matches,
+	// and then grows along v as long as the whole next row matches.
+	for (int b = 0; b < size; b++) {
+		for (int a = 0; a < size;) {
+			int textureId = mask[a + b * size];
+			if (textureId < 0) {
+				a++;
+				continue;
+			}
+
+			int width = 1;
+			int height = 1;
+			if (greedy) {
+				while (a + width < size && mask[a + width + b * size] == textureId)
+					width++;
+
+				bool rowMatches = true;
+				while (b + height < size && rowMatches) {
+					for (int i = 0; i < width; i++) {
+						if (mask[a + i + (b + height) * size] != textureId) {
+							rowMatches = false;
+							break;
+						}
+					}
+					if (rowMatches)
+						height++;
+				}
+			}
+
+			// Clear the faces covered by this quad so they are not used again.
+			for (int j = 0; j < height; j++) {
+				for (int i = 0; i < width; i++) {
+					mask[a + i + (b + j) * size] = -1;
+				}
+			}
+
+			addQuad(face, slice, a, b, width, height, textureId, mesh);
+			a += width;
+		}
+	}
+}
+
+
+void ChunkMesher::calculateLodMesh(const BlockId* paddedBlocks, int lod, bool greedy, ChunkMeshData& mesh) {
+	int scale = 1 << lod;
+	BlockId coarseBlocks[paddedBlockCount];
+	downsample(paddedBlocks, scale, coarseBlocks);
+	calculateMesh(coarseBlocks, greedy, mesh, Chunk::chunkSize / scale);
+
+	// Grow the quads from cells back to blocks, the tiles repeat once per block so the textures keep their size.
+	for (size_t i = 0; i < mesh.positions.size(); i++) {
+		mesh.positions[i] = glm::u8vec4(glm::u8vec3(mesh.positions[i]) * (uint8_t)scale, mesh.positions[i].w);
+		mesh.tiles[i].y *= scale;
+		mesh.tiles[i].z *= scale;
+	}
+}
+
+
+void ChunkMesher::downsample(const BlockId* paddedBlocks, int scale, BlockId* coarseBlocks) {
+	const int size = Chunk::chunkSize / scale;
+
+	// Only the cells and their border are filled in, the rest of the array stays air.
+	std::fill(coarseBlocks, coarseBlocks + paddedBlockCount, AIR_BLOCK_ID);
+
+	BlockId blocks[Chunk::blockCount];
+	for (int index = 0; index < Chunk::blockCount; index++) {
+		glm::ivec3 local = Chunk::toLocalPosition(index);
+		blocks[index] = paddedBlocks[toPaddedIndex(local.x, local.y, local.z)];
+	}
+
+	for (int y = 0; y < size; y++) {
+		for (int z = 0; z < size; z++) {
+			for (int x = 0; x < size; x++) {
+				coarseBlocks[toPaddedIndex(x, y, z)] = sampleCell(blocks, scale, glm::ivec3(x, y, z));
+			}
+		}
+	}
+
+	// The border cells were already sampled from the neighbours, they sit at the first block of every cell.
+	for (int axis = 0; axis < 3; axis++) {
+		for (int side = -1; side <= size; side += size + 1) {
+			for (int a = 0; a < size; a++) {
+				for (int b = 0; b < size; b++) {
+					glm::ivec3 cell;
+					cell[axis] = side;
+					cell[(axis + 1) % 3] = a;
+					cell[(axis + 2) % 3] = b;
+
+					glm::ivec3 block = cell * scale;
+					block[axis] = side < 0 ? -1 : Chunk::chunkSize;
+					coarseBlocks[toPaddedIndex(cell.x, cell.y, cell.z)] = paddedBlocks[toPaddedIndex(block.x, block.y, block.z)];
+				}
+			}
+		}
+	}
+}
+
+
+BlockId ChunkMesher::sampleCell(const BlockId* blocks, int scale, glm::ivec3 cell) {
+	// A cell is solid when at least half its blocks are, and takes the id of its highest block so the surface keeps its look.
+	int solid = 0;
+	BlockId top = AIR_BLOCK_ID;
+	for (int by = cell.y * scale + scale - 1; by >= cell.y * scale; by--) {
+		for (int bz = cell.z * scale; bz < cell.z * scale + scale; bz++) {
+			for (int bx = cell.x * scale; bx < cell.x * scale + scale; bx++) {
+				BlockId id = blocks[Chunk::toIndex(bx, by, bz)];
+				if (id == AIR_BLOCK_ID)
+					continue;
+
+				if (top == AIR_BLOCK_ID)
+					top = id;
+				solid++;
+			}
+		}
+	}
+
+	return solid * 2 >= scale * scale * scale ? top : AIR_BLOCK_ID;
+}
+
+
+uint64_t ChunkMesher::calculateConnectivity(const BlockId* paddedBlocks) {
+	const int size = Chunk::chunkSize;
+	bool visited[Chunk::blockCount] = {};
+	int stack[Chunk::blockCount];
+	uint64_t connectivity = 0;
+
+	// Flood fill every pocket of air, and connect all sides the pocket touches with each other.
+	for (int start = 0; start < Chunk::blockCount; start++) {
+		glm::ivec3 position = Chunk::toLocalPosition(start);
+		if (visited[start] || paddedBlocks[toPaddedIndex(position.x, position.y, position.z)] != AIR_BLOCK_ID)
+			continue;
+
+		int sides = 0;
+		int top = 0;
+		stack[top++] = start;
+		visited[start] = true;
+		while (top > 0) {
+			glm::ivec3 local = Chunk::toLocalPosition(stack[--top]);
+			for (int face = 0; face < 6; face++) {
+				glm::ivec3 next = local;
+				next[faces[face].axis] += faces[face].sign;
+
+				// Leaving the chunk means the pocket reaches that side.
+				if (next[faces[face].axis] < 0 || next[faces[face].axis] >= size) {
+					sides |= 1 << face;
+					continue;
+				}
+
+				int index = Chunk::toIndex(next.x, next.y, next.z);
+				if (visited[index] || paddedBlocks[toPaddedIndex(next.x, next.y, next.z)] != AIR_BLOCK_ID)
+					continue;
+
+				visited[index] = true;
+				stack[top++] = index;
+			}
+		}
+
+		for (int from = 0; from < 6; from++) {
+			for (int to = 0; to < 6; to++) {
+				if ((sides & (1 << from)) && (sides & (1 << to)))
+					connectivity |= 1ull << (from * 6 + to);
+			}
+		}
+	}
+
+	return connectivity;
+}
+
+
+void ChunkMesher::addQuad(int face, int slice, int a, int b, int width, int height, int textureId, ChunkMeshData& mesh) {
+	const FaceDescription& description = faces[face];
+
+	// The face lies on the far side of the block along its normal, and spans from the first corner of the first block to the last corner of the last block.
+	// Corners are stored on the block grid, the shader shifts them back by half a block since blocks are centered on their position.
+	int plane = slice + (description.sign > 0 ? 1 : 0);
+	int originU = description.uSign > 0 ? a : a + width;
+	int originV = description.vSign > 0 ? b : b + height;
+
+	glm::u8vec4 corners[4];
+	glm::u8vec4 tiles[4];
+	for (int i = 0; i < 4; i++) {
+		int stepU = description.corners[i][0];
+		int stepV = description.corners[i][1];
+
+		corners[i][description.axis] = (uint8_t)plane;
+		corners[i][description.uAxis] = (uint8_t)(originU + description.uSign * stepU * width);
+		corners[i][description.vAxis] = (uint8_t)(originV + description.vSign * stepV * height);
+		corners[i].w = (uint8_t)face;
+		tiles[i] = glm::u8vec4(textureId, stepU * width, stepV * height, 0);
+	}
+
+	mesh.positions.insert(mesh.positions.end(), corners, corners + 4);
+	mesh.tiles.insert(mesh.tiles.end(), tiles, tiles + 4);
+
+	mesh.quadCount++;
+}
+
+
+glm::vec4 ChunkMesher::textureCoordinates(int textureId) {
+	glm::vec2 textureSize(1024, 2048);
+	glm::vec2 tileSize(128, 128);
+
+	float tileWidth = tileSize.x / textureSize.x;
+	float tileHeight = tileSize.y / textureSize.y;
+
+	glm::vec2 min = glm::vec2(0, 1.0f);							// Start at top left
+	glm::vec2 max = min + glm::vec2(tileWidth, -tileHeight);	// Move max to bottom right corner of this block
+
+	int tilesX = textureSize.x / tileSize.x;
+
+	float xOffset = (textureId % tilesX) * tileWidth;
+	float yOffset = ((textureId - (textureId % tilesX)) / tilesX) * tileHeight;
+
+	min.x += xOffset;
+	max.x += xOffset;
+
+	min.y -= yOffset;
+	max.y -= yOffset;
+
+	return glm::vec4(min.x, min.y, max.x, max.y);
+}
+
+
+glm::vec4 ChunkMesher::tileLayout() {
+	glm::vec4 coords = textureCoordinates(0);
+	float tileWidth = coords.z - coords.x;
+	float tileHeight = coords.y - coords.w;
+
+	return glm::vec4(tileWidth, tileHeight, glm::round(1.0f / tileWidth), 0);
+}
@@ -0,0 +1,80 @@
+/*
+* ChunkMesher - Created: 16-10-2026
+* Turns the block ids of a chunk into triangles. The mesher works on a padded copy of the chunk, which also holds
+* the one block thick layer of the neighbouring chunks, so faces between chunks can be culled without looking up other chunks.
+* In greedy mode coplanar neighbouring faces with the same texture are merged into a single larger quad.
+*/
+#pragma once
+
+#include <atomic>
+#include <vector>
+#include "Chunk.hpp"
+#include "Block.hpp"
+
+
+
+// Vertex data of a chunk mesh, four vertices per quad. Every vertex is packed into 8 bytes which the chunk shader decodes:
+// positions holds the corner of the block grid in xyz (0 to chunkSize) and the face index in w, which selects the normal.
+// tiles holds the texture index in x and the position on the face in tiles in y and z, which the shader wraps to repeat the tile.
+struct ChunkMeshData {
+	std::vector<glm::u8vec4> positions;
+	std::vector<glm::u8vec4> tiles;
+	std::vector<int> segmentQuads;		// Quads of every segment, the quads are stored segment after segment
+	std::vector<int> segmentFaces;		// Visible faces of every segment
+
+	int faceCount = 0;		// Visible block faces, this is the amount of quads without merging.
+	int quadCount = 0;		// Quads emitted into the mesh.
+	uint64_t connectivity = 0;	// Which sides of the chunk can see each other through air, see ChunkMesher::calculateConnectivity
+
+	void clear();
+};
+
+
+class ChunkMesher {
+public:
+	const static int paddedSize = Chunk::chunkSize + 2;		// The chunk plus a one block border on each side
+	const static int paddedBlockCount = paddedSize * paddedSize * paddedSize;
+
+	// Index into the padded block array, the coordinates are local chunk coordinates which run from -1 up to and including chunkSize.
+	static int toPaddedIndex(int x, int y, int z) { return (x + 1) + paddedSize * ((z + 1) + paddedSize * (y + 1)); }
+
+	// The mesh is split into segments, one for every slice of blocks and face direction. Quads never cross a slice,
+	// so a changed block only affects the two slices on either side of it for each face direction.
+	const static int segmentCount = 6 * Chunk::chunkSize;
+	static int toSegment(int face, int slice) { return face * Chunk::chunkSize + slice; }
+
+	// Meshes the padded block ids into mesh. When greedy is false every visible face becomes its own quad.
+	// Only the first size blocks along each axis are meshed, the block right after them is the border.
+	static void calculateMesh(const BlockId* paddedBlocks, bool greedy, ChunkMeshData& mesh, int size = Chunk::chunkSize);
+	// Meshes a single segment and appends its quads to mesh, used to patch a mesh after a block changed.
+	static void calculateSegment(const BlockId* paddedBlocks, bool greedy, int face, int slice, ChunkMeshData& mesh, int size = Chunk::chunkSize);
+
+	// Meshes the chunk at a lower level of detail, where every cell of scale^3 blocks becomes a single large block.
+	// The border holds the cells of the neighbours at the first block of every cell, see Chunk::snapshotBlocks. Neighbours at
+	// another level are air there, so only the sides towards them are closed, which hides the cracks between the levels.
+	const static int maxLod = 3;	// Scales of 2, 4 and 8 blocks, the last turns a chunk into a single block
+	static void calculateLodMesh(const BlockId* paddedBlocks, int lod, bool greedy, ChunkMeshData& mesh);
+	// Samples the cell of scale^3 blocks at cell coordinates from the unpadded blocks of a chunk, air when less than half is solid.
+	static BlockId sampleCell(const BlockId* blocks, int scale, glm::ivec3 cell);
+
+	// Finds which of the six sides of the chunk are connected through air inside the chunk. Bit from * 6 + to is set when
+	// looking in through side from can come out through side to, sides are ordered like the faces of a block.
+	static uint64_t calculateConnectivity(const BlockId* paddedBlocks);
+
+	static glm::vec4 textureCoordinates(int textureId);	// Translates a texture index to the UV rectangle of its tile in the atlas
+	static glm::vec4 tileLayout();						// Size of a single tile in UV space in xy and tiles per row in z, used by the chunk shader
+private:
+	static void addQuad(int face, int slice, int a, int b, int width, int height, int textureId, ChunkMeshData& mesh);
+	static void downsample(const BlockId* paddedBlocks, int scale, BlockId* coarseBlocks);	// Samples cells of scale^3 blocks into a padded array
+};
+
+
+// A snapshot of a chunk with the border of its neighbours, meshed on the job pool. The snapshot is taken on the
+// main thread, so the job never reads chunks while the game changes them. Only the mesh upload happens back on the main thread.
+struct ChunkMeshTask {
+	BlockId paddedBlocks[ChunkMesher::paddedBlockCount];
+	bool greedy = true;
+	int lod = 0;		// Level of detail to mesh at, 0 being every block
+	ChunkMeshData mesh;
+	std::atomic<bool> done{ false };	// Raised by the job once mesh is filled in
+};
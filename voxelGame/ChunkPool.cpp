@@ -0,0 +1,30 @@
+#include "ChunkPool.hpp"
+
+
+ChunkPool::ChunkPool(World* world, int maxFreeChunks)
+	: world(world), maxFreeChunks(maxFreeChunks) {
+}
+
+
+std::shared_ptr<Chunk> ChunkPool::acquire(glm::vec3 position) {
+	// Only allocate a new chunk when there is nothing to reuse.
+	std::shared_ptr<Chunk> chunk;
+	if (freeChunks.empty()) {
+		createdCount++;
+		chunk = std::make_shared<Chunk>(world);
+	} else {
+		chunk = freeChunks.back();
+		freeChunks.pop_back();
+	}
+
+	chunk->reset(position);
+	return chunk;
+}
+
+
+void ChunkPool::release(std::shared_ptr<Chunk> chunk) {
+	chunk->unload();
+
+	if ((int)freeChunks.size() < maxFreeChunks)
+		freeChunks.push_back(chunk);
+}
@@ -0,0 +1,28 @@
+/*
+* ChunkPool - Created: 16-10-2026
+* Keeps unloaded chunks around so they can be reused when new chunks stream in,
+* instead of allocating the block storage and collider lists of a chunk again every time.
+*/
+#pragma once
+
+#include <memory>
+#include <vector>
+#include "Chunk.hpp"
+
+
+
+class ChunkPool {
+public:
+	explicit ChunkPool(World* world, int maxFreeChunks = 256);	// Chunks are created for world. At most maxFreeChunks unloaded chunks are kept, the rest are freed.
+
+	std::shared_ptr<Chunk> acquire(glm::vec3 position);	// Returns a chunk at world position with all blocks air, the caller loads or generates its blocks.
+	void release(std::shared_ptr<Chunk> chunk);				// Unloads the chunk and keeps it for later use.
+
+	int getFreeCount() { return (int)freeChunks.size(); }	// Chunks waiting in the pool
+	int getCreatedCount() { return createdCount; }			// Chunks allocated since the start
+private:
+	World* world;
+	std::vector<std::shared_ptr<Chunk>> freeChunks;
+	int maxFreeChunks;
+	int createdCount = 0;
+};
@@ -57,7 +57,12 @@ FirstPersonController::~FirstPersonController(){
 }
 
 
-void FirstPersonController::update(float deltaTime){
+void FirstPersonController::fixedUpdate(float timeStep){
+	// Remember where the physics step starts, the camera moves from here to the result of the step.
+	previousPosition = getPosition();
+
+	// Check if the controller is grounded
+	checkGrounded(btVector3(previousPosition.x, previousPosition.y, previousPosition.z));
 
 	// Determine local movement
 	vec3 movement = vec3(0, 0, 0);
@@ -91,9 +96,6 @@ void FirstPersonController::update(float deltaTime){
 				movement += vec3(0, -1, 0);
 		}
 
-		// Multiply by time that has passed to compensate for FPS
-		movement *= deltaTime;
-
 		// Translate local movement to relative world movement 
 		float x = cos(radians(lookRotation.x)) * movement.x - sin(radians(lookRotation.x)) * movement.z;
 		float z = cos(radians(lookRotation.x)) * movement.z + sin(radians(lookRotation.x)) * movement.x;
@@ -106,27 +108,25 @@ void FirstPersonController::update(float deltaTime){
 			velocity = btVector3(x * MOVEMENT_SPEED, velocity.getY(), z * MOVEMENT_SPEED); // Carry falling speed to our current movement
 		rigidBody->setLinearVelocity(velocity);
 	}
-	
-	// Get our position from physics
-	btTransform transform;
-	rigidBody->getMotionState()->getWorldTransform(transform);
-	btVector3 position = transform.getOrigin();
+}
 
-	// Check if the controller is grounded
-	checkGrounded(position);
+
+void FirstPersonController::update(float deltaTime, float interpolation){
+	// Get our position from physics, in between the last two steps so the camera moves smoothly at any frame rate
+	vec3 position = mix(previousPosition, getPosition(), interpolation);
 	
 	// Update our tranform matrix, pass it on to the camera
 	transformMatrix = mat4();
-	transformMatrix = translate(transformMatrix, glm::vec3(position.getX(), position.getY() + Y_CAMERA_OFFSET, position.getZ())); 
+	transformMatrix = translate(transformMatrix, glm::vec3(position.x, position.y + Y_CAMERA_OFFSET, position.z)); 
 	transformMatrix = rotate(transformMatrix, radians(lookRotation.x), vec3(0, -1, 0));
 	transformMatrix = rotate(transformMatrix, radians(lookRotation.y), vec3(-1, 0, 0));
 	camera->setViewTransform(glm::inverse(transformMatrix));
 
 	// Mine block
 	if (isMining) {
-		auto detectedBlock = castRayForBlock(-0.2f);
+		auto detectedBlock = castRayForBlock(false);
 
-		if(detectedBlock != nullptr && detectedBlock == lastBlock) {
+		if(detectedBlock.isValid() && detectedBlock == lastBlock) {
 			minedAmount += deltaTime;
 
 			if (minedAmount >= 1 || instantMining) {
@@ -355,18 +355,18 @@ void FirstPersonController::onMouse(SDL_Event &event) {
 }
 
 
-void FirstPersonController::destroyBlock(Block* block) {
+void FirstPersonController::destroyBlock(Block block) {
 	// Get the location of the block we are looking at
-	vec3 position = block->getPosition();
+	vec3 position = block.getPosition();
 	
 	// Deactivate the block we destroyed
-	block->setActive(false);
+	block.setActive(false);
 
 	// Reset mining progress
 	minedAmount = 0;
 
 	// Flag the necessary chunks for recalculation of mesh
-	Game::getInstance()->flagNeighboursForRecalculateIfNecessary(position.x, position.y, position.z);
+	Game::getInstance()->getWorld()->flagNeighboursForRecalculateIfNecessary(position.x, position.y, position.z);
 }
 
 
@@ -374,62 +374,48 @@ void FirstPersonController::placeBlock() {
 	// Get the block where we are placing
 	// If we replacemode is active replace the actual block
 	// Otherwise get the empty space we are looking at
-	auto detectedBlock = castRayForBlock(replaceBlock? -.2f : .2f);
+	auto detectedBlock = castRayForBlock(!replaceBlock);
 
 	// If we are looking at a block, place one
-	if (detectedBlock != nullptr) {
+	if (detectedBlock.isValid()) {
 		// If theres is already a block and we are not allowed to replace it, don't do anything
-		if(!replaceBlock && detectedBlock->isActive())
+		if(!replaceBlock && detectedBlock.isActive())
 			return;
 
-		vec3 position = detectedBlock->getPosition();
-		Game::getInstance()->flagNeighboursForRecalculateIfNecessary((int)position.x, (int)position.y, (int)position.z);
+		vec3 position = detectedBlock.getPosition();
+		Game::getInstance()->getWorld()->flagNeighboursForRecalculateIfNecessary((int)position.x, (int)position.y, (int)position.z);
 
-		detectedBlock->setType(blockSelected);
-		detectedBlock->setActive(true);
+		// Replace the type of an existing block, or activate the empty location as the selected type.
+		if (detectedBlock.isActive())
+			detectedBlock.setType(blockSelected);
+		else
+			detectedBlock.setActive(true, blockSelected);
 	}	
 }
 
 
-Block* FirstPersonController::castRayForBlock(float normalMultiplier) {
-	btVector3 start = rigidBody->getWorldTransform().getOrigin();
-	start.setY(start.getY() + Y_CAMERA_OFFSET);
+Block FirstPersonController::castRayForBlock(bool adjacent) {
+	btVector3 origin = rigidBody->getWorldTransform().getOrigin();
+	vec3 start(origin.getX(), origin.getY() + Y_CAMERA_OFFSET, origin.getZ());
 
 	float cosY = cos(radians(lookRotation.y));
-	btVector3 direction = btVector3( cosY * sin(radians(lookRotation.x)), -1 * sin(radians(lookRotation.y)), cosY * cos(radians(lookRotation.x)) * -1);
-	direction = direction.normalized();
-
-	btVector3 end = start + direction * MINE_RANGE;
-
-	btCollisionWorld::ClosestRayResultCallback res(start, end);
+	vec3 direction = normalize(vec3(cosY * sin(radians(lookRotation.x)), -1 * sin(radians(lookRotation.y)), cosY * cos(radians(lookRotation.x)) * -1));
 
-	// Cast ray
-	Game::getInstance()->getPhysics()->raycast(&start, &end, &res);
+	// Walk the block grid, which gives the exact block and face without needing its collider.
+	VoxelRayHit hit = Game::getInstance()->getWorld()->castBlockRay(start, direction, MINE_RANGE);
 
 	// If we have an hit handle it, else return null
-	if (res.hasHit()) {
-		// Store hit location
-		btVector3 hit = res.m_hitPointWorld;
-
-		toRay = vec3(hit.getX(), hit.getY(), hit.getZ());
-		toRayNormal = toRay + vec3(res.m_hitNormalWorld.getX(), res.m_hitNormalWorld.getY(), res.m_hitNormalWorld.getZ()) * .2f; //res.m_hitNormalWorld;
+	if (hit.hit) {
+		// Store the rays for debug drawing
+		toRay = start + direction * hit.distance;
+		toRayNormal = toRay + vec3(hit.normal) * .2f;
 		fromRayNormal = toRay;
-		fromRay = vec3(start.getX(), start.getY(), start.getZ());
+		fromRay = start;
 
-		// Compensate for origin of block, collider origin is in center, though for the math we want it to be on a corner
-		hit += btVector3(0.501f, 0.501f, 0.501f);
-
-		// Every block is above or at 0. If we hit the bedrock it could be that we get below 0. So make really sure we always grab blocks on atleast 0
-		if (hit.getY() < 0)
-			hit.setY(0);
-
-		// Add some of  the hit normal. The raycast always hits the edge of the collider. This increases accuracy since we move into the collider or out.
-		hit += res.m_hitNormalWorld * normalMultiplier;
-
-		// Grab the block, and set it to not active - all numbers are floored since blocks take up a whole unit
-		return Game::getInstance()->locationToBlock((int)hit.getX(), (int)hit.getY(), (int)hit.getZ(), true);
+		ivec3 location = adjacent ? hit.adjacent : hit.block;
+		return Game::getInstance()->getWorld()->locationToBlock(location.x, location.y, location.z, true);
 	} else{
-		return nullptr;
+		return Block();
 	}
 }
 
@@ -443,6 +429,9 @@ void FirstPersonController::translateController(glm::vec3 position, float rotati
     this->lookRotation.x = rotation;
 	this->lookRotation.y = 0;
 	rigidBody->translate(btVector3(position.x, position.y, position.z));
+
+	// Jump straight to the new position instead of interpolating towards it
+	previousPosition = getPosition();
 }
 
 
@@ -8,6 +8,7 @@
 
 #include "Block.hpp"
 #include "sre/Camera.hpp"
+#include "sre/RenderPass.hpp"
 #include <SDL_events.h>
 #include <BulletDynamics/Dynamics/btRigidBody.h>
 
@@ -19,7 +20,8 @@ public:
     FirstPersonController(sre::Camera * camera);
 	~FirstPersonController();
 
-    void update(float deltaTime);
+	void fixedUpdate(float timeStep);	// Applies the movement to the rigidbody, called before every physics step
+	void update(float deltaTime, float interpolation);	// Moves the camera between the last two physics steps, interpolation being how far in between
     void onKey(SDL_Event& event);
     void onMouse(SDL_Event &event);
 	void draw(sre::RenderPass& renderpass);
@@ -33,12 +35,12 @@ public:
 	float getMinedAmount() { return minedAmount; }	
 private:
 	void checkGrounded(btVector3 position); // Checks whether the controller is grounded.
-	void destroyBlock(Block* block);		// Destroys the block
+	void destroyBlock(Block block);			// Destroys the block
 	void placeBlock();						// Places a block
 
 	// Does a raycast from the controller to the center of the screen and returns the block the FPS controller is looking at.
-	// normalMultiplier: Allows you to determine whether the normal should be substracted (to get a block), added (to get an empty location) or the border.
-	Block* castRayForBlock(float normalMultiplier); 
+	// adjacent: Return the empty location in front of the face that was looked at instead, where a new block would be placed.
+	Block castRayForBlock(bool adjacent);
 
     sre::Camera * camera;				// Camera that the FPScontroller is attached to
 	btRigidBody* rigidBody;				// Rigidbody of the FPS controller
@@ -48,7 +50,7 @@ private:
 	const float MAX_X_LOOK_UP_ROTATION = 45.0f;		// Max angle the controller can look up
 	const float MAX_X_LOOK_DOWN_ROTATION = 80.0f;	// Max angle the controller can look down
 
-	const float MOVEMENT_SPEED = 200.0f;			// Value the movement is multiplied by per frame
+	const float MOVEMENT_SPEED = 3.33f;				// Units per second the controller walks, independent of the simulation rate
 	const float JUMP_FORCE = 320.0f;				// Force applied when the controller jumps
 	const float JUMP_MOVEMENT_MULTIPLIER = 0.8f;	// Percentage of movement speed the character has whilst mid air
 	const bool NEEDS_GROUNDED_TO_MOVE = false;		// When enabled the controller cannot move mid air
@@ -88,6 +90,7 @@ private:
 
 	// Positional
 	glm::mat4 transformMatrix;	// Transform matrix for the location and rotations of this controller
+	glm::vec3 previousPosition;	// Position of the rigidbody before the last physics step
 	glm::vec2 lookRotation;		// Look rotations of the controller, in euler angles in degrees
 
 	// Variables for the block that the controller holds in its hand.
@@ -96,7 +99,7 @@ private:
 
 	// Delays on mining
 	float minedAmount = 0;	// Duration the player has been mining this block
-	Block* lastBlock;		// Last block that was attempted to be mined
+	Block lastBlock;		// Last block that was attempted to be mined
 
 	// Used to store the locations for debug drawing the lines of the last raycast
 	glm::vec3 fromRay = glm::vec3(0, 0, 0);
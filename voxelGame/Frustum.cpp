@@ -0,0 +1,113 @@
+#include "Frustum.hpp"
+#include <glm/gtc/matrix_access.hpp>
+
+#if defined(__SSE2__) || defined(_M_X64) || (defined(_M_IX86_FP) && _M_IX86_FP >= 2)
+#include <emmintrin.h>
+#define FRUSTUM_SSE2
+#endif
+
+
+void FrustumBoxes::clear() {
+	minX.clear();
+	minY.clear();
+	minZ.clear();
+	maxX.clear();
+	maxY.clear();
+	maxZ.clear();
+}
+
+
+void FrustumBoxes::add(glm::vec3 min, glm::vec3 max) {
+	minX.push_back(min.x);
+	minY.push_back(min.y);
+	minZ.push_back(min.z);
+	maxX.push_back(max.x);
+	maxY.push_back(max.y);
+	maxZ.push_back(max.z);
+}
+
+
+Frustum::Frustum(const glm::mat4& viewProjection) {
+	// A point is inside when -w <= x, y, z <= w in clip space, every inequality is one plane of the frustum.
+	glm::vec4 row0 = glm::row(viewProjection, 0);
+	glm::vec4 row1 = glm::row(viewProjection, 1);
+	glm::vec4 row2 = glm::row(viewProjection, 2);
+	glm::vec4 row3 = glm::row(viewProjection, 3);
+
+	planes[0] = row3 + row0;	// Left
+	planes[1] = row3 - row0;	// Right
+	planes[2] = row3 + row1;	// Bottom
+	planes[3] = row3 - row1;	// Top
+	planes[4] = row3 + row2;	// Near
+	planes[5] = row3 - row2;	// Far
+
+	for (int i = 0; i < 6; i++) {
+		planes[i] /= glm::length(glm::vec3(planes[i]));
+	}
+}
+
+
+bool Frustum::isBoxVisible(glm::vec3 min, glm::vec3 max) const {
+	// The box is outside when the corner furthest along the normal of a plane is still behind it.
+	for (int i = 0; i < 6; i++) {
+		const glm::vec4& plane = planes[i];
+		glm::vec3 corner(plane.x > 0 ? max.x : min.x, plane.y > 0 ? max.y : min.y, plane.z > 0 ? max.z : min.z);
+		if (glm::dot(glm::vec3(plane), corner) + plane.w < 0)
+			return false;
+	}
+	return true;
+}
+
+
+int Frustum::cullBoxes(const FrustumBoxes& boxes, std::vector<uint8_t>& visible) const {
+	int count = boxes.size();
+	visible.resize(count);
+
+	// For every plane the furthest corner is picked per axis from the sign of the normal, which is the same for all boxes.
+	// So instead of selecting per box, the min or max arrays are used directly.
+	const float* cornerX[6];
+	const float* cornerY[6];
+	const float* cornerZ[6];
+	for (int p = 0; p < 6; p++) {
+		cornerX[p] = planes[p].x > 0 ? boxes.maxX.data() : boxes.minX.data();
+		cornerY[p] = planes[p].y > 0 ? boxes.maxY.data() : boxes.minY.data();
+		cornerZ[p] = planes[p].z > 0 ? boxes.maxZ.data() : boxes.minZ.data();
+	}
+
+	int visibleCount = 0;
+	int i = 0;
+#if defined(FRUSTUM_SSE2)
+	for (; i + 4 <= count; i += 4) {
+		__m128 outside = _mm_setzero_ps();
+		for (int p = 0; p < 6; p++) {
+			__m128 distance = _mm_add_ps(
+				_mm_add_ps(_mm_mul_ps(_mm_loadu_ps(cornerX[p] + i), _mm_set1_ps(planes[p].x)), _mm_mul_ps(_mm_loadu_ps(cornerY[p] + i), _mm_set1_ps(planes[p].y))),
+				_mm_add_ps(_mm_mul_ps(_mm_loadu_ps(cornerZ[p] + i), _mm_set1_ps(planes[p].z)), _mm_set1_ps(planes[p].w)));
+			outside = _mm_or_ps(outside, _mm_cmplt_ps(distance, _mm_setzero_ps()));
+		}
+
+		int outsideMask = _mm_movemask_ps(outside);
+		for (int lane = 0; lane < 4; lane++) {
+			uint8_t inside = (outsideMask >> lane) & 1 ? 0 : 1;
+			visible[i + lane] = inside;
+			visibleCount += inside;
+		}
+	}
+#endif
+
+	// Whatever does not fill a whole vector.
+	for (; i < count; i++) {
+		uint8_t inside = 1;
+		for (int p = 0; p < 6; p++) {
+			float distance = cornerX[p][i] * planes[p].x + cornerY[p][i] * planes[p].y + cornerZ[p][i] * planes[p].z + planes[p].w;
+			if (distance < 0) {
+				inside = 0;
+				break;
+			}
+		}
+		visible[i] = inside;
+		visibleCount += inside;
+	}
+
+	return visibleCount;
+}
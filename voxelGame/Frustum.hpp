@@ -0,0 +1,35 @@
+/*
+* Frustum - Created: 16-10-2026
+* The six planes of a camera frustum, used to skip objects the camera can not see before they are drawn.
+* Boxes are tested in batches, four at a time with SSE2, given as separate arrays for each coordinate of their corners.
+*/
+#pragma once
+
+#include <cstdint>
+#include <vector>
+#include <glm/glm.hpp>
+
+
+
+// Axis aligned boxes stored as one array per coordinate, so a batch of boxes can be loaded into vector registers directly.
+struct FrustumBoxes {
+	std::vector<float> minX, minY, minZ;
+	std::vector<float> maxX, maxY, maxZ;
+
+	void clear();
+	void add(glm::vec3 min, glm::vec3 max);
+	int size() const { return (int)minX.size(); }
+};
+
+
+class Frustum {
+public:
+	explicit Frustum(const glm::mat4& viewProjection);	// Extracts the planes from the combined projection and view transform
+
+	bool isBoxVisible(glm::vec3 min, glm::vec3 max) const;	// Whether the box is at least partly inside the frustum
+
+	// Tests all boxes, visible[i] becomes 1 for boxes at least partly inside and 0 for the others. Returns the amount of visible boxes.
+	int cullBoxes(const FrustumBoxes& boxes, std::vector<uint8_t>& visible) const;
+private:
+	glm::vec4 planes[6];	// Normal in xyz pointing inwards, distance in w
+};
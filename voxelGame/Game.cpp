@@ -6,10 +6,14 @@
 */
 #include <glm/gtx/rotate_vector.hpp>
 #include "Game.hpp"
+#include "ChunkMesher.hpp"
 #include <sre/Profiler.hpp>
+#include <sre/ScopeProfiler.hpp>
+#include <sre/GpuTimer.hpp>
 #include "rapidjson/document.h"
 #include "rapidjson/istreamwrapper.h"
 #include <fstream>
+#include <climits>
 #include <iostream>
 #include <glm/gtc/matrix_access.inl>
 
@@ -22,15 +26,18 @@ Game::Game() {
 	// TODO clean this to be proper singleton
 	Game::instance = this;
 	Game::instanceFlag = true;
+	ScopeProfiler::setThreadName("Main");
 
 	// First initialize physics, then the renderer and lastly the game itself.
 	physics.init();
     renderer.init();
     init();
 
-	// Run Update, first update physics, then the game.
+	// Run the simulation at a fixed rate, and update the game once per frame in between.
+	renderer.fixedUpdate = [&](float timeStep) {
+		fixedUpdate(timeStep);
+	};
     renderer.frameUpdate = [&](float deltaTime){
-		physics.update();
         update(deltaTime);
     };
 
@@ -53,19 +60,18 @@ Game::Game() {
 
 	// Start the event loop
     renderer.startEventLoop();
+
+	// The game is closing, write back the changes of the chunks that are still loaded.
+	saveDirtyChunks();
+	worldStorage.flush();
 }
 
 
 Game::~Game() {
 	delete blockMeshes;
 
-	for (int x = 0; x < chunkArrayX; x++) {
-		for (int y = 0; y < chunkArrayY; y++) {
-			delete chunkArray[x][y];
-		}
-		delete chunkArray[x];
-	}
-	delete chunkArray;
+	world.getChunks().clear();
+	delete chunkArena;
 }
 
 
@@ -83,25 +89,53 @@ Game* Game::getInstance(){
 }
 
 
+void Game::fixedUpdate(float timeStep) {
+	SRE_PROFILE_SCOPE("Game::fixedUpdate");
+
+	// The controller sets its velocity before physics moves it.
+	fpsController->fixedUpdate(timeStep);
+	physics.update(timeStep);
+}
+
+
 void Game::update(float deltaTime) {
-	// Update the FPS controller
-    fpsController->update(deltaTime);
+	SRE_PROFILE_SCOPE("Game::update");
+
+	// Upload the textures that finished loading in the background
+	textureLoader.update();
+
+	// Update the FPS controller, the camera follows the player in between physics steps
+    fpsController->update(deltaTime, renderer.getFixedUpdateInterpolation());
 
-	// Only load colliders near the player
+	// Stream chunks around the player
 	vec3 playerPosition = fpsController->getPosition();
-	loadColliders((int)(playerPosition.x / Chunk::chunkSize), (int)(playerPosition.y / Chunk::chunkSize), (int)(playerPosition.z / Chunk::chunkSize));
+	ivec3 playerChunk = Chunk::toChunkCoordinates(ivec3(glm::floor(playerPosition + 0.5f)));
+	streamChunks(playerChunk, chunksLoadedPerFrame);
+
+	// Every now and then save the chunks that changed, so a crash does not lose everything. The writing happens in the background.
+	timeSinceAutosave += deltaTime;
+	if (timeSinceAutosave >= autosaveInterval) {
+		timeSinceAutosave = 0;
+		saveDirtyChunks();
+	}
 
-	// Update all chunks
-	for (int i = 0; i < chunkArrayX; i++) {
-		for (int j = 0; j < chunkArrayY; j++) {
-			for (int k = 0; k < chunkArrayZ; k++) {
-				chunkArray[i][j][k]->update(deltaTime);
-			}
+	// Update all chunks, far away chunks are meshed with less detail. All levels are set before any chunk meshes,
+	// since the sides of a chunk depend on the levels of its neighbours.
+	{
+		SRE_PROFILE_SCOPE("Game::updateChunks");
+		for (auto& pair : world.getChunks()) {
+			pair.second->setLod(getLod(pair.first - playerChunk));
+		}
+		for (auto& pair : world.getChunks()) {
+			pair.second->update(deltaTime);
 		}
 	}
 
 	// Update particle systems
-	particleSystem->update(deltaTime);
+	{
+		SRE_PROFILE_SCOPE("ParticleSystem::update");
+		particleSystem->update(deltaTime);
+	}
 
 	// # TODO move into particle system?
 	if(particleSystem->emitting) {
@@ -115,19 +149,31 @@ void Game::update(float deltaTime) {
 
 
 void Game::render() {
+	SRE_PROFILE_SCOPE("Game::render");
+
 	// Create a render pass
 	auto renderPass = RenderPass::create()
+		.withName("World")
 		.withCamera(camera)
 		.withWorldLights(&worldLights)
 		.withClearColor(true, { 0.73f, 0.83f, 1, 1 })
+		.withSortedDraws()
 		.build();
 
-	// Draw objects 
+	// Draw objects, they are submitted sorted by state when each group ends.
+	// The groups are timed on the GPU when the profiler is shown.
+	renderPass.beginGroup("Chunks");
 	drawChunks(renderPass);
+	renderPass.endGroup();
+
+	renderPass.beginGroup("Held block");
 	fpsController->draw(renderPass);
+	renderPass.endGroup();
 
 	// Draw Particles
+	renderPass.beginGroup("Particles");
 	particleSystem->draw(renderPass);
+	renderPass.endGroup();
 
 	// Allow physics debug drawer to draw if enabled
 	if(physicsDebugDraw)
@@ -141,11 +187,14 @@ void Game::render() {
 		static Profiler profiler;
 		profiler.update();
 		profiler.gui(false);
+		drawFramePacing();
+		drawWorldStats();
 	}
 
 	// Create a second renderpass for the crosshair.
 	sre::Camera simpleCamera;
 	auto simplePass = RenderPass::create()
+		.withName("Crosshair")
 		.withCamera(simpleCamera)
 		.withClearColor(false, { 0, 0, 0, 1 })
 		.withGUI(false)
@@ -163,16 +212,86 @@ void Game::render() {
 
 
 void Game::drawChunks(sre::RenderPass & renderPass) {
-	for (int x = 0; x < chunkArrayX; x++) {
-		for (int y = 0; y < chunkArrayY; y++) {
-			for (int z = 0; z < chunkArrayZ; z++) {
-				chunkArray[x][y][z]->draw(renderPass);
-			}
+	SRE_PROFILE_SCOPE("Game::drawChunks");
+
+	// Only chunks that can be reached from the camera through air can be seen.
+	if (caveCulling)
+		findReachableChunks(Chunk::toChunkCoordinates(ivec3(glm::floor(camera.getPosition() + 0.5f))));
+
+	// Gather the bounds of the chunks that have something to draw, so they can be tested against the frustum in one batch.
+	drawableChunks.clear();
+	drawableBounds.clear();
+	caveCulledCount = 0;
+	auto& chunks = world.getChunks();
+	for (auto& pair : chunks) {
+		Chunk* chunk = pair.second.get();
+		if (!chunk->hasMesh())
+			continue;
+
+		if (caveCulling && reachedChunks.find(pair.first) == reachedChunks.end()) {
+			caveCulledCount++;
+			continue;
 		}
+
+		drawableChunks.push_back(chunk);
+		drawableBounds.add(chunk->getBoundsMin(), chunk->getBoundsMax());
+	}
+
+	// Same projection as the render pass uses, which is based on the size of the window.
+	Frustum frustum(camera.getProjectionTransform(static_cast<glm::uvec2>(Renderer::instance->getDrawableSize())) * camera.getViewTransform());
+	int visibleCount = frustum.cullBoxes(drawableBounds, chunkVisibility);
+
+	for (size_t i = 0; i < drawableChunks.size(); i++) {
+		if (chunkVisibility[i])
+			drawableChunks[i]->draw();
 	}
+	chunkArena->draw(renderPass, chunkMaterial);
+
+	// Chunks without a mesh count as culled too, they add nothing to the draw call either.
+	renderPass.addCullingStats(visibleCount, (int)chunks.size() - visibleCount);
 }	
 
 
+void Game::findReachableChunks(glm::ivec3 start) {
+	SRE_PROFILE_SCOPE("Game::findReachableChunks");
+	const ivec3 directions[6] = { ivec3(-1, 0, 0), ivec3(1, 0, 0), ivec3(0, -1, 0), ivec3(0, 1, 0), ivec3(0, 0, -1), ivec3(0, 0, 1) };
+
+	// The walk stays within the loaded area and one chunk above and below it. Places in there without a chunk are open air.
+	ivec3 minChunk(streamCenter.x - viewDistance - 1, -1, streamCenter.z - viewDistance - 1);
+	ivec3 maxChunk(streamCenter.x + viewDistance + 1, worldHeight, streamCenter.z + viewDistance + 1);
+	start = glm::clamp(start, minChunk, maxChunk);
+
+	reachedChunks.clear();
+	caveSteps.clear();
+	caveSteps.push_back({ start, -1, 0 });
+	reachedChunks.insert(start);
+
+	// Breadth first, every chunk is entered once through the side it is first reached by.
+	for (size_t i = 0; i < caveSteps.size(); i++) {
+		CaveStep step = caveSteps[i];
+		auto chunk = world.getChunk(step.position.x, step.position.y, step.position.z);
+
+		for (int to = 0; to < 6; to++) {
+			// Going back against a direction taken before can only reach chunks that are hidden by the ones passed through.
+			if (step.directions & (1 << (to ^ 1)))
+				continue;
+
+			if (chunk != nullptr && step.from >= 0 && !chunk->isConnected(step.from, to))
+				continue;
+
+			ivec3 next = step.position + directions[to];
+			if (glm::any(glm::lessThan(next, minChunk)) || glm::any(glm::greaterThan(next, maxChunk)))
+				continue;
+
+			if (!reachedChunks.insert(next).second)
+				continue;
+
+			caveSteps.push_back({ next, to ^ 1, step.directions | (1 << to) });
+		}
+	}
+}
+
+
 void Game::drawGUI() {
 	ImGui::SetNextWindowPos(ImVec2(Renderer::instance->getWindowSize().x / 2 - 100, .0f), ImGuiSetCond_Always);
 	ImGui::SetNextWindowSize(ImVec2(200, 100), ImGuiSetCond_Always);
@@ -193,6 +312,97 @@ void Game::drawGUI() {
 }
 
 
+void Game::drawFramePacing() {
+	if (!ImGui::CollapsingHeader("Frame pacing"))
+		return;
+
+	// Physics always steps at the fixed rate, changing it trades accuracy for time spent simulating.
+	int fixedUpdateRate = (int)glm::round(renderer.getFixedUpdateRate());
+	if (ImGui::SliderInt("Simulation rate", &fixedUpdateRate, 20, 240))
+		renderer.setFixedUpdateRate((float)fixedUpdateRate);
+
+	// Zero renders as fast as possible, the loop sleeps rather than spinning when there is a limit.
+	int frameRateLimit = (int)glm::round(renderer.getFrameRateLimit());
+	if (ImGui::SliderInt("Frame rate limit", &frameRateLimit, 0, 240))
+		renderer.setFrameRateLimit((float)frameRateLimit);
+
+	bool vsync = Renderer::instance->usesVSync();
+	if (ImGui::Checkbox("VSync", &vsync))
+		Renderer::instance->setVSync(vsync);
+}
+
+
+void Game::drawWorldStats() {
+	if (!ImGui::CollapsingHeader("World"))
+		return;
+
+	// Gather the block memory of all chunks, and how many chunks use each palette width.
+	int chunkCount = 0;
+	int blockBytes = 0;
+	int chunksPerWidth[9] = { 0 };
+	int chunksPerLod[ChunkMesher::maxLod + 1] = { 0 };
+	int faces = 0;
+	int triangles = 0;
+	int meshBytes = 0;
+	for (auto& pair : world.getChunks()) {
+		const BlockStorage& storage = pair.second->getBlockStorage();
+		blockBytes += storage.getMemoryUsage();
+		chunksPerWidth[storage.getBitsPerBlock()]++;
+		chunkCount++;
+		faces += pair.second->getFaceCount();
+		triangles += pair.second->getTriangleCount();
+		meshBytes += pair.second->getMeshBytes();
+		if (pair.second->hasMesh())
+			chunksPerLod[pair.second->getMeshLod()]++;
+	}
+
+	// Changing the view distance streams chunks in or out on the next update.
+	if (ImGui::SliderInt("View distance", &viewDistance, 1, 32))
+		streamingComplete = false;
+
+	ImGui::LabelText("Chunks", "%i", chunkCount);
+	ImGui::LabelText("Pooled/allocated chunks", "%i/%i", chunkPool.getFreeCount(), chunkPool.getCreatedCount());
+	ImGui::LabelText("Block memory", "%.1f KB", blockBytes / 1000.0f);
+	ImGui::LabelText("Bytes per chunk", "%.1f", chunkCount > 0 ? blockBytes / (float)chunkCount : 0.0f);
+	ImGui::LabelText("Uncompressed per chunk", "%i", (int)(Chunk::blockCount * sizeof(BlockId)));
+	ImGui::LabelText("Single value chunks", "%i", chunksPerWidth[0]);
+	ImGui::LabelText("1/2/4/8 bit chunks", "%i/%i/%i/%i", chunksPerWidth[1], chunksPerWidth[2], chunksPerWidth[4], chunksPerWidth[8]);
+
+	// Unloaded chunks kept in the brick map
+	ImGui::SliderInt("Resident distance", &residentDistance, 8, 256);
+	ImGui::LabelText("Resident bricks/nodes", "%i/%i", residentChunks.getBrickCount(), residentChunks.getNodeCount());
+	ImGui::LabelText("Resident memory", "%.1f KB", residentChunks.getMemoryUsage() / 1000.0f);
+
+	// Compare the triangles in the chunk meshes with the two triangles per face an unmerged mesh needs.
+	int naiveTriangles = faces * 2;
+	ImGui::LabelText("Greedy meshing", world.isGreedyMeshing() ? "On (3 to toggle)" : "Off (3 to toggle)");
+	ImGui::LabelText("Chunk triangles", "%i", triangles);
+	ImGui::LabelText("Without merging", "%i", naiveTriangles);
+	ImGui::LabelText("Saved triangles", "%i (%.1f%%)", naiveTriangles - triangles, naiveTriangles > 0 ? 100.0f * (naiveTriangles - triangles) / naiveTriangles : 0.0f);
+	ImGui::LabelText("Chunk mesh memory", "%.1f KB", meshBytes / 1000.0f);
+	ImGui::LabelText("Bytes per triangle", "%.1f", triangles > 0 ? meshBytes / (float)triangles : 0.0f);
+	ImGui::LabelText("Arena pages used/total", "%i/%i", chunkArena->getUsedPages(), chunkArena->getPageCount());
+	ImGui::LabelText("Arena allocations", "%i", chunkArena->getAllocationCount());
+	ImGui::LabelText("Arena memory", "%.1f KB", chunkArena->getDataSize() / 1000.0f);
+
+	// Visibility
+	ImGui::Checkbox("Cave culling", &caveCulling);
+	ImGui::LabelText("Hidden behind terrain", "%i", caveCulledCount);
+
+	// Level of detail
+	ImGui::SliderInt("LOD distance", &lodDistance, 1, 32);
+	ImGui::LabelText("LOD 0/1/2/3 meshes", "%i/%i/%i/%i", chunksPerLod[0], chunksPerLod[1], chunksPerLod[2], chunksPerLod[3]);
+
+	// Background meshing
+	ImGui::LabelText("Mesh workers", "%i", jobPool.getThreadCount());
+	ImGui::LabelText("Pending jobs", "%i", jobPool.getPendingJobCount());
+
+	// Saving
+	ImGui::LabelText("Pending chunk writes", "%i", worldStorage.getPendingWriteCount());
+	ImGui::LabelText("Chunks written", "%i", worldStorage.getWrittenCount());
+}
+
+
 void Game::onKey(SDL_Event& e) {
 	// Toggle debug drawing of physics with 1
 	if (e.type == SDL_KEYUP && e.key.keysym.sym == SDLK_1) {
@@ -204,9 +414,20 @@ void Game::onKey(SDL_Event& e) {
 			physics.setDebugDrawMode(btIDebugDraw::DBG_NoDebug);
 	}
 
-	// Toggle debug profiler
+	// Toggle debug profiler, scopes are only recorded while it is shown
 	if (e.type == SDL_KEYUP && e.key.keysym.sym == SDLK_2) {
 		debugProfiler = !debugProfiler;
+		ScopeProfiler::setEnabled(debugProfiler);
+		GpuTimer::setEnabled(debugProfiler);
+	}
+
+	// Toggle greedy meshing, all chunks are remeshed so the difference shows immediately
+	if (e.type == SDL_KEYUP && e.key.keysym.sym == SDLK_3) {
+		world.setGreedyMeshing(!world.isGreedyMeshing());
+
+		for (auto& pair : world.getChunks()) {
+			pair.second->flagRecalculateMesh();
+		}
 	}
 
 	// Toggle mouse capture
@@ -226,12 +447,19 @@ void Game::init() {
 
 	// Setup the material used by all blocks
 	blockMaterial = Shader::getStandard()->createMaterial();
-	auto tiles = Texture::create().withFile("tileset.png")
+	auto tiles = Texture::create().withFileAsync("tileset.png", &textureLoader)
 		.withGenerateMipmaps(false)
 		.withFilterSampling(false)
 		.build();
 	blockMaterial->setTexture(tiles);
 
+	// Setup the material used by all chunks, it shares the tileset with the blocks
+	chunkMaterial = createChunkShader()->createMaterial();
+	chunkMaterial->setTexture(tiles);
+	chunkMaterial->set("tileLayout", ChunkMesher::tileLayout());
+	chunkArena = new ChunkArena();
+	world.setRenderer(chunkArena);
+
 
 	// Setup a block mesh for all blocktypes we have. 
 	// These are used to display a block in the hand of the controller.
@@ -250,39 +478,24 @@ void Game::init() {
 	updateEmit();
 
 
-	// Locally store the size of the chunks, since we will be using it a lot
-	int chunkSize = Chunk::chunkSize;
-	
-	// Setup the multidimensional chunk array which holds all our chunks
-	chunkArray = new std::shared_ptr<Chunk>**[chunkArrayX];
-	for (int x = 0; x < chunkArrayX; x++) {
-		chunkArray[x] = new std::shared_ptr<Chunk>*[chunkArrayY];
-		for (int y = 0; y < chunkArrayY; y++) {
-			chunkArray[x][y] = new std::shared_ptr<Chunk>[chunkArrayZ];
-		}
-	}
-
-	// Fill the chunk arrays
-	for (int x = 0; x < chunkArrayX; x++) {
-		for (int y = 0; y < chunkArrayY; y++) {
-			for (int z = 0; z < chunkArrayZ; z++) {
-				chunkArray[x][y][z] = std::make_shared<Chunk>(glm::vec3(x * chunkSize, y * chunkSize, z * chunkSize));
-			}
-		}
-	}
-
-
 	// Directional Light
 	worldLights.addLight(Light::create()
 		.withDirectionalLight(glm::normalize(glm::vec3(0.7f, 0.7f, 0.7f)))
 		.build());
 
 
+	// Terrain is generated from the seed stored with the world, so chunks that were not saved come back the same.
+	world.setTerrainGenerator(std::make_shared<NoiseTerrainGenerator>(worldStorage.loadSeed()));
+
+	// The world reaches the physics for the chunk colliders, and tells the game about mined blocks for the particles.
+	world.setPhysics(&physics);
+	world.setListener(this);
+
 	// Setup FPS Controller
 	fpsController = new  FirstPersonController(&camera);
 
-	// Spawn the player in the middle of the world.
-    fpsController->translateController(vec3(chunkArrayX * Chunk::chunkSize *  0.5f, Chunk::chunkSize + 3.0f, chunkArrayZ * Chunk::chunkSize *  0.5f), 0);
+	// Spawn the player at the origin of the world, above the ground.
+    fpsController->translateController(vec3(0, world.getTerrainGenerator()->getSurfaceHeight(0, 0) + 4.0f, 0), 0);
 
 
 	// Setup the mouse lock to our default state
@@ -292,35 +505,231 @@ void Game::init() {
 	SDL_SetRelativeMouseMode(mouseLock ? SDL_TRUE : SDL_FALSE);
 	fpsController->setLockRotation(!mouseLock);
 
-	// Setup the colliders to be loaded near the player
-	// Only load colliders near the player
+	// Load all chunks around the player at once, so there is ground to stand on.
 	vec3 playerPosition = fpsController->getPosition();
-	loadColliders((int)(playerPosition.x / Chunk::chunkSize), (int)(playerPosition.y / Chunk::chunkSize), (int)(playerPosition.z / Chunk::chunkSize));
+	ivec3 playerChunk = Chunk::toChunkCoordinates(ivec3(glm::floor(playerPosition + 0.5f)));
+	streamChunks(playerChunk, INT_MAX);
+
+	// Wait for the terrain to be generated, and let the chunks pick up their blocks.
+	jobPool.waitIdle();
+	for (auto& pair : world.getChunks()) {
+		pair.second->update(0);
+	}
 }
 
 
-// # TODO add a cooldown to a change, so not everything is constantly switching when the player is on a chunk edge
-void  Game::loadColliders(int xPos, int yPos, int zPos) {
-	// Loop over all chunks
-	for (int x = 0; x < chunkArrayX; x++){
-		for (int y = 0; y < chunkArrayY; y++){
-			for (int z = 0; z < chunkArrayZ; z++){
-				auto chunk = getChunk(x, y, z);
+void Game::streamChunks(glm::ivec3 center, int maxLoads) {
+	SRE_PROFILE_SCOPE("Game::streamChunks");
+
+	// Nothing changed since everything around this chunk was loaded.
+	if (streamingComplete && center == streamCenter)
+		return;
+
+	streamCenter = center;
+	auto& chunks = world.getChunks();
+
+	// Unload chunks that are out of view. One chunk of slack avoids reloading chunks when the player walks back and forth over a chunk edge.
+	for (auto it = chunks.begin(); it != chunks.end();) {
+		ivec3 offset = it->first - center;
+		if (glm::max(glm::abs(offset.x), glm::abs(offset.z)) > viewDistance + 1) {
+			if (it->second->isDirty())
+				worldStorage.save(it->first, it->second->getBlockStorage());
 
-				if(chunk == nullptr)
+			// Keep the blocks around in compact form, unless the generator never finished them.
+			if (!it->second->isGenerating())
+				residentChunks.setBrick(it->first, it->second->getBlockStorage());
+
+			chunkPool.release(it->second);
+			it = chunks.erase(it);
+		} else {
+			it++;
+		}
+	}
+
+	// Forget the chunks that are too far away, they are read from disk or generated again when the player returns.
+	ivec3 residentExtent(glm::max(residentDistance, viewDistance + 1), 0, glm::max(residentDistance, viewDistance + 1));
+	residentChunks.removeOutside(ivec3(center.x, 0, center.z) - residentExtent, ivec3(center.x, worldHeight - 1, center.z) + residentExtent);
+
+	// Load missing chunks ring by ring around the player, so the nearest chunks appear first.
+	int loaded = 0;
+	for (int ring = 0; ring <= viewDistance; ring++) {
+		for (int x = -ring; x <= ring; x++) {
+			for (int z = -ring; z <= ring; z++) {
+				// Only the outline of the ring, the inside was done by the previous rings.
+				if (glm::max(glm::abs(x), glm::abs(z)) != ring)
 					continue;
 
-				// Enable the 9 surrounding chunks
-				if (x >= xPos - 1 && x <= xPos + 1 && y >= yPos - 1 && y <= yPos + 1 && z >= zPos - 1 && z <= zPos + 1) {
-					chunk->addCollidersToWorld();
-				}
-				// Disable the others
-				else {
-					chunk->removeCollidersFromWorld();
+				for (int y = 0; y < worldHeight; y++) {
+					ivec3 position(center.x + x, y, center.z + z);
+					if (chunks.find(position) != chunks.end())
+						continue;
+
+					// Continue next frame when we loaded enough for this one.
+					if (loaded >= maxLoads) {
+						streamingComplete = false;
+						return;
+					}
+
+					loadChunk(position);
+					loaded++;
 				}
 			}
 		}
 	}
+
+	streamingComplete = true;
+}
+
+
+int Game::getLod(glm::ivec3 offset) {
+	// The distance only changes when the player crosses a chunk edge, so chunks do not switch back and forth.
+	int distance = glm::max(glm::abs(offset.x), glm::abs(offset.z));
+	int lod = 0;
+	while (lod < ChunkMesher::maxLod && distance > lodDistance << lod)
+		lod++;
+	return lod;
+}
+
+
+void Game::loadChunk(glm::ivec3 position) {
+	auto chunk = chunkPool.acquire(vec3(position * Chunk::chunkSize));
+	world.getChunks()[position] = chunk;
+
+	// Every loaded chunk collides, its single static body is cheap for the broadphase.
+	chunk->addCollidersToWorld();
+
+	// Chunks that are still resident or were saved before keep their changes, only chunks that were never saved are generated.
+	// Generated chunks flag their neighbours once their blocks are done. The loaded chunk takes over from the resident copy.
+	BlockStorage saved(Chunk::blockCount);
+	if (residentChunks.getBrick(position, saved)) {
+		residentChunks.removeBrick(position);
+		chunk->setBlocks(saved);
+		world.flagNeighbourChunksForRecalculate(position);
+	} else if (worldStorage.load(position, saved)) {
+		chunk->setBlocks(saved);
+		world.flagNeighbourChunksForRecalculate(position);
+	} else {
+		chunk->generateBlocks();
+	}
+}
+
+
+void Game::saveDirtyChunks() {
+	SRE_PROFILE_SCOPE("Game::saveDirtyChunks");
+	for (auto& pair : world.getChunks()) {
+		if (pair.second->isDirty()) {
+			worldStorage.save(pair.first, pair.second->getBlockStorage());
+			pair.second->clearDirty();
+		}
+	}
+}
+
+
+std::shared_ptr<sre::Shader> Game::createChunkShader() {
+	// Same lighting as the standard shader without specular. The vertices are packed into two u8vec4 attributes, see ChunkMeshData.
+	// The position on the face counts blocks, wrapping it makes the tile repeat once per block over merged faces.
+	std::string vertexShader = R"(#version 140
+in uvec4 packedPosition;
+in uvec4 packedTile;
+out vec3 vNormal;
+out vec4 vUV;
+out vec3 vEyePos;
+
+uniform mat4 g_model;
+uniform mat4 g_view;
+uniform mat4 g_projection;
+uniform mat3 g_normal;
+uniform vec4 tileLayout;
+uniform sampler2D pageTable;
+uniform vec4 arenaOrigin;
+uniform vec4 arenaLayout;
+
+const vec3 faceNormals[6] = vec3[6](
+    vec3(-1.0, 0.0, 0.0), vec3(1.0, 0.0, 0.0),
+    vec3(0.0, -1.0, 0.0), vec3(0.0, 1.0, 0.0),
+    vec3(0.0, 0.0, -1.0), vec3(0.0, 0.0, 1.0)
+);
+
+void main(void) {
+    // All chunks share one vertex buffer, the page of the vertex tells which chunk it belongs to. See ChunkArena.
+    int page = gl_VertexID / int(arenaLayout.x);
+    int pagesPerRow = int(arenaLayout.y);
+    vec3 chunkOffset = floor(texelFetch(pageTable, ivec2(page % pagesPerRow, page / pagesPerRow), 0).xyz * 255.0 + 0.5) - 128.0;
+    vec3 position = (arenaOrigin.xyz + chunkOffset) * arenaLayout.z + vec3(packedPosition.xyz) - 0.5;
+    vec4 eyePos = g_view * g_model * vec4(position,1.0);
+    gl_Position = g_projection * eyePos;
+    vNormal = normalize(g_normal * faceNormals[int(packedPosition.w)]);
+
+    // Tiles are laid out in rows from the top left of the atlas, the origin is the bottom left corner of the tile.
+    int tile = int(packedTile.x);
+    int tilesPerRow = int(tileLayout.z);
+    vec2 tileOrigin = vec2(float(tile % tilesPerRow) * tileLayout.x, 1.0 - float(tile / tilesPerRow + 1) * tileLayout.y);
+    vUV = vec4(vec2(packedTile.yz), tileOrigin);
+    vEyePos = eyePos.xyz;
+}
+)";
+
+	std::string fragmentShader = R"(#version 140
+out vec4 fragColor;
+in vec3 vNormal;
+in vec4 vUV;
+in vec3 vEyePos;
+
+uniform vec3 g_ambientLight;
+uniform vec4 color;
+uniform sampler2D tex;
+uniform vec4 tileLayout;
+
+uniform vec4 g_lightPosType[4];
+uniform vec4 g_lightColorRange[4];
+
+vec3 computeLight(){
+    vec3 lightColor = vec3(0.0,0.0,0.0);
+    vec3 normal = normalize(vNormal);
+    for (int i=0;i<4;i++){
+        bool isDirectional = g_lightPosType[i].w == 0.0;
+        bool isPoint       = g_lightPosType[i].w == 1.0;
+        vec3 lightDirection;
+        float att = 1.0;
+        if (isDirectional){
+            lightDirection = g_lightPosType[i].xyz;
+        } else if (isPoint) {
+            vec3 lightVector = g_lightPosType[i].xyz - vEyePos;
+            float lightVectorLength = length(lightVector);
+            float lightRange = g_lightColorRange[i].w;
+            lightDirection = lightVector / lightVectorLength;
+            if (lightRange <= 0.0){
+                att = 1.0;
+            } else if (lightVectorLength >= lightRange){
+                att = 0.0;
+            } else {
+                att = pow(1.0 - lightVectorLength / lightRange,1.5);
+            }
+        } else {
+            continue;
+        }
+
+        float thisDiffuse = max(0.0,dot(lightDirection, normal));
+        if (thisDiffuse > 0.0){
+           lightColor += (att * thisDiffuse) * g_lightColorRange[i].xyz;
+        }
+    }
+    return max(g_ambientLight.xyz, lightColor);
+}
+
+void main(void)
+{
+    vec2 uv = vUV.zw + fract(vUV.xy) * tileLayout.xy;
+    vec4 c = color * texture(tex, uv);
+
+    fragColor = c * vec4(computeLight(), 1.0);
+}
+)";
+
+	return Shader::create()
+		.withSource(vertexShader, fragmentShader)
+		.withName("Chunk")
+		.build();
 }
 
 
@@ -330,37 +739,37 @@ std::shared_ptr<sre::Mesh> Game::createBlockMesh(BlockType type) {
 	std::vector<glm::vec4> uvs;			
 
 	// Collect texture coordinates for each side
-	glm::vec4 coords = textureCoordinates(Block::getTextureIndex(type, BlockSides::Front));
+	glm::vec4 coords = ChunkMesher::textureCoordinates(Block::getTextureIndex(type, BlockSides::Front));
 	uvs.insert(uvs.end(), { // z+
 		glm::vec4(coords.x,coords.y,0,0), glm::vec4(coords.z,coords.y,0,0), glm::vec4(coords.z,coords.w,0,0),
 		glm::vec4(coords.x,coords.y,0,0), glm::vec4(coords.z,coords.w,0,0), glm::vec4(coords.x,coords.w,0,0)
 	});
 	
-	coords = textureCoordinates(Block::getTextureIndex(type, BlockSides::Left));
+	coords = ChunkMesher::textureCoordinates(Block::getTextureIndex(type, BlockSides::Left));
 	uvs.insert(uvs.end(), {
 		glm::vec4(coords.x,coords.y,0,0), glm::vec4(coords.z,coords.y,0,0), glm::vec4(coords.z,coords.w,0,0),
 		glm::vec4(coords.x,coords.y,0,0), glm::vec4(coords.z,coords.w,0,0), glm::vec4(coords.x,coords.w,0,0),
 	});
 
-	coords = textureCoordinates(Block::getTextureIndex(type, BlockSides::Back));
+	coords = ChunkMesher::textureCoordinates(Block::getTextureIndex(type, BlockSides::Back));
 	uvs.insert(uvs.end(),{
 		glm::vec4(coords.x,coords.y,0,0), glm::vec4(coords.z,coords.y,0,0), glm::vec4(coords.z,coords.w,0,0),
 		glm::vec4(coords.x,coords.y,0,0), glm::vec4(coords.z,coords.w,0,0), glm::vec4(coords.x,coords.w,0,0),
 	});
 
-	coords = textureCoordinates(Block::getTextureIndex(type, BlockSides::Right));
+	coords = ChunkMesher::textureCoordinates(Block::getTextureIndex(type, BlockSides::Right));
 	uvs.insert(uvs.end(),{
 		glm::vec4(coords.x,coords.y,0,0), glm::vec4(coords.z,coords.y,0,0), glm::vec4(coords.z,coords.w,0,0),
 		glm::vec4(coords.x,coords.y,0,0), glm::vec4(coords.z,coords.w,0,0), glm::vec4(coords.x,coords.w,0,0),
 	});
 
-	coords = textureCoordinates(Block::getTextureIndex(type, BlockSides::Top));
+	coords = ChunkMesher::textureCoordinates(Block::getTextureIndex(type, BlockSides::Top));
 	uvs.insert(uvs.end(),{ // top
 		glm::vec4(coords.x,coords.y,0,0), glm::vec4(coords.z,coords.y,0,0), glm::vec4(coords.z,coords.w,0,0),
 		glm::vec4(coords.x,coords.y,0,0), glm::vec4(coords.z,coords.w,0,0), glm::vec4(coords.x,coords.w,0,0),
 	});
 
-	coords = textureCoordinates(Block::getTextureIndex(type, BlockSides::Bottom));
+	coords = ChunkMesher::textureCoordinates(Block::getTextureIndex(type, BlockSides::Bottom));
 	uvs.insert(uvs.end(),{ // bottom
 		glm::vec4(coords.x,coords.y,0,0), glm::vec4(coords.z,coords.y,0,0), glm::vec4(coords.z,coords.w,0,0),
 		glm::vec4(coords.x,coords.y,0,0), glm::vec4(coords.z,coords.w,0,0), glm::vec4(coords.x,coords.w,0,0),
@@ -370,132 +779,6 @@ std::shared_ptr<sre::Mesh> Game::createBlockMesh(BlockType type) {
 }
 
 
-// # TODO rename function
-glm::vec4 Game::textureCoordinates(int textureId) {
-	glm::vec2 textureSize(1024, 2048);
-	glm::vec2 tileSize(128, 128);
-
-	float tileWidth = tileSize.x / textureSize.x;
-	float tileHeight = tileSize.y / textureSize.y;
-
-	glm::vec2 min = glm::vec2(0, 1.0f);							// Start at top left
-	glm::vec2 max = min + glm::vec2(tileWidth, -tileHeight);	// Move max to bottom right corner of this block
-
-	int tilesX = textureSize.x / tileSize.x;
-
-	float xOffset = (textureId % tilesX) * tileWidth;
-	float yOffset = ((textureId - (textureId % tilesX)) / tilesX) * tileHeight;
-
-	min.x += xOffset;
-	max.x += xOffset;
-
-	min.y -= yOffset;
-	max.y -= yOffset;
-
-	return glm::vec4(min.x, min.y, max.x, max.y);
-}
-
-
-// # TODO rename function
-Block* Game::locationToBlock(int x, int y, int z, bool ghostInspect) {
-	// Determine the chunk coordinates, and local block coordinates.
-	vec3 blockPos = glm::vec3(x % Chunk::chunkSize, y % Chunk::chunkSize, z % Chunk::chunkSize);
-	vec3 chunkPos = glm::vec3((x - blockPos.x) / Chunk::chunkSize, (y - blockPos.y) / Chunk::chunkSize, (z - blockPos.z) / Chunk::chunkSize);
-
-	// Get a pointer to the chunk we want to access.
-	auto chunk = getChunk((int)chunkPos.x, (int)chunkPos.y, (int)chunkPos.z);
-
-	// If we tried to get a chunk which does not exist, we can already return and don't need to do anything else.
-	if (chunk == nullptr)
-		return nullptr;
-
-	// If ghost mode is not activated, changes can occur to this block.
-	// Thus we should notify surrounding chunks to recalculate if necessary.
-	// And ourself
-	if (!ghostInspect) {
-		flagNeighboursForRecalculateIfNecessary(x, y, z);
-	}
-
-	// Return the actual block that was requested;
-	return chunk->getBlock((int)blockPos.x, (int)blockPos.y, (int)blockPos.z);
-}
-
-
-// # TODO rename function
-void Game::flagNeighboursForRecalculateIfNecessary(int x,  int y, int z) {
-	vec3 blockPos = glm::vec3(x % Chunk::chunkSize, y % Chunk::chunkSize, z % Chunk::chunkSize);
-	vec3 chunkPos = glm::vec3((x - blockPos.x) / Chunk::chunkSize, (y - blockPos.y) / Chunk::chunkSize, (z - blockPos.z) / Chunk::chunkSize);
-
-	// Check if we need to update chunk left.
-	if (blockPos.x == 0) {
-		auto neighbour = getChunk(chunkPos.x - 1, chunkPos.y, chunkPos.z);
-
-		if (neighbour != nullptr) {
-			neighbour->flagRecalculateMesh();
-		}
-	}
-	// Check if we need to update chunk right.
-	else if (blockPos.x >= Chunk::chunkSize - 1) {
-		auto neighbour = getChunk(chunkPos.x + 1, chunkPos.y, chunkPos.z);
-
-		if (neighbour != nullptr) {
-			neighbour->flagRecalculateMesh();
-		}
-	}
-
-	// Check if we need to update chunk below.
-	if (blockPos.y == 0) {
-		auto neighbour = getChunk(chunkPos.x, chunkPos.y - 1, chunkPos.z);
-
-		if (neighbour != nullptr) {
-			neighbour->flagRecalculateMesh();
-		}
-	}
-	// Check if we need to update chunk above.
-	else if (blockPos.y >= Chunk::chunkSize - 1) {
-		auto neighbour = getChunk(chunkPos.x, chunkPos.y + 1, chunkPos.z);
-
-		if (neighbour != nullptr) {
-			neighbour->flagRecalculateMesh();
-		}
-	}
-
-
-	// Check if we need to update chunk in front.
-	if (blockPos.z == 0) {
-		auto neighbour = getChunk(chunkPos.x, chunkPos.y, chunkPos.z - 1);
-
-		if (neighbour != nullptr) {
-			neighbour->flagRecalculateMesh();
-		}
-	}
-	// Check if we need to update chunk in behind.
-	else if (blockPos.z >= Chunk::chunkSize - 1) {
-		auto neighbour = getChunk(chunkPos.x, chunkPos.y, chunkPos.z + 1);
-
-		if (neighbour != nullptr) {
-			neighbour->flagRecalculateMesh();
-		}
-	}
-
-	// We always need to update this chunk
-	auto chunk = getChunk(chunkPos.x, chunkPos.y, chunkPos.z);
-
-	if(chunk != nullptr)
-		chunk->flagRecalculateMesh();
-}
-
-
-std::shared_ptr<Chunk> Game::getChunk(int x, int y, int z) {
-	// If the chunk is not within bounds, return null pointer
-	if (x < 0 || y < 0 || z < 0 || x >= chunkArrayX || y >= chunkArrayY || z >= chunkArrayZ) {
-		return nullptr;
-	}
-
-	// Otherwise, we can just return the chunk requested
-	return chunkArray[x][y][z];
-}
-
 
 void Game::placeParticleSystem(glm::vec3 pos) {
 	particleSystem->emitting = true;
@@ -506,6 +789,11 @@ void Game::placeParticleSystem(glm::vec3 pos) {
 }
 
 
+void Game::onBlockRemoved(glm::vec3 position) {
+	placeParticleSystem(position);
+}
+
+
 void Game::updateApperance() {
 	particleSystem->updateAppearance = [&](const Particle& p) {
 		p.size = glm::mix(sizeFrom, sizeTo, p.normalizedAge);
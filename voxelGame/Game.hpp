@@ -6,53 +6,66 @@
 */
 #pragma once
 
+#include <unordered_map>
+#include <unordered_set>
 #include "sre/SDLRenderer.hpp"
 #include "sre/Material.hpp"
+#include "sre/TextureLoader.hpp"
 #include "FirstPersonController.hpp"
 #include "ParticleSystem.hpp"
 #include "Physics.hpp"
+#include "JobPool.hpp"
 #include "Chunk.hpp"
+#include "ChunkPool.hpp"
+#include "ChunkArena.hpp"
+#include "World.hpp"
+#include "WorldStorage.hpp"
+#include "BrickMap.hpp"
+#include "TerrainGenerator.hpp"
+#include "Frustum.hpp"
+#include "VoxelRaycast.hpp"
 #include "Block.hpp"
 
-class Game {
+class Game : public WorldListener {
 public:
     Game();
 	~Game();
 
 	static Game* getInstance(); 
 
-	// Pass in a world block location and it flags the chunk for recalculation.
-	// Furthermore, it flags neighbouring chunks to recalculate if the said block is on a chunk edge.
-	void flagNeighboursForRecalculateIfNecessary(int x, int y, int z);	
-
-	// Pass in a world position and the function returns a pointer to the block on that location.
-	// When ghostInspect is set to true no mesh recalculation flag will be raised. 
-	// Set it to false and chunks and possible neighbours will be recalculated when necessary.
-	Block* locationToBlock(int x, int y, int z, bool ghostInspect);
-
 	// Particle systemm
 	void placeParticleSystem(glm::vec3 pos);
+	void onBlockRemoved(glm::vec3 position) override;	// Bursts particles where a block was mined
 	void updateApperance();
 	void updateEmit();
 
 	std::shared_ptr<sre::Material> getBlockMaterial() { return blockMaterial; }					// Returns the material shared between all blocks
+	std::shared_ptr<sre::Material> getChunkMaterial() { return chunkMaterial; }					// Returns the material used to draw chunk meshes
 	std::shared_ptr<sre::Mesh> getBlockMesh(BlockType type) { return blockMeshes[(int)type]; }	// Returns a cube mesh for a block type
-	std::shared_ptr<Chunk> getChunk(int x, int y, int z);										// Returns a chunk at chunk coordinates x, y, z
 
 	Physics* getPhysics() { return &physics; }	// Returns the physics wrapper for the game
+	JobPool* getJobPool() { return &jobPool; }	// Returns the worker threads used for background work such as meshing
+	World* getWorld() { return &world; }		// Returns the loaded chunks and the block queries across them
 private:
     void init();
+	void fixedUpdate(float timeStep);	// Steps the player and physics, called at the fixed update rate of the renderer
     void update(float deltaTime);
     void render();
 	void onKey(SDL_Event& e);
 
-	void drawChunks(sre::RenderPass & renderPass);	// Loops through all chunks and tells them to draw
+	void drawChunks(sre::RenderPass & renderPass);	// Draws the chunks that have a mesh, can be seen from the camera and are inside the camera frustum
+	void findReachableChunks(glm::ivec3 start);		// Walks from chunk start through chunks that can be seen through, filling reachedChunks
 	void drawGUI();									// Draws the GUI
+	void drawWorldStats();							// Draws memory statistics of the world below the profiler
+	void drawFramePacing();							// Draws the simulation rate, frame rate limit and vsync settings below the profiler
 
-	void loadColliders(int xPos, int yPos, int zPos);	// Add colliders to the world of the chunk xPos, yPos, zPos and its neighbours. Unloads all others.
+	void streamChunks(glm::ivec3 center, int maxLoads);	// Unloads chunks beyond the view distance of center, and loads up to maxLoads missing chunks nearest first.
+	int getLod(glm::ivec3 offset);						// Level of detail for a chunk at offset chunks from the player
+	void loadChunk(glm::ivec3 position);				// Takes a chunk from the pool for chunk coordinates position, and loads or generates its blocks
+	void saveDirtyChunks();								// Queues all loaded chunks with changed blocks for writing
 
+	std::shared_ptr<sre::Shader> createChunkShader();			// Creates the shader for chunk meshes, which repeats a tile over merged faces
 	std::shared_ptr<sre::Mesh> createBlockMesh(BlockType type);	// Creates a block mesh for the blockType. These are used to display blocks in hand
-	glm::vec4 textureCoordinates(int textureId);				// Translates a texture index to UV coordinates
 
 	// Singleton pattern
 	static bool instanceFlag;
@@ -64,24 +77,58 @@ private:
     sre::SDLRenderer renderer;
     sre::Camera camera;
 	Physics physics;
+	JobPool jobPool;
+	World world{ &jobPool };
+	// Textures are decoded on the job pool and uploaded a slice per frame, they are white until then.
+	sre::TextureLoader textureLoader{ [this](std::function<void()> job) { jobPool.submit(job); } };
 
 	// Togglles for various debug modes
 	bool physicsDebugDraw = false;	// Whether we should allow the physics debug drawer to draw
 	bool debugProfiler = false;		// Whether we should show the profiler
 	bool mouseLock = true;			// Whether the mouse is locked in the window
 
-	// Array for all chunks, and how many chunks we have in each axis.
-	const int chunkArrayX = 16;
-	const int chunkArrayY = 2; 
-	const int chunkArrayZ = 16;
-	std::shared_ptr<Chunk>*** chunkArray;
+	// Chunks stream in and out of the world around the player, the world has no horizontal bounds.
+	ChunkPool chunkPool{ &world };
+	WorldStorage worldStorage{ "world" };	// Changed chunks are saved in region files in this directory
+	// Blocks of unloaded chunks within the resident distance, so walking back to them needs no disk or generator.
+	BrickMap residentChunks;
+
+	// Reused every frame to cull the chunks against the camera frustum
+	std::vector<Chunk*> drawableChunks;
+	FrustumBoxes drawableBounds;
+	std::vector<uint8_t> chunkVisibility;
+
+	// Reused every frame to find the chunks that can be seen from the camera through air, the others are hidden behind terrain.
+	struct CaveStep {
+		glm::ivec3 position;
+		int from;			// Side the chunk was entered through, -1 for the chunk of the camera
+		int directions;		// Directions taken to get here, the walk never turns back against any of them
+	};
+	std::vector<CaveStep> caveSteps;
+	std::unordered_set<glm::ivec3, ChunkPositionHash> reachedChunks;
+	bool caveCulling = true;
+	int caveCulledCount = 0;				// Chunks with a mesh that were hidden behind terrain last frame
+
+	int viewDistance = 8;					// How many chunks are loaded in each horizontal direction around the player
+	int lodDistance = 4;					// Chunks within this distance are meshed at full detail, every doubling of the distance halves the detail
+	int residentDistance = 64;				// How many chunks are kept in the brick map in each horizontal direction
+	const int worldHeight = 2;				// How many chunks are stacked vertically, starting at chunk y = 0
+	const int chunksLoadedPerFrame = 16;	// Spreads generating new chunks over multiple frames
+	glm::ivec3 streamCenter;				// Chunk the player was in when chunks were last streamed
+	bool streamingComplete = false;			// Whether all chunks within the view distance of streamCenter are loaded
+	const float autosaveInterval = 10;		// Seconds between saving changed chunks that are still loaded
+	float timeSinceAutosave = 0;
 
 	// List of all block meshes, these are used to be hold in hand by the player.
 	std::shared_ptr<sre::Mesh>* blockMeshes;
 
-	// Material used to draw blocks, used by both block meshes and chunk meshes
+	// Material used to draw the block meshes held in hand
 	std::shared_ptr<sre::Material> blockMaterial;
 
+	// Material used to draw chunk meshes, these store the tile origin in the UVs so faces can be merged
+	std::shared_ptr<sre::Material> chunkMaterial;
+	ChunkArena* chunkArena = nullptr;	// Holds the meshes of all chunks, created along with the chunk material
+
 	// Particles
 	std::shared_ptr<sre::Texture> particleTexture;
 	std::shared_ptr<ParticleSystem> particleSystem;
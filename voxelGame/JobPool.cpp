@@ -0,0 +1,122 @@
+#include "JobPool.hpp"
+#include <algorithm>
+#include "sre/ScopeProfiler.hpp"
+
+// The pool and queue index of the worker running on this thread, used to keep jobs submitted by a job on the same worker.
+static thread_local JobPool* currentPool = nullptr;
+static thread_local int currentWorker = -1;
+
+
+JobPool::JobPool(int threadCount)
+	: pendingJobs(0), queuedJobs(0), nextQueue(0), running(true) {
+	// Leave one core for the main thread, but always have at least one worker.
+	if (threadCount <= 0)
+		threadCount = std::max(1, (int)std::thread::hardware_concurrency() - 1);
+
+	for (int i = 0; i < threadCount; i++) {
+		queues.push_back(std::unique_ptr<WorkerQueue>(new WorkerQueue()));
+	}
+
+	// Only start the threads once all queues exist, since workers steal from each other right away.
+	for (int i = 0; i < threadCount; i++) {
+		threads.emplace_back(&JobPool::workerLoop, this, i);
+	}
+}
+
+
+JobPool::~JobPool() {
+	{
+		std::lock_guard<std::mutex> lock(sleepMutex);
+		running = false;
+	}
+	wakeUp.notify_all();
+
+	for (auto& thread : threads) {
+		thread.join();
+	}
+}
+
+
+void JobPool::submit(std::function<void()> job) {
+	// Workers keep their own jobs close, everything else is spread over the queues.
+	int index;
+	if (currentPool == this)
+		index = currentWorker;
+	else
+		index = nextQueue++ % queues.size();
+
+	pendingJobs++;
+	{
+		std::lock_guard<std::mutex> lock(queues[index]->mutex);
+		queues[index]->jobs.push_back(std::move(job));
+	}
+
+	// Count the job under the sleep lock, so a worker can not miss it between checking and going to sleep.
+	{
+		std::lock_guard<std::mutex> lock(sleepMutex);
+		queuedJobs++;
+	}
+	wakeUp.notify_one();
+}
+
+
+void JobPool::workerLoop(int index) {
+	currentPool = this;
+	currentWorker = index;
+	sre::ScopeProfiler::setThreadName("Job worker " + std::to_string(index));
+
+	std::function<void()> job;
+	while (true) {
+		if (takeJob(index, job)) {
+			job();
+			job = nullptr;
+			// Notify under the idle lock, so a waiter can not miss it between checking and going to sleep.
+			if (--pendingJobs == 0) {
+				std::lock_guard<std::mutex> lock(idleMutex);
+				idle.notify_all();
+			}
+			continue;
+		}
+
+		// Nothing to do, sleep until there are jobs again. When shutting down the queues are drained before leaving.
+		std::unique_lock<std::mutex> lock(sleepMutex);
+		if (!running && queuedJobs == 0)
+			return;
+		wakeUp.wait(lock, [&] { return !running || queuedJobs > 0; });
+	}
+}
+
+
+void JobPool::waitIdle() {
+	std::unique_lock<std::mutex> lock(idleMutex);
+	idle.wait(lock, [&] { return pendingJobs == 0; });
+}
+
+
+bool JobPool::takeJob(int index, std::function<void()>& job) {
+	// Newest job of our own queue first, its data is most likely still in the cache.
+	{
+		WorkerQueue& own = *queues[index];
+		std::lock_guard<std::mutex> lock(own.mutex);
+		if (!own.jobs.empty()) {
+			job = std::move(own.jobs.back());
+			own.jobs.pop_back();
+			queuedJobs--;
+			return true;
+		}
+	}
+
+	// Otherwise steal the oldest job of another worker.
+	for (size_t i = 1; i < queues.size(); i++) {
+		WorkerQueue& victim = *queues[(index + i) % queues.size()];
+		std::lock_guard<std::mutex> lock(victim.mutex);
+		if (!victim.jobs.empty()) {
+			job = std::move(victim.jobs.front());
+			victim.jobs.pop_front();
+			queuedJobs--;
+			return true;
+		}
+	}
+
+	return false;
+}
@@ -0,0 +1,54 @@
+/*
+* JobPool - Created: 16-10-2026
+* A pool of worker threads which run jobs in the background. Every worker has its own queue of jobs,
+* a worker that runs out of jobs steals from the front of the queues of the other workers so the load stays balanced.
+* Jobs may not touch the GL context, anything that needs it has to be handed back to the main thread.
+*/
+#pragma once
+
+#include <atomic>
+#include <condition_variable>
+#include <deque>
+#include <functional>
+#include <memory>
+#include <mutex>
+#include <thread>
+#include <vector>
+
+
+
+class JobPool {
+public:
+	explicit JobPool(int threadCount = 0);	// Starts threadCount workers, 0 uses one worker per core minus the main thread.
+	~JobPool();								// Finishes the queued jobs and joins all workers.
+
+	void submit(std::function<void()> job);	// Queues a job, from a worker it goes on its own queue, otherwise the queues are filled round robin.
+
+	int getThreadCount() { return (int)threads.size(); }
+	int getPendingJobCount() { return pendingJobs; }	// Jobs that are queued or running
+	void waitIdle();							// Blocks until all jobs, including the ones they submit, have finished.
+private:
+	struct WorkerQueue {
+		std::mutex mutex;
+		std::deque<std::function<void()>> jobs;
+	};
+
+	void workerLoop(int index);
+	bool takeJob(int index, std::function<void()>& job);	// Pops from the back of the own queue, or steals from the front of another.
+
+	std::vector<std::unique_ptr<WorkerQueue>> queues;
+	std::vector<std::thread> threads;
+
+	// Idle workers sleep until a job is submitted
+	std::mutex sleepMutex;
+	std::condition_variable wakeUp;
+
+	// Threads in waitIdle sleep until the last pending job has finished
+	std::mutex idleMutex;
+	std::condition_variable idle;
+
+	std::atomic<int> pendingJobs;
+	std::atomic<int> queuedJobs;		// Jobs that sit in a queue and have not been taken by a worker yet
+	std::atomic<unsigned int> nextQueue;
+	std::atomic<bool> running;
+};
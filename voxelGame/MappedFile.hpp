@@ -0,0 +1,35 @@
+/*
+* MappedFile - Created: 16-10-2026
+* Maps a file read only into memory, so reading from it is a pointer lookup and the OS takes care of caching.
+* A file that grows after mapping can be mapped again to see the new bytes.
+*/
+#pragma once
+
+#include <cstddef>
+#include <cstdint>
+#include <string>
+
+
+
+class MappedFile {
+public:
+	MappedFile();
+	~MappedFile();
+
+	MappedFile(const MappedFile&) = delete;
+	MappedFile& operator=(const MappedFile&) = delete;
+
+	bool open(const std::string& path);		// Maps the whole file, replacing the previous mapping. Returns false when the file can not be mapped.
+	void close();							// Unmaps the file, data() is null afterwards.
+
+	const uint8_t* data() { return bytes; }
+	size_t size() { return length; }
+private:
+	const uint8_t* bytes = nullptr;
+	size_t length = 0;
+
+#ifdef _WIN32
+	void* fileHandle = nullptr;
+	void* mappingHandle = nullptr;
+#endif
+};
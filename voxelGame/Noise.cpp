@@ -0,0 +1,299 @@
+#include "Noise.hpp"
+#include <cmath>
+
+#if defined(__AVX2__)
+#include <immintrin.h>
+#define NOISE_AVX2
+#elif defined(__SSE2__) || defined(_M_X64) || (defined(_M_IX86_FP) && _M_IX86_FP >= 2)
+#include <emmintrin.h>
+#define NOISE_SSE2
+#endif
+
+
+// Large odd constants that spread the lattice coordinates over all bits of the hash.
+static const uint32_t primeX = 501125321u;
+static const uint32_t primeY = 1136930381u;
+static const uint32_t primeZ = 1720413743u;
+static const uint32_t hashMultiplier = 0x27d4eb2du;
+
+
+static inline uint32_t hashLattice(uint32_t seed, int x, int y, int z) {
+	uint32_t hash = seed ^ ((uint32_t)x * primeX) ^ ((uint32_t)y * primeY) ^ ((uint32_t)z * primeZ);
+	hash *= hashMultiplier;
+	return hash ^ (hash >> 15);
+}
+
+
+// Picks one of the twelve cube edge gradients (plus four repeats) with the low bits of the hash and dots it with the offset.
+static inline float gradient(uint32_t hash, float x, float y, float z) {
+	int h = (int)(hash & 15);
+	float u = h < 8 ? x : y;
+	float v = h < 4 ? y : (h == 12 || h == 14 ? x : z);
+	return ((h & 1) ? -u : u) + ((h & 2) ? -v : v);
+}
+
+
+// Smooth step with zero first and second derivative at the ends, so the noise has no visible creases along the lattice.
+static inline float fade(float t) {
+	return t * t * t * (t * (t * 6.0f - 15.0f) + 10.0f);
+}
+
+
+static inline float lerp(float a, float b, float t) {
+	return a + t * (b - a);
+}
+
+
+Noise::Noise(uint32_t seed)
+	: seed(seed) {
+}
+
+
+float Noise::sample(float x, float y, float z) const {
+	float floorX = std::floor(x);
+	float floorY = std::floor(y);
+	float floorZ = std::floor(z);
+	int ix = (int)floorX;
+	int iy = (int)floorY;
+	int iz = (int)floorZ;
+	float fx = x - floorX;
+	float fy = y - floorY;
+	float fz = z - floorZ;
+	float u = fade(fx);
+	float v = fade(fy);
+	float w = fade(fz);
+
+	// Dot the gradients of the eight surrounding lattice points with the offset to them, and blend the results.
+	float g000 = gradient(hashLattice(seed, ix, iy, iz), fx, fy, fz);
+	float g100 = gradient(hashLattice(seed, ix + 1, iy, iz), fx - 1.0f, fy, fz);
+	float g010 = gradient(hashLattice(seed, ix, iy + 1, iz), fx, fy - 1.0f, fz);
+	float g110 = gradient(hashLattice(seed, ix + 1, iy + 1, iz), fx - 1.0f, fy - 1.0f, fz);
+	float g001 = gradient(hashLattice(seed, ix, iy, iz + 1), fx, fy, fz - 1.0f);
+	float g101 = gradient(hashLattice(seed, ix + 1, iy, iz + 1), fx - 1.0f, fy, fz - 1.0f);
+	float g011 = gradient(hashLattice(seed, ix, iy + 1, iz + 1), fx, fy - 1.0f, fz - 1.0f);
+	float g111 = gradient(hashLattice(seed, ix + 1, iy + 1, iz + 1), fx - 1.0f, fy - 1.0f, fz - 1.0f);
+
+	float x00 = lerp(g000, g100, u);
+	float x10 = lerp(g010, g110, u);
+	float x01 = lerp(g001, g101, u);
+	float x11 = lerp(g011, g111, u);
+	float y0 = lerp(x00, x10, v);
+	float y1 = lerp(x01, x11, v);
+	return lerp(y0, y1, w);
+}
+
+
+#if defined(NOISE_AVX2)
+// Eight points at a time, see Noise::sample for the scalar version of every step.
+static inline __m256i hashLattice8(__m256i seed, __m256i x, __m256i y, __m256i z) {
+	__m256i hash = _mm256_xor_si256(seed, _mm256_mullo_epi32(x, _mm256_set1_epi32((int)primeX)));
+	hash = _mm256_xor_si256(hash, _mm256_mullo_epi32(y, _mm256_set1_epi32((int)primeY)));
+	hash = _mm256_xor_si256(hash, _mm256_mullo_epi32(z, _mm256_set1_epi32((int)primeZ)));
+	hash = _mm256_mullo_epi32(hash, _mm256_set1_epi32((int)hashMultiplier));
+	return _mm256_xor_si256(hash, _mm256_srli_epi32(hash, 15));
+}
+
+
+static inline __m256 gradient8(__m256i hash, __m256 x, __m256 y, __m256 z) {
+	__m256i h = _mm256_and_si256(hash, _mm256_set1_epi32(15));
+	__m256 below8 = _mm256_castsi256_ps(_mm256_cmpgt_epi32(_mm256_set1_epi32(8), h));
+	__m256 below4 = _mm256_castsi256_ps(_mm256_cmpgt_epi32(_mm256_set1_epi32(4), h));
+	__m256 is12or14 = _mm256_castsi256_ps(_mm256_or_si256(_mm256_cmpeq_epi32(h, _mm256_set1_epi32(12)), _mm256_cmpeq_epi32(h, _mm256_set1_epi32(14))));
+
+	__m256 u = _mm256_blendv_ps(y, x, below8);
+	__m256 v = _mm256_blendv_ps(_mm256_blendv_ps(z, x, is12or14), y, below4);
+
+	// Flip the sign bits with bit 0 and bit 1 of the hash.
+	__m256 signU = _mm256_castsi256_ps(_mm256_slli_epi32(h, 31));
+	__m256 signV = _mm256_castsi256_ps(_mm256_slli_epi32(_mm256_srli_epi32(h, 1), 31));
+	return _mm256_add_ps(_mm256_xor_ps(u, signU), _mm256_xor_ps(v, signV));
+}
+
+
+static inline __m256 fade8(__m256 t) {
+	__m256 inner = _mm256_add_ps(_mm256_mul_ps(t, _mm256_sub_ps(_mm256_mul_ps(t, _mm256_set1_ps(6.0f)), _mm256_set1_ps(15.0f))), _mm256_set1_ps(10.0f));
+	return _mm256_mul_ps(_mm256_mul_ps(_mm256_mul_ps(t, t), t), inner);
+}
+
+
+static inline __m256 lerp8(__m256 a, __m256 b, __m256 t) {
+	return _mm256_add_ps(a, _mm256_mul_ps(t, _mm256_sub_ps(b, a)));
+}
+
+
+static void sample8(uint32_t seedValue, const float* px, const float* py, const float* pz, float* out) {
+	__m256 x = _mm256_loadu_ps(px);
+	__m256 y = _mm256_loadu_ps(py);
+	__m256 z = _mm256_loadu_ps(pz);
+	__m256 floorX = _mm256_floor_ps(x);
+	__m256 floorY = _mm256_floor_ps(y);
+	__m256 floorZ = _mm256_floor_ps(z);
+	__m256i ix = _mm256_cvttps_epi32(floorX);
+	__m256i iy = _mm256_cvttps_epi32(floorY);
+	__m256i iz = _mm256_cvttps_epi32(floorZ);
+	__m256 fx = _mm256_sub_ps(x, floorX);
+	__m256 fy = _mm256_sub_ps(y, floorY);
+	__m256 fz = _mm256_sub_ps(z, floorZ);
+	__m256 u = fade8(fx);
+	__m256 v = fade8(fy);
+	__m256 w = fade8(fz);
+
+	__m256i seed = _mm256_set1_epi32((int)seedValue);
+	__m256i one = _mm256_set1_epi32(1);
+	__m256i ix1 = _mm256_add_epi32(ix, one);
+	__m256i iy1 = _mm256_add_epi32(iy, one);
+	__m256i iz1 = _mm256_add_epi32(iz, one);
+	__m256 fx1 = _mm256_sub_ps(fx, _mm256_set1_ps(1.0f));
+	__m256 fy1 = _mm256_sub_ps(fy, _mm256_set1_ps(1.0f));
+	__m256 fz1 = _mm256_sub_ps(fz, _mm256_set1_ps(1.0f));
+
+	__m256 g000 = gradient8(hashLattice8(seed, ix, iy, iz), fx, fy, fz);
+	__m256 g100 = gradient8(hashLattice8(seed, ix1, iy, iz), fx1, fy, fz);
+	__m256 g010 = gradient8(hashLattice8(seed, ix, iy1, iz), fx, fy1, fz);
+	__m256 g110 = gradient8(hashLattice8(seed, ix1, iy1, iz), fx1, fy1, fz);
+	__m256 g001 = gradient8(hashLattice8(seed, ix, iy, iz1), fx, fy, fz1);
+	__m256 g101 = gradient8(hashLattice8(seed, ix1, iy, iz1), fx1, fy, fz1);
+	__m256 g011 = gradient8(hashLattice8(seed, ix, iy1, iz1), fx, fy1, fz1);
+	__m256 g111 = gradient8(hashLattice8(seed, ix1, iy1, iz1), fx1, fy1, fz1);
+
+	__m256 x00 = lerp8(g000, g100, u);
+	__m256 x10 = lerp8(g010, g110, u);
+	__m256 x01 = lerp8(g001, g101, u);
+	__m256 x11 = lerp8(g011, g111, u);
+	__m256 y0 = lerp8(x00, x10, v);
+	__m256 y1 = lerp8(x01, x11, v);
+	_mm256_storeu_ps(out, lerp8(y0, y1, w));
+}
+#elif defined(NOISE_SSE2)
+// Four points at a time, see Noise::sample for the scalar version of every step.
+// SSE2 has no 32 bit multiply, so it is built from two 64 bit multiplies of the even and odd lanes.
+static inline __m128i multiply4(__m128i a, __m128i b) {
+	__m128i even = _mm_mul_epu32(a, b);
+	__m128i odd = _mm_mul_epu32(_mm_srli_epi64(a, 32), _mm_srli_epi64(b, 32));
+	return _mm_unpacklo_epi32(_mm_shuffle_epi32(even, _MM_SHUFFLE(0, 0, 2, 0)), _mm_shuffle_epi32(odd, _MM_SHUFFLE(0, 0, 2, 0)));
+}
+
+
+static inline __m128i hashLattice4(__m128i seed, __m128i x, __m128i y, __m128i z) {
+	__m128i hash = _mm_xor_si128(seed, multiply4(x, _mm_set1_epi32((int)primeX)));
+	hash = _mm_xor_si128(hash, multiply4(y, _mm_set1_epi32((int)primeY)));
+	hash = _mm_xor_si128(hash, multiply4(z, _mm_set1_epi32((int)primeZ)));
+	hash = multiply4(hash, _mm_set1_epi32((int)hashMultiplier));
+	return _mm_xor_si128(hash, _mm_srli_epi32(hash, 15));
+}
+
+
+// Picks a where the mask is set and b elsewhere.
+static inline __m128 select4(__m128 mask, __m128 a, __m128 b) {
+	return _mm_or_ps(_mm_and_ps(mask, a), _mm_andnot_ps(mask, b));
+}
+
+
+static inline __m128 gradient4(__m128i hash, __m128 x, __m128 y, __m128 z) {
+	__m128i h = _mm_and_si128(hash, _mm_set1_epi32(15));
+	__m128 below8 = _mm_castsi128_ps(_mm_cmplt_epi32(h, _mm_set1_epi32(8)));
+	__m128 below4 = _mm_castsi128_ps(_mm_cmplt_epi32(h, _mm_set1_epi32(4)));
+	__m128 is12or14 = _mm_castsi128_ps(_mm_or_si128(_mm_cmpeq_epi32(h, _mm_set1_epi32(12)), _mm_cmpeq_epi32(h, _mm_set1_epi32(14))));
+
+	__m128 u = select4(below8, x, y);
+	__m128 v = select4(below4, y, select4(is12or14, x, z));
+
+	// Flip the sign bits with bit 0 and bit 1 of the hash.
+	__m128 signU = _mm_castsi128_ps(_mm_slli_epi32(h, 31));
+	__m128 signV = _mm_castsi128_ps(_mm_slli_epi32(_mm_srli_epi32(h, 1), 31));
+	return _mm_add_ps(_mm_xor_ps(u, signU), _mm_xor_ps(v, signV));
+}
+
+
+static inline __m128 fade4(__m128 t) {
+	__m128 inner = _mm_add_ps(_mm_mul_ps(t, _mm_sub_ps(_mm_mul_ps(t, _mm_set1_ps(6.0f)), _mm_set1_ps(15.0f))), _mm_set1_ps(10.0f));
+	return _mm_mul_ps(_mm_mul_ps(_mm_mul_ps(t, t), t), inner);
+}
+
+
+static inline __m128 lerp4(__m128 a, __m128 b, __m128 t) {
+	return _mm_add_ps(a, _mm_mul_ps(t, _mm_sub_ps(b, a)));
+}
+
+
+// SSE2 has no floor, truncate and step down where truncating rounded up.
+static inline __m128 floor4(__m128 value) {
+	__m128 truncated = _mm_cvtepi32_ps(_mm_cvttps_epi32(value));
+	return _mm_sub_ps(truncated, _mm_and_ps(_mm_cmpgt_ps(truncated, value), _mm_set1_ps(1.0f)));
+}
+
+
+static void sample4(uint32_t seedValue, const float* px, const float* py, const float* pz, float* out) {
+	__m128 x = _mm_loadu_ps(px);
+	__m128 y = _mm_loadu_ps(py);
+	__m128 z = _mm_loadu_ps(pz);
+	__m128 floorX = floor4(x);
+	__m128 floorY = floor4(y);
+	__m128 floorZ = floor4(z);
+	__m128i ix = _mm_cvttps_epi32(floorX);
+	__m128i iy = _mm_cvttps_epi32(floorY);
+	__m128i iz = _mm_cvttps_epi32(floorZ);
+	__m128 fx = _mm_sub_ps(x, floorX);
+	__m128 fy = _mm_sub_ps(y, floorY);
+	__m128 fz = _mm_sub_ps(z, floorZ);
+	__m128 u = fade4(fx);
+	__m128 v = fade4(fy);
+	__m128 w = fade4(fz);
+
+	__m128i seed = _mm_set1_epi32((int)seedValue);
+	__m128i one = _mm_set1_epi32(1);
+	__m128i ix1 = _mm_add_epi32(ix, one);
+	__m128i iy1 = _mm_add_epi32(iy, one);
+	__m128i iz1 = _mm_add_epi32(iz, one);
+	__m128 fx1 = _mm_sub_ps(fx, _mm_set1_ps(1.0f));
+	__m128 fy1 = _mm_sub_ps(fy, _mm_set1_ps(1.0f));
+	__m128 fz1 = _mm_sub_ps(fz, _mm_set1_ps(1.0f));
+
+	__m128 g000 = gradient4(hashLattice4(seed, ix, iy, iz), fx, fy, fz);
+	__m128 g100 = gradient4(hashLattice4(seed, ix1, iy, iz), fx1, fy, fz);
+	__m128 g010 = gradient4(hashLattice4(seed, ix, iy1, iz), fx, fy1, fz);
+	__m128 g110 = gradient4(hashLattice4(seed, ix1, iy1, iz), fx1, fy1, fz);
+	__m128 g001 = gradient4(hashLattice4(seed, ix, iy, iz1), fx, fy, fz1);
+	__m128 g101 = gradient4(hashLattice4(seed, ix1, iy, iz1), fx1, fy, fz1);
+	__m128 g011 = gradient4(hashLattice4(seed, ix, iy1, iz1), fx, fy1, fz1);
+	__m128 g111 = gradient4(hashLattice4(seed, ix1, iy1, iz1), fx1, fy1, fz1);
+
+	__m128 x00 = lerp4(g000, g100, u);
+	__m128 x10 = lerp4(g010, g110, u);
+	__m128 x01 = lerp4(g001, g101, u);
+	__m128 x11 = lerp4(g011, g111, u);
+	__m128 y0 = lerp4(x00, x10, v);
+	__m128 y1 = lerp4(x01, x11, v);
+	_mm_storeu_ps(out, lerp4(y0, y1, w));
+}
+#endif
+
+
+void Noise::sample(const float* x, const float* y, const float* z, int count, float* out) const {
+	int i = 0;
+#if defined(NOISE_AVX2)
+	for (; i + 8 <= count; i += 8) {
+		sample8(seed, x + i, y + i, z + i, out + i);
+	}
+#elif defined(NOISE_SSE2)
+	for (; i + 4 <= count; i += 4) {
+		sample4(seed, x + i, y + i, z + i, out + i);
+	}
+#endif
+
+	// Whatever does not fill a whole vector.
+	for (; i < count; i++) {
+		out[i] = sample(x[i], y[i], z[i]);
+	}
+}
+
+
+const char* Noise::getInstructionSet() {
+#if defined(NOISE_AVX2)
+	return "AVX2";
+#elif defined(NOISE_SSE2)
+	return "SSE2";
+#else
+	return "Scalar";
+#endif
+}
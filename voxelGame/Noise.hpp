@@ -0,0 +1,26 @@
+/*
+* Noise - Created: 16-10-2026
+* Seeded 3D gradient noise. The same seed always gives the same values, on every thread and in every run.
+* Points are sampled in batches, which run four (SSE2) or eight (AVX2) points at a time when the compiler targets those.
+* The vector kernels compute exactly the same steps as the scalar code, so all paths give bit identical results.
+*/
+#pragma once
+
+#include <cstdint>
+
+
+
+class Noise {
+public:
+	explicit Noise(uint32_t seed);
+
+	// Noise at a single point, roughly in the range -1 to 1. It is 0 on every integer lattice point.
+	float sample(float x, float y, float z) const;
+
+	// Samples count points given by the coordinate arrays into out.
+	void sample(const float* x, const float* y, const float* z, int count, float* out) const;
+
+	static const char* getInstructionSet();		// Name of the vector instructions the batch kernel was compiled for
+private:
+	uint32_t seed;
+};
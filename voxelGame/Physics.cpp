@@ -1,4 +1,5 @@
 #include "Physics.hpp"
+#include "sre/ScopeProfiler.hpp"
 
 
 
@@ -31,8 +32,11 @@ void Physics::init() {
 }
 
 
-void Physics::update() {
-	dynamicsWorld->stepSimulation(1 / 60.f, 10);
+void Physics::update(float timeStep) {
+	SRE_PROFILE_SCOPE("Physics::update");
+
+	// The renderer calls this at a fixed rate, so Bullet does not need to substep or interpolate on its own.
+	dynamicsWorld->stepSimulation(timeStep, 0);
 }
 
 
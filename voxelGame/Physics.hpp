@@ -6,20 +6,21 @@
 
 #include <btBulletDynamicsCommon.h>
 #include "btDebugDrawer.hpp"
+#include "World.hpp"
 
 
 
-class Physics {
+class Physics : public WorldPhysics {
 public:
 	Physics();
 	~Physics();
 
 	void init();
 	void drawDebug(sre::RenderPass* renderPass);
-	void update();
+	void update(float timeStep);	// Advances the simulation by exactly timeStep, called at the fixed update rate.
 
-	void addRigidBody(btRigidBody* rigidbody);		// Adds the rigidbody to the physics world.
-	void removeRigidBody(btRigidBody* rigidbody);	// Removes the rigidbody form the physics world.
+	void addRigidBody(btRigidBody* rigidbody) override;		// Adds the rigidbody to the physics world.
+	void removeRigidBody(btRigidBody* rigidbody) override;	// Removes the rigidbody form the physics world.
 
 	void setDebugDrawMode(btIDebugDraw::DebugDrawModes mode);	// Set the debug mode, so you can debug draw colliders.
 
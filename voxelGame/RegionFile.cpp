@@ -0,0 +1,194 @@
+#include "RegionFile.hpp"
+#include <algorithm>
+#include <cstring>
+#include <iostream>
+
+
+// Entries are stored as two little endian 32 bit values.
+static void writeUint32(uint8_t* bytes, uint32_t value) {
+	for (int i = 0; i < 4; i++) {
+		bytes[i] = (uint8_t)(value >> (i * 8));
+	}
+}
+
+
+static uint32_t readUint32(const uint8_t* bytes) {
+	return bytes[0] | (bytes[1] << 8) | (bytes[2] << 16) | ((uint32_t)bytes[3] << 24);
+}
+
+
+RegionFile::RegionFile(const std::string& path, bool create)
+	: path(path), entries(slotCount, Entry{ 0, 0 }) {
+	file = fopen(path.c_str(), "r+b");
+
+	// Read the offset table through the mapping. Entries pointing outside the file are skipped, a chunk write may have been cut off.
+	if (file != nullptr && mapped.open(path) && mapped.size() >= (size_t)headerSize && readUint32(mapped.data()) == magic && readUint32(mapped.data() + 4) == version) {
+		for (int slot = 0; slot < slotCount; slot++) {
+			const uint8_t* entry = mapped.data() + 8 + slot * sizeof(Entry);
+			uint32_t offset = readUint32(entry);
+			uint32_t size = readUint32(entry + 4);
+
+			if (offset >= (uint32_t)headerSize && (size_t)offset + size <= mapped.size())
+				entries[slot] = Entry{ offset, size };
+		}
+
+		fseek(file, 0, SEEK_END);
+		fileEnd = (uint32_t)ftell(file);
+
+		// The gaps between the chunks are left by chunks that were written again, they can be reused.
+		std::vector<Entry> used;
+		for (auto& entry : entries) {
+			if (entry.offset != 0)
+				used.push_back(entry);
+		}
+		std::sort(used.begin(), used.end(), [](const Entry& a, const Entry& b) { return a.offset < b.offset; });
+		uint32_t position = (uint32_t)headerSize;
+		for (auto& entry : used) {
+			if (entry.offset > position)
+				freeSpace[position] = entry.offset - position;
+			position = std::max(position, entry.offset + entry.size);
+		}
+		if (position < fileEnd)
+			releaseSpace(position, fileEnd - position);
+		return;
+	}
+
+	// A file with a layout we do not know may come from another version, or its header write was cut off.
+	// Readers leave it alone, the writer moves it aside before starting over, so its chunks can still be recovered.
+	// Empty files hold nothing, those are simply started over.
+	bool unknownLayout = false;
+	if (file != nullptr) {
+		fseek(file, 0, SEEK_END);
+		unknownLayout = ftell(file) > 0;
+		fclose(file);
+		file = nullptr;
+	}
+	mapped.close();
+	if (!create)
+		return;
+
+	if (unknownLayout) {
+		std::string backupPath = path + ".bak";
+		std::remove(backupPath.c_str());
+		if (std::rename(path.c_str(), backupPath.c_str()) != 0) {
+			std::cerr << "Could not move region file " << path << " with an unknown layout aside" << std::endl;
+			return;
+		}
+		std::cerr << "Region file " << path << " has an unknown layout, it was moved to " << backupPath << std::endl;
+	}
+
+	// New regions start with an empty offset table.
+	file = fopen(path.c_str(), "w+b");
+	if (file == nullptr) {
+		std::cerr << "Could not open region file " << path << std::endl;
+		return;
+	}
+
+	std::vector<uint8_t> header(headerSize, 0);
+	writeUint32(&header[0], magic);
+	writeUint32(&header[4], version);
+	fwrite(header.data(), 1, header.size(), file);
+	fflush(file);
+	fileEnd = (uint32_t)headerSize;
+}
+
+
+RegionFile::~RegionFile() {
+	if (file != nullptr)
+		fclose(file);
+}
+
+
+bool RegionFile::read(glm::ivec3 local, std::vector<uint8_t>& payload) {
+	std::lock_guard<std::mutex> lock(mutex);
+
+	Entry entry = entries[toSlot(local)];
+	if (entry.offset == 0)
+		return false;
+
+	// The chunk was appended after the file was mapped, map it again to see the new end of the file.
+	if ((size_t)entry.offset + entry.size > mapped.size()) {
+		if (!mapped.open(path) || (size_t)entry.offset + entry.size > mapped.size())
+			return false;
+	}
+
+	payload.assign(mapped.data() + entry.offset, mapped.data() + entry.offset + entry.size);
+	return true;
+}
+
+
+bool RegionFile::write(glm::ivec3 local, const std::vector<uint8_t>& payload) {
+	if (file == nullptr || payload.empty())
+		return false;
+
+	// Take the first free space the chunk fits in, otherwise append it.
+	uint32_t size = (uint32_t)payload.size();
+	auto space = freeSpace.begin();
+	while (space != freeSpace.end() && space->second < size)
+		++space;
+	uint32_t offset = space != freeSpace.end() ? space->first : fileEnd;
+
+	// Write the chunk first, and only point the header at it once the bytes are on disk.
+	// When the game exits halfway the old entry stays valid, its bytes are not reused until the header points elsewhere.
+	fseek(file, offset, SEEK_SET);
+	if (fwrite(payload.data(), 1, payload.size(), file) != payload.size()) {
+		std::cerr << "Could not write chunk to region file " << path << std::endl;
+		return false;
+	}
+	if (space != freeSpace.end()) {
+		uint32_t remaining = space->second - size;
+		freeSpace.erase(space);
+		if (remaining > 0)
+			freeSpace[offset + size] = remaining;
+	}
+	else {
+		fileEnd += size;
+	}
+
+	int slot = toSlot(local);
+	uint8_t entryBytes[sizeof(Entry)];
+	writeUint32(entryBytes, offset);
+	writeUint32(entryBytes + 4, (uint32_t)payload.size());
+	fseek(file, 8 + slot * sizeof(Entry), SEEK_SET);
+	fwrite(entryBytes, 1, sizeof(entryBytes), file);
+	fflush(file);
+
+	// Readers copy under the lock, so once the entry is swapped nobody reads the old bytes anymore.
+	Entry old;
+	{
+		std::lock_guard<std::mutex> lock(mutex);
+		old = entries[slot];
+		entries[slot] = Entry{ offset, size };
+	}
+	if (old.offset != 0)
+		releaseSpace(old.offset, old.size);
+	return true;
+}
+
+
+void RegionFile::releaseSpace(uint32_t offset, uint32_t size) {
+	if (size == 0)
+		return;
+
+	// Merge with the free space right after and right before.
+	auto next = freeSpace.find(offset + size);
+	if (next != freeSpace.end()) {
+		size += next->second;
+		freeSpace.erase(next);
+	}
+	auto previous = freeSpace.lower_bound(offset);
+	if (previous != freeSpace.begin()) {
+		--previous;
+		if (previous->first + previous->second == offset) {
+			offset = previous->first;
+			size += previous->second;
+			freeSpace.erase(previous);
+		}
+	}
+
+	// Free space at the end is where the next chunk is appended anyway.
+	if (offset + size == fileEnd)
+		fileEnd = offset;
+	else
+		freeSpace[offset] = size;
+}
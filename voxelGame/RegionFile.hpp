@@ -0,0 +1,69 @@
+/*
+* RegionFile - Created: 16-10-2026
+* A file on disk holding the blocks of 32x32 chunk columns. The file starts with a header that has an offset table entry
+* for every chunk slot, followed by the serialized chunks. A rewritten chunk goes to free space and its entry is pointed at the new bytes,
+* so writing never moves data a reader might be looking at. The bytes it replaced become free space for later writes, so the file
+* does not grow when the same chunks are saved again and again. Reads go through a memory mapping of the file.
+*/
+#pragma once
+
+#include <cstdint>
+#include <cstdio>
+#include <map>
+#include <mutex>
+#include <string>
+#include <vector>
+#include <glm/glm.hpp>
+#include "MappedFile.hpp"
+
+
+
+class RegionFile {
+public:
+	const static int regionSize = 32;		// Chunk columns along x and z
+	const static int regionHeight = 8;		// Chunks per column, chunk y from 0 up to regionHeight
+	const static int slotCount = regionSize * regionSize * regionHeight;
+
+	// Opens the region file. When create is set a missing file is created empty, otherwise isOpen() is false afterwards.
+	// A file with an unknown layout is never overwritten: without create it is not opened, with create it is moved to path.bak first.
+	RegionFile(const std::string& path, bool create);
+	~RegionFile();
+
+	bool isOpen() { return file != nullptr; }
+
+	// Copies the stored bytes of the chunk at local coordinates into payload. Returns false when the chunk was never written.
+	// Safe to call while another thread writes.
+	bool read(glm::ivec3 local, std::vector<uint8_t>& payload);
+
+	// Stores the bytes of the chunk at local coordinates in free space, or at the end of the file, and points its header entry at them.
+	// Only one thread may write at a time.
+	bool write(glm::ivec3 local, const std::vector<uint8_t>& payload);
+
+	// Whether local coordinates have a slot in a region.
+	static bool isInRegion(glm::ivec3 local) {
+		return local.x >= 0 && local.x < regionSize && local.z >= 0 && local.z < regionSize && local.y >= 0 && local.y < regionHeight;
+	}
+private:
+	struct Entry {
+		uint32_t offset;	// Byte offset of the chunk in the file, 0 when the chunk was never written
+		uint32_t size;
+	};
+
+	const static uint32_t magic = 0x47525856;	// "VXRG"
+	const static uint32_t version = 1;
+	const static int headerSize = 8 + slotCount * sizeof(Entry);
+
+	static int toSlot(glm::ivec3 local) { return local.x + regionSize * (local.z + regionSize * local.y); }
+
+	void releaseSpace(uint32_t offset, uint32_t size);	// Marks bytes no entry points at anymore as free
+
+	std::string path;
+	FILE* file = nullptr;		// Used by the writer only
+	uint32_t fileEnd = 0;		// Where the next chunk is appended
+	std::map<uint32_t, uint32_t> freeSpace;	// Unused bytes before fileEnd by offset, with their size. Used by the writer only.
+
+	// The offset table is shared between the reading and the writing thread.
+	std::mutex mutex;
+	std::vector<Entry> entries;
+	MappedFile mapped;
+};
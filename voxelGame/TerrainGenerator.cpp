@@ -0,0 +1,142 @@
+#include "TerrainGenerator.hpp"
+#include <algorithm>
+#include <climits>
+#include <cmath>
+
+
+// Scale of the noise fields in blocks, smaller values give larger features.
+static const float hillFrequency = 0.025f;
+static const float detailFrequency = 0.09f;
+static const float caveFrequency = 0.07f;
+static const float oreFrequency = 0.21f;
+
+// A block is in a cave where both cave fields are close to zero, the crossing of the two zero surfaces forms winding tunnels.
+static const float caveWidth = 0.09f;
+
+
+// Gives every noise field its own seed, so the fields do not line up with each other.
+static uint32_t deriveSeed(uint32_t seed, uint32_t field) {
+	uint32_t hash = seed + field * 0x9e3779b9u;
+	hash ^= hash >> 16;
+	hash *= 0x85ebca6bu;
+	return hash ^ (hash >> 13);
+}
+
+
+NoiseTerrainGenerator::NoiseTerrainGenerator(uint32_t seed)
+	: heightNoise(deriveSeed(seed, 1)), caveNoiseA(deriveSeed(seed, 2)), caveNoiseB(deriveSeed(seed, 3)), oreNoise(deriveSeed(seed, 4)) {
+}
+
+
+int NoiseTerrainGenerator::toSurfaceHeight(float coarse, float detail) {
+	return baseHeight + (int)std::floor(heightVariation * (coarse + 0.3f * detail));
+}
+
+
+int NoiseTerrainGenerator::getSurfaceHeight(int x, int z) const {
+	float coarse = heightNoise.sample(x * hillFrequency, 0.5f, z * hillFrequency);
+	float detail = heightNoise.sample(x * detailFrequency, 10.5f, z * detailFrequency);
+	return toSurfaceHeight(coarse, detail);
+}
+
+
+void NoiseTerrainGenerator::generate(glm::ivec3 chunkPosition, BlockId* ids) const {
+	const int size = Chunk::chunkSize;
+	const int columnCount = size * size;
+	glm::ivec3 origin = chunkPosition * size;
+
+	// There is nothing below the bedrock.
+	if (chunkPosition.y < 0) {
+		std::fill(ids, ids + Chunk::blockCount, AIR_BLOCK_ID);
+		return;
+	}
+
+	// Surface height of every column, both octaves sampled in one batch. The column index is x + z * size.
+	float xs[Chunk::blockCount];
+	float ys[Chunk::blockCount];
+	float zs[Chunk::blockCount];
+	float heightSamples[columnCount * 2];
+	for (int z = 0; z < size; z++) {
+		for (int x = 0; x < size; x++) {
+			int column = x + z * size;
+			xs[column] = (origin.x + x) * hillFrequency;
+			ys[column] = 0.5f;
+			zs[column] = (origin.z + z) * hillFrequency;
+			xs[columnCount + column] = (origin.x + x) * detailFrequency;
+			ys[columnCount + column] = 10.5f;
+			zs[columnCount + column] = (origin.z + z) * detailFrequency;
+		}
+	}
+	heightNoise.sample(xs, ys, zs, columnCount * 2, heightSamples);
+
+	int heights[columnCount];
+	int highest = INT_MIN;
+	for (int column = 0; column < columnCount; column++) {
+		heights[column] = toSurfaceHeight(heightSamples[column], heightSamples[columnCount + column]);
+		highest = std::max(highest, heights[column]);
+	}
+
+	// Chunks completely above the surface are air, no need to sample the 3D fields.
+	if (origin.y > highest) {
+		std::fill(ids, ids + Chunk::blockCount, AIR_BLOCK_ID);
+		return;
+	}
+
+	// The 3D fields are sampled for the whole chunk at once, in block storage order.
+	float caveA[Chunk::blockCount];
+	float caveB[Chunk::blockCount];
+	float ore[Chunk::blockCount];
+	for (int index = 0; index < Chunk::blockCount; index++) {
+		glm::ivec3 world = origin + Chunk::toLocalPosition(index);
+		xs[index] = world.x * caveFrequency;
+		ys[index] = world.y * caveFrequency * 1.6f;	// Flatter caves, so they run more horizontally
+		zs[index] = world.z * caveFrequency;
+	}
+	caveNoiseA.sample(xs, ys, zs, Chunk::blockCount, caveA);
+	caveNoiseB.sample(zs, xs, ys, Chunk::blockCount, caveB);
+
+	for (int index = 0; index < Chunk::blockCount; index++) {
+		glm::ivec3 world = origin + Chunk::toLocalPosition(index);
+		xs[index] = world.x * oreFrequency + 0.37f;
+		ys[index] = world.y * oreFrequency + 0.71f;
+		zs[index] = world.z * oreFrequency + 0.13f;
+	}
+	oreNoise.sample(xs, ys, zs, Chunk::blockCount, ore);
+
+	for (int index = 0; index < Chunk::blockCount; index++) {
+		glm::ivec3 local = Chunk::toLocalPosition(index);
+		int y = origin.y + local.y;
+		int height = heights[local.x + local.z * size];
+		BlockType type;
+
+		// Air above the surface, and bedrock at world y = 0 which caves never cut through.
+		if (y > height) {
+			ids[index] = AIR_BLOCK_ID;
+			continue;
+		}
+		if (y == 0) {
+			ids[index] = blockIdFromType(BlockType::Bedrock);
+			continue;
+		}
+		if (std::abs(caveA[index]) < caveWidth && std::abs(caveB[index]) < caveWidth) {
+			ids[index] = AIR_BLOCK_ID;
+			continue;
+		}
+
+		// Grass on top, a few layers of dirt and then rock with veins of ore. Diamonds only show up deep down.
+		if (y == height)
+			type = BlockType::Grass;
+		else if (y >= height - 2)
+			type = BlockType::Dirt;
+		else if (ore[index] > 0.55f && y <= 3)
+			type = BlockType::DiamondOre;
+		else if (ore[index] > 0.45f)
+			type = y <= 3 ? BlockType::IronOre : BlockType::CoalOre;
+		else if (ore[index] < -0.5f)
+			type = BlockType::Gravel;
+		else
+			type = BlockType::Rock;
+
+		ids[index] = blockIdFromType(type);
+	}
+}
@@ -0,0 +1,53 @@
+/*
+* TerrainGenerator - Created: 16-10-2026
+* Generates the blocks of chunks that were never saved. A generator has to return the same blocks for the same
+* chunk every time, chunks that are unloaded without changes are generated again when they come back.
+* Generation runs on the job pool, so generators may not touch the game and have to be safe to call from several threads.
+*/
+#pragma once
+
+#include <atomic>
+#include <cstdint>
+#include "Chunk.hpp"
+#include "Noise.hpp"
+
+
+
+class TerrainGenerator {
+public:
+	virtual ~TerrainGenerator() {}
+
+	// Fills ids with the blocks of the chunk at chunk coordinates, indexed like Chunk::toIndex.
+	virtual void generate(glm::ivec3 chunkPosition, BlockId* ids) const = 0;
+
+	// World y of the highest block in the column at world x, z, used to place the player on the ground.
+	virtual int getSurfaceHeight(int x, int z) const = 0;
+};
+
+
+// Rolling hills from 2D noise, with caves carved out by two 3D noise fields and ore veins and gravel pockets from a third.
+// Everything is derived from the seed, so a world looks the same every time it is generated with that seed.
+class NoiseTerrainGenerator : public TerrainGenerator {
+public:
+	explicit NoiseTerrainGenerator(uint32_t seed);
+
+	void generate(glm::ivec3 chunkPosition, BlockId* ids) const override;
+	int getSurfaceHeight(int x, int z) const override;
+
+	const static int baseHeight = 8;		// Average world y of the surface
+	const static int heightVariation = 5;	// How far the surface moves up and down around baseHeight
+private:
+	static int toSurfaceHeight(float coarse, float detail);	// Combines the two octaves of height noise into a world y
+
+	Noise heightNoise;
+	Noise caveNoiseA;
+	Noise caveNoiseB;
+	Noise oreNoise;
+};
+
+
+// Generated blocks of a chunk, filled on the job pool and picked up by the chunk on the main thread.
+struct ChunkGenerateTask {
+	BlockId blocks[Chunk::blockCount];
+	std::atomic<bool> done{ false };	// Raised by the job once blocks is filled in
+};
@@ -0,0 +1,68 @@
+/*
+* VoxelRaycast - Created: 16-10-2026
+* Walks a ray through the block grid one cell at a time (Amanatides & Woo), visiting every block the ray touches in order.
+* It needs no colliders and allocates nothing, the caller decides which blocks are solid. As long as that lookup is safe
+* on the calling thread, for example on a snapshot of the blocks, rays can be cast from worker threads too.
+*/
+#pragma once
+
+#include <cmath>
+#include <limits>
+#include <glm/glm.hpp>
+
+
+
+struct VoxelRayHit {
+	bool hit = false;
+	glm::ivec3 block;		// World coordinates of the solid block the ray hit
+	glm::ivec3 normal;		// Normal of the face the ray entered through, zero when the ray started inside the block
+	glm::ivec3 adjacent;	// The cell in front of that face, where a placed block would go
+	float distance = 0;		// Distance along the ray to the face that was hit
+};
+
+
+// Casts a ray from origin along the normalized direction, up to maxDistance. isSolid(glm::ivec3) is asked for every cell the ray
+// passes through and the first solid one is returned. Blocks are centered on their coordinates, so cell i spans from i - 0.5 to i + 0.5.
+template <typename IsSolid>
+VoxelRayHit castVoxelRay(glm::vec3 origin, glm::vec3 direction, float maxDistance, IsSolid isSolid) {
+	const float infinity = std::numeric_limits<float>::infinity();
+
+	// Move the grid so cells run from i to i + 1, then the cell of a point is its floor.
+	glm::vec3 start = origin + 0.5f;
+	glm::ivec3 cell(std::floor(start.x), std::floor(start.y), std::floor(start.z));
+
+	// Per axis: which way the ray steps, how far along the ray one cell is, and how far the next cell border is.
+	glm::ivec3 step;
+	glm::vec3 delta;
+	glm::vec3 next;
+	for (int axis = 0; axis < 3; axis++) {
+		step[axis] = direction[axis] > 0 ? 1 : (direction[axis] < 0 ? -1 : 0);
+		delta[axis] = step[axis] != 0 ? std::abs(1.0f / direction[axis]) : infinity;
+		float border = step[axis] > 0 ? cell[axis] + 1 - start[axis] : start[axis] - cell[axis];
+		next[axis] = step[axis] != 0 ? border * delta[axis] : infinity;
+	}
+
+	VoxelRayHit result;
+	glm::ivec3 normal(0);
+	float distance = 0;
+	while (distance <= maxDistance) {
+		if (isSolid(cell)) {
+			result.hit = true;
+			result.block = cell;
+			result.normal = normal;
+			result.adjacent = cell + normal;
+			result.distance = distance;
+			return result;
+		}
+
+		// Step into the neighbouring cell whose border is closest along the ray.
+		int axis = next.x < next.y ? (next.x < next.z ? 0 : 2) : (next.y < next.z ? 1 : 2);
+		distance = next[axis];
+		cell[axis] += step[axis];
+		next[axis] += delta[axis];
+		normal = glm::ivec3(0);
+		normal[axis] = -step[axis];
+	}
+
+	return result;
+}
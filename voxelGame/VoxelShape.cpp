@@ -0,0 +1,101 @@
+#include "VoxelShape.hpp"
+#include <algorithm>
+#include <cmath>
+#include <BulletCollision/CollisionShapes/btTriangleCallback.h>
+#include "Chunk.hpp"
+#include "World.hpp"
+
+
+// Normals of the six faces of a block, in the same order as the chunk meshes use them.
+static const int faceDirections[6][3] = {
+	{ -1, 0, 0 }, { 1, 0, 0 },
+	{ 0, -1, 0 }, { 0, 1, 0 },
+	{ 0, 0, -1 }, { 0, 0, 1 }
+};
+
+
+VoxelShape::VoxelShape(Chunk* chunk)
+	: chunk(chunk), localScaling(1, 1, 1) {
+	m_shapeType = CUSTOM_CONCAVE_SHAPE_TYPE;
+}
+
+
+void VoxelShape::processAllTriangles(btTriangleCallback* callback, const btVector3& aabbMin, const btVector3& aabbMax) const {
+	const int size = Chunk::chunkSize;
+
+	// The blocks whose box overlaps the query box, a block spans half a unit around its local position.
+	int minimum[3];
+	int maximum[3];
+	for (int axis = 0; axis < 3; axis++) {
+		minimum[axis] = std::max(0, (int)std::floor(aabbMin[axis] + 0.5f));
+		maximum[axis] = std::min(size - 1, (int)std::floor(aabbMax[axis] + 0.5f));
+		if (minimum[axis] > maximum[axis])
+			return;
+	}
+
+	// Faces on the edge of the chunk are hidden by the blocks of the neighbouring chunk, looked up once per query.
+	glm::ivec3 chunkPosition = chunk->getChunkPosition();
+	std::shared_ptr<Chunk> neighbours[6];
+	for (int face = 0; face < 6; face++) {
+		neighbours[face] = chunk->getWorld()->getChunk(chunkPosition.x + faceDirections[face][0], chunkPosition.y + faceDirections[face][1], chunkPosition.z + faceDirections[face][2]);
+	}
+
+	for (int y = minimum[1]; y <= maximum[1]; y++) {
+		for (int z = minimum[2]; z <= maximum[2]; z++) {
+			for (int x = minimum[0]; x <= maximum[0]; x++) {
+				if (chunk->getBlockId(x, y, z) == AIR_BLOCK_ID)
+					continue;
+
+				for (int face = 0; face < 6; face++) {
+					// Only faces towards air can be touched, the others are inside the ground.
+					int n[3] = { x + faceDirections[face][0], y + faceDirections[face][1], z + faceDirections[face][2] };
+					BlockId neighbour;
+					if (n[0] >= 0 && n[0] < size && n[1] >= 0 && n[1] < size && n[2] >= 0 && n[2] < size)
+						neighbour = chunk->getBlockId(n[0], n[1], n[2]);
+					else if (neighbours[face] != nullptr && !neighbours[face]->isGenerating())
+						neighbour = neighbours[face]->getBlockId((n[0] + size) % size, (n[1] + size) % size, (n[2] + size) % size);
+					else
+						neighbour = AIR_BLOCK_ID;
+
+					if (neighbour != AIR_BLOCK_ID)
+						continue;
+
+					// The face is the square half a unit from the block center along the normal, split into two triangles.
+					int axis = face / 2;
+					int uAxis = (axis + 1) % 3;
+					int vAxis = (axis + 2) % 3;
+					btVector3 corners[4];
+					for (int i = 0; i < 4; i++) {
+						corners[i] = btVector3(btScalar(x), btScalar(y), btScalar(z));
+						corners[i][axis] += faceDirections[face][axis] * 0.5f;
+						corners[i][uAxis] += (i == 1 || i == 2) ? 0.5f : -0.5f;
+						corners[i][vAxis] += (i >= 2) ? 0.5f : -0.5f;
+					}
+
+					int blockIndex = Chunk::toIndex(x, y, z);
+					btVector3 first[3] = { corners[0], corners[1], corners[2] };
+					btVector3 second[3] = { corners[0], corners[2], corners[3] };
+					callback->processTriangle(first, blockIndex, face * 2);
+					callback->processTriangle(second, blockIndex, face * 2 + 1);
+				}
+			}
+		}
+	}
+}
+
+
+void VoxelShape::getAabb(const btTransform& t, btVector3& aabbMin, btVector3& aabbMax) const {
+	btVector3 localMin(-0.5f, -0.5f, -0.5f);
+	btVector3 localMax(Chunk::chunkSize - 0.5f, Chunk::chunkSize - 0.5f, Chunk::chunkSize - 0.5f);
+	btTransformAabb(localMin, localMax, getMargin(), t, aabbMin, aabbMax);
+}
+
+
+void VoxelShape::calculateLocalInertia(btScalar mass, btVector3& inertia) const {
+	inertia.setValue(0, 0, 0);
+}
+
+
+void VoxelShape::setLocalScaling(const btVector3& scaling) {
+	localScaling = scaling;
+}
@@ -0,0 +1,30 @@
+/*
+* VoxelShape - Created: 16-10-2026
+* A Bullet collision shape for a whole chunk, read directly from the blocks of the chunk.
+* Bullet asks concave shapes for the triangles inside a box, the shape answers with the faces of the active blocks in it
+* that border air. Nothing is stored per block, so changing a block changes the collision right away.
+*/
+#pragma once
+
+#include <btBulletDynamicsCommon.h>
+
+
+
+class Chunk;
+ATTRIBUTE_ALIGNED16(class) VoxelShape : public btConcaveShape {
+public:
+	BT_DECLARE_ALIGNED_ALLOCATOR();
+
+	explicit VoxelShape(Chunk* chunk);
+
+	void processAllTriangles(btTriangleCallback* callback, const btVector3& aabbMin, const btVector3& aabbMax) const override;
+
+	void getAabb(const btTransform& t, btVector3& aabbMin, btVector3& aabbMax) const override;
+	void calculateLocalInertia(btScalar mass, btVector3& inertia) const override;	// The shape is only used for static bodies, there is no inertia
+	void setLocalScaling(const btVector3& scaling) override;		// Only stored, the shape always has the size of a chunk
+	const btVector3& getLocalScaling() const override { return localScaling; }
+	const char* getName() const override { return "VOXEL"; }
+private:
+	Chunk* chunk;				// Chunk whose blocks are the shape, the coordinates of the shape are local to the chunk
+	btVector3 localScaling;
+};
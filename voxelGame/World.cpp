@@ -0,0 +1,146 @@
+#include "World.hpp"
+
+using namespace glm;
+
+
+World::World(JobPool* jobPool)
+	: jobPool(jobPool) {
+}
+
+
+void World::flagNeighbourChunksForRecalculate(glm::ivec3 position) {
+	// Neighbours may have shown faces towards this chunk while it was missing, they have to be meshed again.
+	const ivec3 directions[6] = { ivec3(-1, 0, 0), ivec3(1, 0, 0), ivec3(0, -1, 0), ivec3(0, 1, 0), ivec3(0, 0, -1), ivec3(0, 0, 1) };
+	for (int i = 0; i < 6; i++) {
+		auto neighbour = getChunk(position.x + directions[i].x, position.y + directions[i].y, position.z + directions[i].z);
+		if (neighbour != nullptr)
+			neighbour->flagRecalculateMesh();
+	}
+}
+
+
+// # TODO rename function
+Block World::locationToBlock(int x, int y, int z, bool ghostInspect) {
+	// Determine the chunk coordinates, and local block coordinates.
+	ivec3 blockPos = Chunk::toLocalCoordinates(ivec3(x, y, z));
+	ivec3 chunkPos = Chunk::toChunkCoordinates(ivec3(x, y, z));
+
+	// Get a pointer to the chunk we want to access.
+	auto chunk = getChunk(chunkPos.x, chunkPos.y, chunkPos.z);
+
+	// If we tried to get a chunk which does not exist, we can already return and don't need to do anything else.
+	// Chunks still being generated are left alone too, their blocks would be overwritten by the generator.
+	if (chunk == nullptr || chunk->isGenerating())
+		return Block();
+
+	// If ghost mode is not activated, changes can occur to this block.
+	// Thus we should notify surrounding chunks to recalculate if necessary.
+	// And ourself
+	if (!ghostInspect) {
+		flagNeighboursForRecalculateIfNecessary(x, y, z);
+	}
+
+	// Return the actual block that was requested;
+	return chunk->getBlock(blockPos.x, blockPos.y, blockPos.z);
+}
+
+
+// # TODO rename function
+void World::flagNeighboursForRecalculateIfNecessary(int x,  int y, int z) {
+	ivec3 blockPos = Chunk::toLocalCoordinates(ivec3(x, y, z));
+	ivec3 chunkPos = Chunk::toChunkCoordinates(ivec3(x, y, z));
+
+	// Check if we need to update chunk left.
+	if (blockPos.x == 0) {
+		auto neighbour = getChunk(chunkPos.x - 1, chunkPos.y, chunkPos.z);
+
+		if (neighbour != nullptr) {
+			neighbour->flagBlockChanged(blockPos + ivec3(Chunk::chunkSize, 0, 0));
+		}
+	}
+	// Check if we need to update chunk right.
+	else if (blockPos.x >= Chunk::chunkSize - 1) {
+		auto neighbour = getChunk(chunkPos.x + 1, chunkPos.y, chunkPos.z);
+
+		if (neighbour != nullptr) {
+			neighbour->flagBlockChanged(blockPos - ivec3(Chunk::chunkSize, 0, 0));
+		}
+	}
+
+	// Check if we need to update chunk below.
+	if (blockPos.y == 0) {
+		auto neighbour = getChunk(chunkPos.x, chunkPos.y - 1, chunkPos.z);
+
+		if (neighbour != nullptr) {
+			neighbour->flagBlockChanged(blockPos + ivec3(0, Chunk::chunkSize, 0));
+		}
+	}
+	// Check if we need to update chunk above.
+	else if (blockPos.y >= Chunk::chunkSize - 1) {
+		auto neighbour = getChunk(chunkPos.x, chunkPos.y + 1, chunkPos.z);
+
+		if (neighbour != nullptr) {
+			neighbour->flagBlockChanged(blockPos - ivec3(0, Chunk::chunkSize, 0));
+		}
+	}
+
+
+	// Check if we need to update chunk in front.
+	if (blockPos.z == 0) {
+		auto neighbour = getChunk(chunkPos.x, chunkPos.y, chunkPos.z - 1);
+
+		if (neighbour != nullptr) {
+			neighbour->flagBlockChanged(blockPos + ivec3(0, 0, Chunk::chunkSize));
+		}
+	}
+	// Check if we need to update chunk in behind.
+	else if (blockPos.z >= Chunk::chunkSize - 1) {
+		auto neighbour = getChunk(chunkPos.x, chunkPos.y, chunkPos.z + 1);
+
+		if (neighbour != nullptr) {
+			neighbour->flagBlockChanged(blockPos - ivec3(0, 0, Chunk::chunkSize));
+		}
+	}
+
+	// We always need to update this chunk
+	auto chunk = getChunk(chunkPos.x, chunkPos.y, chunkPos.z);
+
+	if(chunk != nullptr)
+		chunk->flagBlockChanged(blockPos);
+}
+
+
+VoxelRayHit World::castBlockRay(glm::vec3 origin, glm::vec3 direction, float maxDistance) {
+	// Consecutive cells are mostly in the same chunk, so the chunk is only looked up again when the ray leaves it.
+	bool looked = false;
+	ivec3 chunkPosition;
+	Chunk* chunk = nullptr;
+
+	return castVoxelRay(origin, direction, maxDistance, [&](ivec3 cell) {
+		ivec3 cellChunk = Chunk::toChunkCoordinates(cell);
+		if (!looked || cellChunk != chunkPosition) {
+			auto found = chunks.find(cellChunk);
+			chunk = found != chunks.end() && !found->second->isGenerating() ? found->second.get() : nullptr;
+			chunkPosition = cellChunk;
+			looked = true;
+		}
+
+		if (chunk == nullptr)
+			return false;
+
+		ivec3 local = cell - cellChunk * Chunk::chunkSize;
+		return chunk->getBlockId(local.x, local.y, local.z) != AIR_BLOCK_ID;
+	});
+}
+
+
+std::shared_ptr<Chunk> World::getChunk(int x, int y, int z) {
+	// If the chunk is not loaded, return null pointer
+	auto chunk = chunks.find(ivec3(x, y, z));
+	if (chunk == chunks.end()) {
+		return nullptr;
+	}
+
+	// Otherwise, we can just return the chunk requested
+	return chunk->second;
+}
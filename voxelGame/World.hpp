@@ -0,0 +1,100 @@
+/*
+* World - Created: 16-10-2026
+* Owns the loaded chunks and answers questions about blocks across chunk edges. Chunks and blocks reach everything
+* outside of themselves through the world they belong to, never through the game. Rendering, physics and effects are
+* optional hooks, so a world can also run without a window, for example in a benchmark or on a server.
+*/
+#pragma once
+
+#include <memory>
+#include <unordered_map>
+#include <vector>
+#include <glm/glm.hpp>
+#include "Chunk.hpp"
+#include "Block.hpp"
+#include "JobPool.hpp"
+#include "TerrainGenerator.hpp"
+#include "VoxelRaycast.hpp"
+
+
+
+// Receives the meshes of the chunks, see ChunkArena.
+class ChunkRenderer {
+public:
+	virtual ~ChunkRenderer() {}
+
+	// Stores the vertices of a chunk mesh and returns the first vertex, quads are four vertices each.
+	virtual int allocate(glm::ivec3 chunkPosition, const std::vector<glm::u8vec4>& positions, const std::vector<glm::u8vec4>& tiles) = 0;
+	// Overwrites vertices inside an allocation.
+	virtual void update(int firstVertex, const std::vector<glm::u8vec4>& positions, const std::vector<glm::u8vec4>& tiles) = 0;
+	virtual void release(int firstVertex) = 0;					// Drops an allocation
+	virtual void addDraw(int firstVertex, int quadCount) = 0;	// Queues quads of an allocation for the next draw
+};
+
+
+// Simulates the colliders of the chunks, see Physics.
+class WorldPhysics {
+public:
+	virtual ~WorldPhysics() {}
+
+	virtual void addRigidBody(btRigidBody* rigidbody) = 0;
+	virtual void removeRigidBody(btRigidBody* rigidbody) = 0;
+};
+
+
+// Told about changes in the world that show outside of it.
+class WorldListener {
+public:
+	virtual ~WorldListener() {}
+
+	virtual void onBlockRemoved(glm::vec3 position) = 0;	// A block at world position was turned into air
+};
+
+
+class World {
+public:
+	explicit World(JobPool* jobPool);	// Chunks are generated and meshed on jobPool
+
+	// Pass in a world block location and it flags the mesh segments around that block for remeshing.
+	// Furthermore, it flags neighbouring chunks if the said block is on a chunk edge.
+	void flagNeighboursForRecalculateIfNecessary(int x, int y, int z);
+
+	// Flags the six chunks around the chunk at chunk coordinates position, after its blocks were loaded or generated.
+	void flagNeighbourChunksForRecalculate(glm::ivec3 position);
+
+	// Pass in a world position and the function returns the block on that location, which is invalid when there is no chunk there.
+	// When ghostInspect is set to true no mesh recalculation flag will be raised.
+	// Set it to false and chunks and possible neighbours will be recalculated when necessary.
+	Block locationToBlock(int x, int y, int z, bool ghostInspect);
+
+	// Walks a ray from origin along the normalized direction through the loaded blocks, and returns the first active block within maxDistance.
+	// Chunks that are not loaded or still being generated count as air.
+	VoxelRayHit castBlockRay(glm::vec3 origin, glm::vec3 direction, float maxDistance);
+
+	std::shared_ptr<Chunk> getChunk(int x, int y, int z);	// Returns a chunk at chunk coordinates x, y, z, or null when it is not loaded
+	// All loaded chunks by chunk coordinates. Whoever streams the world adds and removes them here.
+	std::unordered_map<glm::ivec3, std::shared_ptr<Chunk>, ChunkPositionHash>& getChunks() { return chunks; }
+
+	JobPool* getJobPool() { return jobPool; }
+	std::shared_ptr<TerrainGenerator> getTerrainGenerator() { return terrainGenerator; }	// Generator for chunks that were never saved
+	void setTerrainGenerator(std::shared_ptr<TerrainGenerator> generator) { terrainGenerator = generator; }
+	bool isGreedyMeshing() { return greedyMeshing; }				// Whether chunk meshes merge neighbouring faces
+	void setGreedyMeshing(bool greedy) { greedyMeshing = greedy; }
+
+	// Optional hooks, null when the world runs without them. Without a renderer chunks still mesh but keep nothing.
+	ChunkRenderer* getRenderer() { return renderer; }
+	void setRenderer(ChunkRenderer* renderer) { this->renderer = renderer; }
+	WorldPhysics* getPhysics() { return physics; }
+	void setPhysics(WorldPhysics* physics) { this->physics = physics; }
+	WorldListener* getListener() { return listener; }
+	void setListener(WorldListener* listener) { this->listener = listener; }
+private:
+	std::unordered_map<glm::ivec3, std::shared_ptr<Chunk>, ChunkPositionHash> chunks;
+	JobPool* jobPool;
+	std::shared_ptr<TerrainGenerator> terrainGenerator;
+	bool greedyMeshing = true;
+
+	ChunkRenderer* renderer = nullptr;
+	WorldPhysics* physics = nullptr;
+	WorldListener* listener = nullptr;
+};
@@ -0,0 +1,175 @@
+#include "WorldStorage.hpp"
+#include <fstream>
+#include <random>
+
+#ifdef _WIN32
+#include <direct.h>
+#else
+#include <sys/stat.h>
+#endif
+
+
+// Rounds towards negative infinity, so negative chunk coordinates end up in the region left of zero.
+static int floorDivide(int value, int divisor) {
+	return value >= 0 ? value / divisor : -((-value + divisor - 1) / divisor);
+}
+
+
+WorldStorage::WorldStorage(const std::string& directory)
+	: directory(directory), writtenCount(0) {
+	// An existing directory is fine, the error is ignored.
+#ifdef _WIN32
+	_mkdir(directory.c_str());
+#else
+	mkdir(directory.c_str(), 0755);
+#endif
+
+	writer = std::thread(&WorldStorage::writerLoop, this);
+}
+
+
+WorldStorage::~WorldStorage() {
+	{
+		std::lock_guard<std::mutex> lock(queueMutex);
+		running = false;
+	}
+	queueChanged.notify_all();
+	writer.join();
+}
+
+
+bool WorldStorage::load(glm::ivec3 chunkPosition, BlockStorage& blocks) {
+	glm::ivec3 local = toRegionLocal(chunkPosition);
+	if (!RegionFile::isInRegion(local))
+		return false;
+
+	std::vector<uint8_t> payload;
+	bool queued = false;
+	{
+		std::lock_guard<std::mutex> lock(queueMutex);
+		auto pending = pendingWrites.find(chunkPosition);
+		if (pending != pendingWrites.end()) {
+			payload = pending->second;
+			queued = true;
+		} else if (writing && writingPosition == chunkPosition) {
+			payload = writingPayload;
+			queued = true;
+		}
+	}
+
+	if (!queued) {
+		RegionFile* region = getRegion(toRegionCoordinates(chunkPosition), false);
+		if (region == nullptr || !region->read(local, payload))
+			return false;
+	}
+
+	return blocks.deserialize(payload.data(), payload.size());
+}
+
+
+void WorldStorage::save(glm::ivec3 chunkPosition, const BlockStorage& blocks) {
+	if (!RegionFile::isInRegion(toRegionLocal(chunkPosition)))
+		return;
+
+	std::vector<uint8_t> payload;
+	blocks.serialize(payload);
+
+	{
+		std::lock_guard<std::mutex> lock(queueMutex);
+		pendingWrites[chunkPosition] = std::move(payload);
+	}
+	queueChanged.notify_one();
+}
+
+
+void WorldStorage::flush() {
+	std::unique_lock<std::mutex> lock(queueMutex);
+	queueChanged.wait(lock, [&] { return pendingWrites.empty() && !writing; });
+}
+
+
+uint32_t WorldStorage::loadSeed() {
+	std::string path = directory + "/seed.txt";
+
+	uint32_t seed;
+	std::ifstream in(path);
+	if (in >> seed)
+		return seed;
+
+	// The seed has to stay the same for the world, or unsaved chunks would no longer fit the saved ones.
+	seed = std::random_device()();
+	std::ofstream out(path);
+	out << seed << std::endl;
+	return seed;
+}
+
+
+int WorldStorage::getPendingWriteCount() {
+	std::lock_guard<std::mutex> lock(queueMutex);
+	return (int)pendingWrites.size() + (writing ? 1 : 0);
+}
+
+
+glm::ivec3 WorldStorage::toRegionCoordinates(glm::ivec3 chunkPosition) {
+	return glm::ivec3(floorDivide(chunkPosition.x, RegionFile::regionSize), 0, floorDivide(chunkPosition.z, RegionFile::regionSize));
+}
+
+
+glm::ivec3 WorldStorage::toRegionLocal(glm::ivec3 chunkPosition) {
+	glm::ivec3 region = toRegionCoordinates(chunkPosition);
+	return glm::ivec3(chunkPosition.x - region.x * RegionFile::regionSize, chunkPosition.y, chunkPosition.z - region.z * RegionFile::regionSize);
+}
+
+
+RegionFile* WorldStorage::getRegion(glm::ivec3 regionPosition, bool create) {
+	std::lock_guard<std::mutex> lock(regionsMutex);
+
+	// A region without a file is remembered as null, so streaming through unsaved land does not try to open it for every chunk.
+	// The writer replaces it when it creates the file.
+	auto region = regions.find(regionPosition);
+	if (region != regions.end() && (region->second != nullptr || !create))
+		return region->second.get();
+
+	// Regions are named after their position, like world/r.-1.0.region
+	std::string path = directory + "/r." + std::to_string(regionPosition.x) + "." + std::to_string(regionPosition.z) + ".region";
+	std::unique_ptr<RegionFile> file(new RegionFile(path, create));
+	if (!file->isOpen()) {
+		regions[regionPosition] = nullptr;
+		return nullptr;
+	}
+
+	RegionFile* result = file.get();
+	regions[regionPosition] = std::move(file);
+	return result;
+}
+
+
+void WorldStorage::writerLoop() {
+	while (true) {
+		{
+			std::unique_lock<std::mutex> lock(queueMutex);
+			queueChanged.wait(lock, [&] { return !running || !pendingWrites.empty(); });
+
+			// When stopping, everything that is still queued is written first.
+			if (pendingWrites.empty())
+				return;
+
+			auto next = pendingWrites.begin();
+			writingPosition = next->first;
+			writingPayload = std::move(next->second);
+			pendingWrites.erase(next);
+			writing = true;
+		}
+
+		// Only the writer changes the writing chunk, so it can be used without holding the lock.
+		RegionFile* region = getRegion(toRegionCoordinates(writingPosition), true);
+		if (region != nullptr && region->write(toRegionLocal(writingPosition), writingPayload))
+			writtenCount++;
+
+		{
+			std::lock_guard<std::mutex> lock(queueMutex);
+			writing = false;
+		}
+		queueChanged.notify_all();
+	}
+}
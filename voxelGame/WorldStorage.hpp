@@ -0,0 +1,64 @@
+/*
+* WorldStorage - Created: 16-10-2026
+* Saves and loads the blocks of chunks in region files inside a world directory.
+* Saving only serializes the blocks on the calling thread, the disk writes happen on a writer thread so the frame never waits on them.
+*/
+#pragma once
+
+#include <atomic>
+#include <condition_variable>
+#include <memory>
+#include <mutex>
+#include <string>
+#include <thread>
+#include <unordered_map>
+#include <vector>
+#include "Chunk.hpp"
+#include "RegionFile.hpp"
+
+
+
+class WorldStorage {
+public:
+	explicit WorldStorage(const std::string& directory);	// Creates the directory when needed and starts the writer thread.
+	~WorldStorage();										// Writes all queued chunks, then stops the writer.
+
+	// Loads the saved blocks of the chunk at chunk coordinates into blocks. Returns false when the chunk was never saved.
+	bool load(glm::ivec3 chunkPosition, BlockStorage& blocks);
+
+	// Queues the blocks of the chunk at chunk coordinates for writing. Chunks outside the vertical range of a region are not saved.
+	void save(glm::ivec3 chunkPosition, const BlockStorage& blocks);
+
+	void flush();	// Blocks until all queued chunks are written
+
+	uint32_t loadSeed();	// Returns the terrain seed of the world, a new world picks a random seed and stores it.
+
+	int getPendingWriteCount();
+	int getWrittenCount() { return writtenCount; }
+private:
+	// Region that holds a chunk, and the position of the chunk inside it.
+	static glm::ivec3 toRegionCoordinates(glm::ivec3 chunkPosition);
+	static glm::ivec3 toRegionLocal(glm::ivec3 chunkPosition);
+
+	RegionFile* getRegion(glm::ivec3 regionPosition, bool create);	// Opens the region file on first use, null when it does not exist and create is not set
+	void writerLoop();
+
+	std::string directory;
+
+	std::mutex regionsMutex;
+	std::unordered_map<glm::ivec3, std::unique_ptr<RegionFile>, ChunkPositionHash> regions;	// Null for regions that have no file yet
+
+	// Serialized chunks waiting for the writer. A chunk saved again before it was written only keeps its newest blocks.
+	// Loads look here first, so a chunk that streams back in before it reached the disk still has its changes.
+	std::mutex queueMutex;
+	std::condition_variable queueChanged;
+	std::unordered_map<glm::ivec3, std::vector<uint8_t>, ChunkPositionHash> pendingWrites;
+	// The chunk the writer took from the queue, it is still read from here until it is on disk.
+	bool writing = false;
+	glm::ivec3 writingPosition;
+	std::vector<uint8_t> writingPayload;
+	bool running = true;
+
+	std::atomic<int> writtenCount;
+	std::thread writer;
+};
@@ -0,0 +1,135 @@
+/*
+* RaycastBench - Created: 16-10-2026
+* Compares picking blocks with the voxel grid raycast against the Bullet rayTest over one box collider per block,
+* which is how blocks used to be picked. Both cast the same rays over the same blocks.
+* Usage: Raycast-Bench [ray count]
+*/
+#include <chrono>
+#include <cstdlib>
+#include <iostream>
+#include <random>
+#include <vector>
+#include <btBulletDynamicsCommon.h>
+#include "../VoxelRaycast.hpp"
+
+using Clock = std::chrono::high_resolution_clock;
+
+const int sizeX = 64;
+const int sizeY = 24;
+const int sizeZ = 64;
+const float rayLength = 10.0f;	// Same range as the player has for mining
+
+
+static bool isInside(glm::ivec3 cell) {
+	return cell.x >= 0 && cell.x < sizeX && cell.y >= 0 && cell.y < sizeY && cell.z >= 0 && cell.z < sizeZ;
+}
+
+
+static int toIndex(glm::ivec3 cell) {
+	return cell.x + sizeX * (cell.z + sizeZ * cell.y);
+}
+
+
+int main(int argc, char** argv) {
+	int rayCount = argc > 1 ? atoi(argv[1]) : 200000;
+	std::mt19937 random(1234);
+
+	// Rolling hills with some holes dug into them.
+	std::vector<uint8_t> solid(sizeX * sizeY * sizeZ, 0);
+	std::vector<int> surface(sizeX * sizeZ);
+	for (int z = 0; z < sizeZ; z++) {
+		for (int x = 0; x < sizeX; x++) {
+			int height = 8 + (int)(4 * std::sin(x * 0.2f) * std::cos(z * 0.15f));
+			surface[x + z * sizeX] = height;
+			for (int y = 0; y <= height; y++) {
+				solid[toIndex(glm::ivec3(x, y, z))] = random() % 10 != 0 || y == 0;
+			}
+		}
+	}
+
+	// The Bullet world with a static box for every solid block, all sharing one shape.
+	btDefaultCollisionConfiguration configuration;
+	btCollisionDispatcher dispatcher(&configuration);
+	btDbvtBroadphase broadphase;
+	btCollisionWorld world(&dispatcher, &broadphase, &configuration);
+	btBoxShape blockShape(btVector3(0.5f, 0.5f, 0.5f));
+	std::vector<btCollisionObject*> objects;
+	for (int index = 0; index < (int)solid.size(); index++) {
+		if (!solid[index])
+			continue;
+
+		btTransform transform;
+		transform.setIdentity();
+		transform.setOrigin(btVector3(btScalar(index % sizeX), btScalar(index / (sizeX * sizeZ)), btScalar((index / sizeX) % sizeZ)));
+		btCollisionObject* object = new btCollisionObject();
+		object->setCollisionShape(&blockShape);
+		object->setWorldTransform(transform);
+		world.addCollisionObject(object);
+		objects.push_back(object);
+	}
+	world.updateAabbs();
+
+	// Rays start at eye height somewhere above the ground, and look around like a player would.
+	std::vector<glm::vec3> origins(rayCount);
+	std::vector<glm::vec3> directions(rayCount);
+	std::uniform_real_distribution<float> unit(0.0f, 1.0f);
+	for (int i = 0; i < rayCount; i++) {
+		float x = 8 + unit(random) * (sizeX - 16);
+		float z = 8 + unit(random) * (sizeZ - 16);
+		origins[i] = glm::vec3(x, surface[(int)x + (int)z * sizeX] + 1.7f, z);
+
+		float yaw = unit(random) * 6.2831853f;
+		float pitch = -1.2f + unit(random) * 1.6f;
+		directions[i] = glm::vec3(std::cos(pitch) * std::sin(yaw), std::sin(pitch), std::cos(pitch) * std::cos(yaw));
+	}
+
+	auto isSolid = [&](glm::ivec3 cell) { return isInside(cell) && solid[toIndex(cell)] != 0; };
+
+	// Grid raycast
+	std::vector<VoxelRayHit> gridHits(rayCount);
+	auto start = Clock::now();
+	for (int i = 0; i < rayCount; i++) {
+		gridHits[i] = castVoxelRay(origins[i], directions[i], rayLength, isSolid);
+	}
+	double gridSeconds = std::chrono::duration<double>(Clock::now() - start).count();
+
+	// Bullet raycast, with the hit point nudged into the block like the game used to do.
+	std::vector<glm::ivec3> bulletBlocks(rayCount);
+	std::vector<bool> bulletHit(rayCount);
+	start = Clock::now();
+	for (int i = 0; i < rayCount; i++) {
+		btVector3 from(origins[i].x, origins[i].y, origins[i].z);
+		btVector3 to = from + btVector3(directions[i].x, directions[i].y, directions[i].z) * rayLength;
+		btCollisionWorld::ClosestRayResultCallback result(from, to);
+		world.rayTest(from, to, result);
+
+		bulletHit[i] = result.hasHit();
+		if (bulletHit[i]) {
+			btVector3 hit = result.m_hitPointWorld + btVector3(0.501f, 0.501f, 0.501f) - result.m_hitNormalWorld * 0.2f;
+			bulletBlocks[i] = glm::ivec3((int)std::floor(hit.getX()), (int)std::floor(hit.getY()), (int)std::floor(hit.getZ()));
+		}
+	}
+	double bulletSeconds = std::chrono::duration<double>(Clock::now() - start).count();
+
+	// How often both agree on which block was picked.
+	int hits = 0;
+	int agreeing = 0;
+	for (int i = 0; i < rayCount; i++) {
+		if (gridHits[i].hit)
+			hits++;
+		if (gridHits[i].hit == bulletHit[i] && (!bulletHit[i] || gridHits[i].block == bulletBlocks[i]))
+			agreeing++;
+	}
+
+	std::cout << "Rays: " << rayCount << " over " << objects.size() << " blocks, " << hits << " hit" << std::endl;
+	std::cout << "Grid raycast: " << gridSeconds * 1e9 / rayCount << " ns/ray" << std::endl;
+	std::cout << "Bullet rayTest: " << bulletSeconds * 1e9 / rayCount << " ns/ray" << std::endl;
+	std::cout << "Speedup: " << bulletSeconds / gridSeconds << "x" << std::endl;
+	std::cout << "Same block picked: " << 100.0 * agreeing / rayCount << "%" << std::endl;
+
+	for (btCollisionObject* object : objects) {
+		world.removeCollisionObject(object);
+		delete object;
+	}
+	return 0;
+}
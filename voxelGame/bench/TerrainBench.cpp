@@ -0,0 +1,68 @@
+/*
+* TerrainBench - Created: 16-10-2026
+* Measures how many chunks per second the terrain generator produces, on one thread and on the job pool.
+* Usage: Terrain-Bench [chunk count] [seed]
+*/
+#include <chrono>
+#include <cstdlib>
+#include <cstring>
+#include <iostream>
+#include <vector>
+#include "../JobPool.hpp"
+#include "../TerrainGenerator.hpp"
+
+using Clock = std::chrono::high_resolution_clock;
+
+
+// Chunk coordinates of the i-th benchmarked chunk, walking a square of columns two chunks high like the game loads them.
+static glm::ivec3 chunkPositionFor(int i) {
+	const int side = 64;
+	int column = i / 2;
+	return glm::ivec3(column % side - side / 2, i % 2, column / side - side / 2);
+}
+
+
+int main(int argc, char** argv) {
+	int chunkCount = argc > 1 ? atoi(argv[1]) : 8192;
+	uint32_t seed = argc > 2 ? (uint32_t)strtoul(argv[2], nullptr, 10) : 1234;
+
+	NoiseTerrainGenerator generator(seed);
+	std::vector<BlockId> blocks((size_t)chunkCount * Chunk::blockCount);
+
+	std::cout << "Noise kernel: " << Noise::getInstructionSet() << std::endl;
+	std::cout << "Chunks: " << chunkCount << " of " << Chunk::blockCount << " blocks" << std::endl;
+
+	// One thread
+	auto start = Clock::now();
+	for (int i = 0; i < chunkCount; i++) {
+		generator.generate(chunkPositionFor(i), &blocks[(size_t)i * Chunk::blockCount]);
+	}
+	double singleSeconds = std::chrono::duration<double>(Clock::now() - start).count();
+	std::cout << "1 thread: " << chunkCount / singleSeconds << " chunks/s" << std::endl;
+
+	// The same chunks on the job pool, every chunk is its own job just like in the game.
+	std::vector<BlockId> pooledBlocks(blocks.size());
+	double pooledSeconds;
+	int threadCount;
+	{
+		JobPool pool(std::max(1, (int)std::thread::hardware_concurrency()));
+		threadCount = pool.getThreadCount();
+
+		start = Clock::now();
+		for (int i = 0; i < chunkCount; i++) {
+			BlockId* ids = &pooledBlocks[(size_t)i * Chunk::blockCount];
+			pool.submit([&generator, ids, i]() {
+				generator.generate(chunkPositionFor(i), ids);
+			});
+		}
+		pool.waitIdle();
+		pooledSeconds = std::chrono::duration<double>(Clock::now() - start).count();
+	}
+	std::cout << threadCount << " threads: " << chunkCount / pooledSeconds << " chunks/s, "
+		<< chunkCount / pooledSeconds / threadCount << " chunks/s per core" << std::endl;
+
+	// Generation has to be deterministic, whichever thread generated a chunk.
+	bool identical = memcmp(blocks.data(), pooledBlocks.data(), blocks.size()) == 0;
+	std::cout << "Deterministic: " << (identical ? "yes" : "NO") << std::endl;
+	return identical ? 0 : 1;
+}
@@ -0,0 +1,163 @@
+/*
+* VoxelBench - Created: 16-10-2026
+* Measures the voxel hot paths without a window, GL context or the game: building chunks from the terrain generator,
+* meshing them, looking up blocks by world coordinates and the memory a chunk takes. The chunks live in a World without
+* a renderer or physics, so the same code as in the game is measured. Runs fine on machines without a GPU.
+* The results are printed as a single JSON object, so they can be collected per commit.
+* Usage: Voxel-Bench [world side in chunks] [seed]
+*/
+#include <chrono>
+#include <cstdlib>
+#include <iostream>
+#include <memory>
+#include <random>
+#include <vector>
+#include "../BlockStorage.hpp"
+#include "../ChunkMesher.hpp"
+#include "../JobPool.hpp"
+#include "../TerrainGenerator.hpp"
+#include "../World.hpp"
+
+using Clock = std::chrono::high_resolution_clock;
+
+const int worldHeight = 2;			// Chunks stacked vertically, like in the game
+const double minimumSeconds = 0.5;	// Every measurement repeats until it ran at least this long
+
+
+// Runs pass until enough time passed for a stable number, and returns the seconds a single pass took.
+template<typename Pass>
+static double measure(Pass pass) {
+	int passes = 0;
+	auto start = Clock::now();
+	double seconds;
+	do {
+		pass();
+		passes++;
+		seconds = std::chrono::duration<double>(Clock::now() - start).count();
+	} while (seconds < minimumSeconds);
+	return seconds / passes;
+}
+
+
+// Looks up a block through the world like the game does, without flagging any chunks. Missing blocks are air.
+static BlockId lookup(World& world, glm::ivec3 position) {
+	Block block = world.locationToBlock(position.x, position.y, position.z, true);
+	return block.isValid() && block.isActive() ? blockIdFromType(block.getType()) : AIR_BLOCK_ID;
+}
+
+
+// Copies a chunk and the border of its neighbours for the mesher, like Chunk::snapshotBlocks.
+static void snapshot(World& world, glm::ivec3 chunkPosition, BlockId* padded) {
+	glm::ivec3 first = chunkPosition * Chunk::chunkSize;
+	for (int y = -1; y <= Chunk::chunkSize; y++) {
+		for (int z = -1; z <= Chunk::chunkSize; z++) {
+			for (int x = -1; x <= Chunk::chunkSize; x++) {
+				padded[ChunkMesher::toPaddedIndex(x, y, z)] = lookup(world, first + glm::ivec3(x, y, z));
+			}
+		}
+	}
+}
+
+
+int main(int argc, char** argv) {
+	int side = argc > 1 ? atoi(argv[1]) : 32;
+	uint32_t seed = argc > 2 ? (uint32_t)strtoul(argv[2], nullptr, 10) : 1234;
+
+	NoiseTerrainGenerator generator(seed);
+	std::vector<glm::ivec3> chunkPositions;
+	for (int z = 0; z < side; z++) {
+		for (int x = 0; x < side; x++) {
+			for (int y = 0; y < worldHeight; y++) {
+				chunkPositions.push_back(glm::ivec3(x - side / 2, y, z - side / 2));
+			}
+		}
+	}
+	int chunkCount = (int)chunkPositions.size();
+
+	// Chunk construction, creating a chunk with its collider and packing the generated terrain into it.
+	// The terrain is generated right here instead of on the job pool, so the time is not spent waiting for workers.
+	JobPool jobPool(1);
+	World world(&jobPool);
+	BlockId ids[Chunk::blockCount];
+	BlockStorage storage(Chunk::blockCount);
+	double constructSeconds = measure([&]() {
+		world.getChunks().clear();
+		for (auto& position : chunkPositions) {
+			auto chunk = std::make_shared<Chunk>(&world);
+			chunk->reset(glm::vec3(position * Chunk::chunkSize));
+			generator.generate(position, ids);
+			storage.pack(ids);
+			chunk->setBlocks(storage);
+			world.getChunks()[position] = chunk;
+		}
+	});
+
+	size_t blockBytes = 0;
+	for (auto& pair : world.getChunks()) {
+		blockBytes += pair.second->getBlockStorage().getMemoryUsage();
+	}
+
+	// Meshing, the snapshots are taken up front since the game takes those on the main thread before meshing on the job pool.
+	std::vector<BlockId> padded((size_t)chunkCount * ChunkMesher::paddedBlockCount);
+	for (int i = 0; i < chunkCount; i++) {
+		snapshot(world, chunkPositions[i], &padded[(size_t)i * ChunkMesher::paddedBlockCount]);
+	}
+
+	ChunkMeshData mesh;
+	size_t vertexCount[2] = { 0, 0 };
+	double meshSeconds[2];
+	for (int greedy = 0; greedy < 2; greedy++) {
+		meshSeconds[greedy] = measure([&]() {
+			vertexCount[greedy] = 0;
+			for (int i = 0; i < chunkCount; i++) {
+				mesh.clear();
+				ChunkMesher::calculateMesh(&padded[(size_t)i * ChunkMesher::paddedBlockCount], greedy != 0, mesh);
+				vertexCount[greedy] += mesh.positions.size();
+			}
+		});
+	}
+	size_t meshBytes = vertexCount[1] * (sizeof(glm::u8vec4) * 2);
+
+	// Block lookups at random places in the world. The ids are summed into a volatile, so the lookups cannot be optimized away.
+	const int lookupCount = 1 << 20;
+	std::mt19937 random(seed);
+	std::uniform_int_distribution<int> horizontal(-side / 2 * Chunk::chunkSize, (side - side / 2) * Chunk::chunkSize - 1);
+	std::uniform_int_distribution<int> vertical(0, worldHeight * Chunk::chunkSize - 1);
+	std::vector<glm::ivec3> lookupPositions(lookupCount);
+	for (auto& position : lookupPositions) {
+		position = glm::ivec3(horizontal(random), vertical(random), horizontal(random));
+	}
+
+	volatile uint64_t lookupSum = 0;
+	double lookupSeconds = measure([&]() {
+		uint64_t sum = 0;
+		for (auto& position : lookupPositions) {
+			sum += lookup(world, position);
+		}
+		lookupSum = sum;
+	});
+
+	// Summed over a single pass, so it only changes when the world or the lookup does, not with the speed of the machine.
+	uint64_t checksum = 0;
+	for (auto& position : lookupPositions) {
+		checksum += lookup(world, position);
+	}
+
+	std::cout << "{" << std::endl;
+	std::cout << "  \"chunkSize\": " << Chunk::chunkSize << "," << std::endl;
+	std::cout << "  \"chunks\": " << chunkCount << "," << std::endl;
+	std::cout << "  \"seed\": " << seed << "," << std::endl;
+	std::cout << "  \"noiseKernel\": \"" << Noise::getInstructionSet() << "\"," << std::endl;
+	std::cout << "  \"chunksConstructedPerSecond\": " << chunkCount / constructSeconds << "," << std::endl;
+	std::cout << "  \"greedyMeshVerticesPerSecond\": " << vertexCount[1] / meshSeconds[1] << "," << std::endl;
+	std::cout << "  \"greedyMeshChunksPerSecond\": " << chunkCount / meshSeconds[1] << "," << std::endl;
+	std::cout << "  \"naiveMeshVerticesPerSecond\": " << vertexCount[0] / meshSeconds[0] << "," << std::endl;
+	std::cout << "  \"naiveMeshChunksPerSecond\": " << chunkCount / meshSeconds[0] << "," << std::endl;
+	std::cout << "  \"lookupsPerSecond\": " << lookupCount / lookupSeconds << "," << std::endl;
+	std::cout << "  \"lookupChecksum\": " << checksum << "," << std::endl;
+	std::cout << "  \"blockBytesPerChunk\": " << blockBytes / (double)chunkCount << "," << std::endl;
+	std::cout << "  \"meshBytesPerChunk\": " << meshBytes / (double)chunkCount << "," << std::endl;
+	std::cout << "  \"uncompressedBytesPerChunk\": " << Chunk::blockCount * sizeof(BlockId) << std::endl;
+	std::cout << "}" << std::endl;
+	return 0;
+}